@@ -15,10 +15,12 @@
 	other possible instances of the same name.
 
 	Table of contents: () - functions [] - classes/structs/other
+		[PATH_VIEW]
 		[PATH]
 		(EXISTS)
 		(IS_DIRECTORY)
 		(IS_REGULAR_FILE)
+		(STATUS)
 		(CREATE_DIRECTORY)
 		(CREATE_DIRECTORIES)
 		(REMOVE)
@@ -26,9 +28,17 @@
 		(CURRENT_PATH)
 		[DIRECTORY_ENTRY]
 		[DIRECTORY_ITERATOR]
+		[DIRECTORY_READER]
+		[BYTE_SPAN]
+		[FILE_READER]
+		[FILE_WRITER]
+		[ATOMIC_WRITER]
+		[COMMIT_BATCH]
 		(COPY_FILE)
 		(COPY_DIRECTORY)
 		(COPY)
+		(REMOVE_ALL)
+		[MAPPED_FILE]
 
 */
 
@@ -41,17 +51,33 @@
 #include <cstring>
 #include <fstream>
 #include <cerrno>
+#include <utility>
+#include <cstdlib>
+#include <new>
+#include <climits>
+#include <algorithm>
+#include <unordered_set>
+#include <atomic>
 
 #if defined(_WIN32)
 	#define WIN32_LEAN_AND_MEAN
 	#include <windows.h>
 	#include <direct.h>						// _mkdir
 	#include <io.h>							// _access
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <malloc.h>						// _aligned_malloc
 	#define PATH_SEP '\\'
 #else
 	#include <sys/stat.h>
 	#include <unistd.h>
 	#include <dirent.h>
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/uio.h>					// preadv, pwritev
+	#if defined(__linux__)
+		#include <sys/sysmacros.h>			// makedev
+	#endif
 	#define PATH_SEP '/'
 #endif
 
@@ -63,47 +89,284 @@ namespace fs {
 		copy_options_overwrite_existing = 1 << 1
 	};
 
+	enum file_type {
+		file_type_none = 0,
+		file_type_not_found,
+		file_type_regular,
+		file_type_directory,
+		file_type_symlink,
+		file_type_other,
+		file_type_unknown
+	};
+
+	struct file_status {
+		file_type type;
+		unsigned perms;				// permission bits (mode & 07777)
+		unsigned long long size;
+		long long mtime;			// nanoseconds since the unix epoch
+		unsigned long long dev, ino;
+		unsigned long long nlink;
+		unsigned long long blocks;	// allocated bytes
+	};
+
+#if !defined(_WIN32)
+	inline void status_from_stat(const struct stat& st, file_status& out) {
+		if (S_ISREG(st.st_mode)) out.type = file_type_regular;
+		else if (S_ISDIR(st.st_mode)) out.type = file_type_directory;
+		else if (S_ISLNK(st.st_mode)) out.type = file_type_symlink;
+		else out.type = file_type_other;
+		out.perms = (unsigned)(st.st_mode & 07777);
+		out.size = (unsigned long long)st.st_size;
+	#if defined(__APPLE__)
+		out.mtime = (long long)st.st_mtimespec.tv_sec * 1000000000LL + st.st_mtimespec.tv_nsec;
+	#else
+		out.mtime = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+	#endif
+		out.dev = (unsigned long long)st.st_dev;
+		out.ino = (unsigned long long)st.st_ino;
+		out.nlink = (unsigned long long)st.st_nlink;
+		out.blocks = (unsigned long long)st.st_blocks * 512;
+	}
+
+	#if defined(__linux__) && defined(STATX_BASIC_STATS)
+	inline void status_from_statx(const struct statx& sx, file_status& out) {
+		unsigned mode = sx.stx_mode;
+		if (S_ISREG(mode)) out.type = file_type_regular;
+		else if (S_ISDIR(mode)) out.type = file_type_directory;
+		else if (S_ISLNK(mode)) out.type = file_type_symlink;
+		else out.type = file_type_other;
+		out.perms = mode & 07777;
+		out.size = sx.stx_size;
+		out.mtime = (long long)sx.stx_mtime.tv_sec * 1000000000LL + sx.stx_mtime.tv_nsec;
+		out.dev = (unsigned long long)makedev(sx.stx_dev_major, sx.stx_dev_minor);
+		out.ino = sx.stx_ino;
+		out.nlink = sx.stx_nlink;
+		out.blocks = sx.stx_blocks * 512;
+	}
+	#endif
+#endif
+
+// [PATH_VIEW]
+	// Non-owning view of a path or a part of one, the pre C++17 stand-in for
+	// std::string_view. Only valid as long as the string it points into.
+	class path_view {
+		const char* m_data;
+		size_t m_size;
+	public:
+		path_view() : m_data(""), m_size(0) {}
+		path_view(const char* s) : m_data(s), m_size(std::strlen(s)) {}
+		path_view(const char* s, size_t n) : m_data(s), m_size(n) {}
+		path_view(const std::string& s) : m_data(s.data()), m_size(s.size()) {}
+
+		const char* data() const { return m_data; }
+		size_t size() const { return m_size; }
+		bool empty() const { return m_size == 0; }
+		const char* begin() const { return m_data; }
+		const char* end() const { return m_data + m_size; }
+		char operator[](size_t i) const { return m_data[i]; }
+
+		std::string string() const { return std::string(m_data, m_size); }
+
+		bool operator==(path_view rhs) const { return m_size == rhs.m_size && std::memcmp(m_data, rhs.m_data, m_size) == 0; }
+		bool operator!=(path_view rhs) const { return !(*this == rhs); }
+		bool operator==(const char* rhs) const { return *this == path_view(rhs); }
+		bool operator!=(const char* rhs) const { return !(*this == path_view(rhs)); }
+	};
+
 // [PATH]
+	// Paths up to inline_capacity characters live inside the object, so
+	// building paths while walking a tree normally doesn't touch the heap.
+	// The *_view() accessors return views into the path, the older value
+	// returning ones are kept for convenience.
 	class path {
-		std::string m_path;
+		enum { inline_capacity = 87 };
+
+		char* m_ptr;
+		size_t m_size;
+		size_t m_cap;
+		char m_buf[inline_capacity + 1];
+
+		static bool is_sep(char c) { return c == '/' || c == '\\'; }
+
+		void init() {
+			m_ptr = m_buf;
+			m_size = 0;
+			m_cap = inline_capacity;
+			m_buf[0] = 0;
+		}
+
+		void reserve(size_t n) {
+			if (n <= m_cap) return;
+			size_t cap = m_cap * 2 > n ? m_cap * 2 : n;
+			char* p = static_cast<char*>(std::malloc(cap + 1));
+			if (!p) throw std::bad_alloc();
+			std::memcpy(p, m_ptr, m_size + 1);
+			if (m_ptr != m_buf) std::free(m_ptr);
+			m_ptr = p;
+			m_cap = cap;
+		}
+
+		size_t last_sep() const {
+			for (size_t i = m_size; i > 0; i--)
+				if (is_sep(m_ptr[i - 1])) return i - 1;
+			return (size_t)-1;
+		}
+
 	public:
-		path() {}
-		path(const std::string& s) : m_path(s) {}
-		path(const char* s) : m_path(s) {}
+		path() { init(); }
+		path(const char* s) { init(); assign(s, std::strlen(s)); }
+		path(const char* s, size_t n) { init(); assign(s, n); }
+		path(const std::string& s) { init(); assign(s.data(), s.size()); }
+		path(path_view v) { init(); assign(v.data(), v.size()); }
+		path(const path& other) { init(); assign(other.m_ptr, other.m_size); }
 
-		std::string string() const { return m_path; }
-		const char* c_str() const { return m_path.c_str(); }
+		path(path&& other) {
+			if (other.m_ptr == other.m_buf) {
+				init();
+				assign(other.m_ptr, other.m_size);
+			}
+			else {
+				m_ptr = other.m_ptr;
+				m_size = other.m_size;
+				m_cap = other.m_cap;
+				other.init();
+			}
+		}
 
-		operator std::string() const { return m_path; }
+		~path() { if (m_ptr != m_buf) std::free(m_ptr); }
 
-		path filename() const {
-			size_t pos = m_path.find_last_of("/\\");
-			if (pos == std::string::npos) return m_path;
-			return path(m_path.substr(pos + 1));
+		path& operator=(const path& other) {
+			if (this != &other) assign(other.m_ptr, other.m_size);
+			return *this;
 		}
 
-		path extension() const {
-			std::string fname = filename().string();
-			size_t pos = fname.find_last_of('.');
-			if (pos == std::string::npos) { return path(std::string()); }
-			if (pos == 0) { return path(std::string()); }
-			return path(fname.substr(pos));
+		path& operator=(path&& other) {
+			if (this == &other) return *this;
+			if (other.m_ptr == other.m_buf) return assign(other.m_ptr, other.m_size);
+			if (m_ptr != m_buf) std::free(m_ptr);
+			m_ptr = other.m_ptr;
+			m_size = other.m_size;
+			m_cap = other.m_cap;
+			other.init();
+			return *this;
 		}
 
-		path operator/(const path& other) const {
-			if (m_path.empty()) return other;
-			// avoid double separator if already ends with one
-			if (!m_path.empty() && (m_path[m_path.size() - 1] == '/' || m_path[m_path.size() - 1] == '\\')) {
-				return m_path + other.m_path;
+		// s may point into this path
+		path& assign(const char* s, size_t n) {
+			if (n > m_cap) {
+				// copy before freeing the old buffer in case s is inside it
+				char* p = static_cast<char*>(std::malloc(n + 1));
+				if (!p) throw std::bad_alloc();
+				std::memcpy(p, s, n);
+				if (m_ptr != m_buf) std::free(m_ptr);
+				m_ptr = p;
+				m_cap = n;
 			}
-			std::string s = m_path;
-			s += PATH_SEP;
-			s += other.m_path;
-			return path(s);
+			else {
+				std::memmove(m_ptr, s, n);
+			}
+			m_size = n;
+			m_ptr[n] = 0;
+			return *this;
+		}
+
+		// appends raw characters, s may point into this path
+		path& append(const char* s, size_t n) {
+			if (m_size + n > m_cap) {
+				bool inside = s >= m_ptr && s <= m_ptr + m_size;
+				size_t off = inside ? (size_t)(s - m_ptr) : 0;
+				reserve(m_size + n);
+				if (inside) s = m_ptr + off;
+			}
+			std::memmove(m_ptr + m_size, s, n);
+			m_size += n;
+			m_ptr[m_size] = 0;
+			return *this;
+		}
+
+		// Shortens the path to n characters. Together with /= this lets a
+		// tree walk reuse one path object: remember size(), append a child
+		// name, then truncate back.
+		void truncate(size_t n) {
+			if (n >= m_size) return;
+			m_size = n;
+			m_ptr[n] = 0;
+		}
+
+		void clear() { truncate(0); }
+
+		std::string string() const { return std::string(m_ptr, m_size); }
+		const char* c_str() const { return m_ptr; }
+		const char* data() const { return m_ptr; }
+		size_t size() const { return m_size; }
+		bool empty() const { return m_size == 0; }
+		path_view view() const { return path_view(m_ptr, m_size); }
+
+		operator std::string() const { return string(); }
+
+		path_view filename_view() const {
+			size_t pos = last_sep();
+			if (pos == (size_t)-1) return view();
+			return path_view(m_ptr + pos + 1, m_size - pos - 1);
+		}
+
+		// extension including the dot, empty for dotfiles like ".gitignore"
+		path_view extension_view() const {
+			path_view name = filename_view();
+			for (size_t i = name.size(); i > 1; i--)
+				if (name[i - 1] == '.') return path_view(name.data() + i - 1, name.size() - i + 1);
+			return path_view(name.data() + name.size(), 0);
+		}
+
+		path_view stem_view() const {
+			path_view name = filename_view();
+			return path_view(name.data(), name.size() - extension_view().size());
+		}
+
+		// everything before the last separator, "/" for paths directly under the root
+		path_view parent_view() const {
+			size_t pos = last_sep();
+			if (pos == (size_t)-1) return path_view(m_ptr, 0);
+			return path_view(m_ptr, pos ? pos : 1);
+		}
+
+		path filename() const { return path(filename_view()); }
+		path extension() const { return path(extension_view()); }
+		path stem() const { return path(stem_view()); }
+		path parent_path() const { return path(parent_view()); }
+
+		// appends other with a separator in between (unless there already is one)
+		path& operator/=(path_view other) {
+			if (m_size && !is_sep(m_ptr[m_size - 1])) {
+				char sep = PATH_SEP;
+				if (m_size + 1 + other.size() > m_cap) {
+					// other may point into this path, grow before writing the separator
+					bool inside = other.data() >= m_ptr && other.data() <= m_ptr + m_size;
+					size_t off = inside ? (size_t)(other.data() - m_ptr) : 0;
+					reserve(m_size + 1 + other.size());
+					if (inside) other = path_view(m_ptr + off, other.size());
+				}
+				append(&sep, 1);
+			}
+			return append(other.data(), other.size());
 		}
+		path& operator/=(const path& other) { return *this /= other.view(); }
+		path& operator/=(const char* other) { return *this /= path_view(other); }
+		path& operator/=(const std::string& other) { return *this /= path_view(other); }
 
-		bool operator==(const std::string& rhs) const { return m_path == rhs; }
-		bool operator!=(const std::string& rhs) const { return m_path != rhs; }
+		path operator/(const path& other) const {
+			if (!m_size) return other;
+			path p(*this);
+			p /= other.view();
+			return p;
+		}
+
+		bool operator==(const path& rhs) const { return view() == rhs.view(); }
+		bool operator!=(const path& rhs) const { return view() != rhs.view(); }
+		bool operator==(const std::string& rhs) const { return view() == path_view(rhs); }
+		bool operator!=(const std::string& rhs) const { return view() != path_view(rhs); }
+		bool operator==(const char* rhs) const { return view() == path_view(rhs); }
+		bool operator!=(const char* rhs) const { return view() != path_view(rhs); }
 	};
 
 // (EXISTS)
@@ -135,6 +398,140 @@ namespace fs {
 		return !is_directory(p);
 	}
 
+// (STATUS)
+	// stands in for AT_FDCWD in the *_at functions, "relative to the current directory"
+#if defined(_WIN32)
+	const int cwd_fd = -100;
+#else
+	const int cwd_fd = AT_FDCWD;
+#endif
+
+	// Which file_status fields the caller needs. Fields that weren't asked for
+	// are unspecified, usually filled in anyway but possibly stale or 0. With
+	// statx (linux 4.11+) the kernel gets the same mask, network and FUSE
+	// filesystems can skip fetching the rest from the server.
+	enum status_fields {
+		status_type = 1 << 0,
+		status_perms = 1 << 1,
+		status_size = 1 << 2,
+		status_mtime = 1 << 3,
+		status_ino = 1 << 4,		// dev and ino
+		status_nlink = 1 << 5,
+		status_blocks = 1 << 6,
+		status_all = 0x7F
+	};
+
+	// 0 or the errno. out.type is file_type_not_found when the path doesn't
+	// exist, file_type_none for any other failure.
+	inline int stat_at(int dirfd, const char* p, file_status& out, unsigned fields = status_all, bool follow = true) {
+		std::memset(&out, 0, sizeof(out));
+		out.type = file_type_none;
+#if defined(_WIN32)
+		(void)dirfd;
+		(void)fields;
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if (!GetFileAttributesExA(p, GetFileExInfoStandard, &data)) {
+			DWORD err = GetLastError();
+			if (err == ERROR_FILE_NOT_FOUND || err == ERROR_PATH_NOT_FOUND) {
+				out.type = file_type_not_found;
+				return ENOENT;
+			}
+			return EIO;
+		}
+		(void)follow;
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) out.type = file_type_symlink;
+		else if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) out.type = file_type_directory;
+		else out.type = file_type_regular;
+		out.perms = (data.dwFileAttributes & FILE_ATTRIBUTE_READONLY) ? 0555 : 0777;
+		if (out.type != file_type_directory) out.size = ((unsigned long long)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+		unsigned long long ft = ((unsigned long long)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+		out.mtime = ((long long)ft - 116444736000000000LL) * 100;
+		out.nlink = 1;
+		out.blocks = out.size;
+		return 0;
+#elif defined(__linux__) && defined(STATX_BASIC_STATS)
+		unsigned mask = 0;
+		if (fields & (status_type | status_perms)) mask |= STATX_TYPE | STATX_MODE;
+		if (fields & status_size) mask |= STATX_SIZE;
+		if (fields & status_mtime) mask |= STATX_MTIME;
+		if (fields & status_ino) mask |= STATX_INO;
+		if (fields & status_nlink) mask |= STATX_NLINK;
+		if (fields & status_blocks) mask |= STATX_BLOCKS;
+		struct statx sx;
+		if (statx(dirfd, p, follow ? 0 : AT_SYMLINK_NOFOLLOW, mask, &sx) != 0) {
+			int err = errno;
+			if (err != ENOSYS) {
+				if (err == ENOENT || err == ENOTDIR) out.type = file_type_not_found;
+				return err;
+			}
+			// old kernel with new headers, plain fstatat below
+		}
+		else {
+			status_from_statx(sx, out);
+			return 0;
+		}
+#endif
+#if !defined(_WIN32)
+		struct stat st;
+		if (fstatat(dirfd, p, &st, follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0) {
+			int err = errno;
+			if (err == ENOENT || err == ENOTDIR) out.type = file_type_not_found;
+			return err;
+		}
+		status_from_stat(st, out);
+		return 0;
+#endif
+	}
+
+	inline bool status(const path& p, file_status& out, unsigned fields = status_all) {
+		return stat_at(cwd_fd, p.c_str(), out, fields, true) == 0;
+	}
+	inline file_status status(const path& p) {
+		file_status st;
+		stat_at(cwd_fd, p.c_str(), st);
+		return st;
+	}
+
+	// doesn't follow a symlink at p, reports the link itself
+	inline bool symlink_status(const path& p, file_status& out, unsigned fields = status_all) {
+		return stat_at(cwd_fd, p.c_str(), out, fields, false) == 0;
+	}
+	inline file_status symlink_status(const path& p) {
+		file_status st;
+		stat_at(cwd_fd, p.c_str(), st, status_all, false);
+		return st;
+	}
+
+	// (unsigned long long)-1 if p doesn't exist or is a directory
+	inline unsigned long long file_size(const path& p) {
+		file_status st;
+		if (stat_at(cwd_fd, p.c_str(), st, status_type | status_size) != 0 || st.type == file_type_directory)
+			return (unsigned long long)-1;
+		return st.size;
+	}
+
+	// nanoseconds since the unix epoch, LLONG_MIN if p doesn't exist
+	inline long long last_write_time(const path& p) {
+		file_status st;
+		if (stat_at(cwd_fd, p.c_str(), st, status_mtime) != 0) return LLONG_MIN;
+		return st.mtime;
+	}
+
+	// Stats n paths into out[0..n), returns how many succeeded. Failed ones
+	// get file_type_not_found or file_type_none. Synchronous, see
+	// stat_many in fs_async.hpp for the version that overlaps the calls.
+	inline size_t stat_many(const path* paths, size_t n, file_status* out, unsigned fields = status_all) {
+		size_t ok = 0;
+		for (size_t i = 0; i < n; i++)
+			if (stat_at(cwd_fd, paths[i].c_str(), out[i], fields) == 0) ok++;
+		return ok;
+	}
+	inline size_t stat_many(const std::vector<path>& paths, std::vector<file_status>& out, unsigned fields = status_all) {
+		out.resize(paths.size());
+		if (paths.empty()) return 0;
+		return stat_many(&paths[0], paths.size(), &out[0], fields);
+	}
+
 // (CREATE_DIRECTORY)
 	inline bool create_directory(const std::string& path) {
 #if defined(_WIN32)
@@ -146,74 +543,129 @@ namespace fs {
 	inline bool create_directory(const path& p) { return create_directory(p.string()); }
 
 // (CREATE_DIRECTORIES)
-	inline bool create_directories(const std::string& pstr) {
-		if (pstr.empty()) return false;
-		// if already exists and is directory, done
-		if (exists(pstr)) {
-			// if it's a directory, return true; otherwise can't create
-			path pp(pstr);
-			return is_directory(pp);
-		}
+	// Remembers directories that are known to exist, so bulk jobs (archive
+	// extraction, build output trees) that create the same parents over and
+	// over don't hit the filesystem for more than a stat. Entries go stale if
+	// someone else removes the directories, create_directories notices that
+	// and retries without the cache. Not thread safe, use one per thread.
+	class directory_cache {
+		std::unordered_set<std::string> m_known;
+	public:
+		bool contains(const std::string& dir) const { return m_known.count(dir) != 0; }
+		void insert(const std::string& dir) { m_known.insert(dir); }
+		void erase(const std::string& dir) { m_known.erase(dir); }
+		void clear() { m_known.clear(); }
+		size_t size() const { return m_known.size(); }
+	};
 
-		// iterate components
-		std::string cur;
-		size_t i = 0;
+	// 0 if p got created, EEXIST if it already exists, otherwise the errno.
+	// With check_dir an existing p must also be a directory (ENOTDIR if not);
+	// ancestors don't need it since mkdir below a file fails anyway.
+	inline int make_directory(int dirfd, const char* p, bool check_dir) {
+#if defined(_WIN32)
+		(void)dirfd;
+		if (_mkdir(p) == 0) return 0;
+		int err = errno;
+		if (err == ENOENT) return err;
+		// "C:" and friends fail with EACCES, so ask before giving up
+		if (is_directory(path(p))) return EEXIST;
+		if (err == EEXIST) return check_dir ? ENOTDIR : EEXIST;
+		return err;
+#else
+		if (mkdirat(dirfd, p, 0755) == 0) return 0;
+		int err = errno;
+		if (err != EEXIST || !check_dir) return err;
+		struct stat st;
+		if (fstatat(dirfd, p, &st, 0) == 0 && S_ISDIR(st.st_mode)) return EEXIST;
+		return ENOTDIR;
+#endif
+	}
 
+	// Tries the full path first and walks back one parent at a time while
+	// mkdir says ENOENT, then creates downwards from the first ancestor that
+	// exists. A path that is already there costs mkdir + stat, one missing
+	// level a single mkdir, and every extra missing level two more.
+	inline bool create_directories_at(int dirfd, std::string buf, directory_cache* cache) {
+		size_t n = buf.size();
+		while (n > 1 && (buf[n - 1] == '/' || buf[n - 1] == '\\')) n--;
+		buf.resize(n);
+		if (!n) return false;
+		if (cache && cache->contains(buf)) {
+			// one stat to confirm it's still there, far cheaper than the walk
 #if defined(_WIN32)
-		// handle drive letter "C:\"
-		if (pstr.size() >= 2 && pstr[1] == ':') {
-			cur = pstr.substr(0, 2); // "C:"
-			i = 2;
-			// if it begins with "C:\" include the separator
-			if (pstr.size() >= 3 && (pstr[2] == '\\' || pstr[2] == '/')) {
-				cur += PATH_SEP;
-				i = 3;
-			}
-		}
-		else if (!pstr.empty() && (pstr[0] == '\\' || pstr[0] == '/')) {
-			cur = std::string(1, PATH_SEP);
-			i = 1;
-		}
+			if (is_directory(path(buf))) return true;
 #else
-		if (!pstr.empty() && pstr[0] == '/') {
-			cur = std::string(1, PATH_SEP);
-			i = 1;
-		}
+			struct stat st;
+			if (fstatat(dirfd, buf.c_str(), &st, 0) == 0 && S_ISDIR(st.st_mode)) return true;
 #endif
+			// removed behind the cache's back, so its parents may be too
+			cache->clear();
+		}
 
-		while (i < pstr.size()) {
-			// find next separator
-			size_t pos = pstr.find_first_of("/\\", i);
-			std::string part;
-			if (pos == std::string::npos) {
-				part = pstr.substr(i);
-				i = pstr.size();
-			} else {
-				part = pstr.substr(i, pos - i);
-				i = pos + 1;
-			}
+		std::vector<size_t> missing;		// ends of the prefixes still to create
+		bool used_cache = false;
+		size_t end = n;
+		for (;;) {
+			int r;
+			char c = buf[end];
+			buf[end] = 0;
+			if (cache && end != n && cache->contains(buf.c_str())) { r = EEXIST; used_cache = true; }
+			else r = make_directory(dirfd, buf.c_str(), end == n);
+			buf[end] = c;
 
-			if (!part.empty()) {
-				if (!cur.empty() && cur.back() != PATH_SEP) {
-					cur += PATH_SEP;
+			if (r == 0) {
+				if (cache) cache->insert(buf.substr(0, end));
+				break;
+			}
+			if (r == EEXIST) {
+				if (end == n) {
+					if (cache) cache->insert(buf);
+					return true;
 				}
+				break;
+			}
+			if (r != ENOENT) return false;
+			missing.push_back(end);
 
-				cur += part;
+			// step to the parent, skipping repeated separators
+			size_t p = end;
+			while (p > 0 && buf[p - 1] != '/' && buf[p - 1] != '\\') p--;
+			while (p > 0 && (buf[p - 1] == '/' || buf[p - 1] == '\\')) p--;
+			if (p == 0) {
+				if (buf[0] == '/' || buf[0] == '\\') break;		// parent is the root
+				return false;
 			}
+			end = p;
+		}
 
-			// create cur if not exists
-			if (!cur.empty() && !exists(cur)) {
-#if defined(_WIN32)
-				if (_mkdir(cur.c_str()) != 0 && errno != EEXIST) return false;
-#else
-				if (mkdir(cur.c_str(), 0755) != 0 && errno != EEXIST) return false;
-#endif
+		for (size_t i = missing.size(); i-- > 0; ) {
+			size_t e = missing[i];
+			char c = buf[e];
+			buf[e] = 0;
+			int r = make_directory(dirfd, buf.c_str(), i == 0);
+			buf[e] = c;
+			if (r == ENOENT && used_cache) {
+				// a cached parent went away underneath us
+				cache->clear();
+				return create_directories_at(dirfd, buf, cache);
 			}
+			if (r != 0 && r != EEXIST) return false;
+			if (cache) cache->insert(buf.substr(0, e));
 		}
-		// final check
-		return exists(pstr) && is_directory(path(pstr));
+		return true;
+	}
+
+	inline bool create_directories(const std::string& pstr) { return create_directories_at(cwd_fd, pstr, NULL); }
+	inline bool create_directories(const path& p) { return create_directories_at(cwd_fd, p.string(), NULL); }
+	inline bool create_directories(const path& p, directory_cache& cache) { return create_directories_at(cwd_fd, p.string(), &cache); }
+
+#if !defined(_WIN32)
+	// relative paths are resolved against dirfd, like mkdirat. The cache
+	// holds paths as given, so don't share one between different dirfds.
+	inline bool create_directories_at(int dirfd, const path& rel, directory_cache* cache = NULL) {
+		return create_directories_at(dirfd, rel.string(), cache);
 	}
-	inline bool create_directories(const path& p) { return create_directories(p.string()); }
+#endif
 
 // (REMOVE)
 	inline void remove(const path& p) {
@@ -281,7 +733,7 @@ namespace fs {
 			do {
 				std::string name = fd.cFileName;
 				if (name == "." || name == "..") continue;
-				entries.push_back(directory_entry(path(dir.string() + PATH_SEP + name)));
+				entries.push_back(directory_entry(dir / name));
 			} while (FindNextFile(h, &fd) != 0);
 			FindClose(h);
 #else
@@ -302,6 +754,974 @@ namespace fs {
 		std::vector<directory_entry>::iterator end() { return entries.end(); }
 	};
 
+// [DIRECTORY_READER]
+	// Streaming alternative to directory_iterator. It doesn't build a path or
+	// a vector of entries, name() is only valid until the next call to next().
+	// type() comes straight from the directory listing so no stat is needed,
+	// but it can be file_type_unknown on filesystems that don't report it.
+	class directory_reader {
+#if defined(_WIN32)
+		WIN32_FIND_DATAA m_fd;
+		HANDLE m_handle;
+		bool m_first;
+#else
+		DIR* m_dir;
+		struct dirent* m_de;
+#endif
+		directory_reader(const directory_reader&);
+		directory_reader& operator=(const directory_reader&);
+
+	public:
+		directory_reader(const path& dir) {
+#if defined(_WIN32)
+			std::string search = dir.string() + "\\*";
+			m_handle = FindFirstFileA(search.c_str(), &m_fd);
+			m_first = true;
+#else
+			m_dir = opendir(dir.c_str());
+			m_de = NULL;
+#endif
+		}
+
+#if !defined(_WIN32)
+		// opens name relative to dirfd without following a symlink, for walks
+		// that go fd to fd instead of rebuilding paths
+		directory_reader(int dirfd, const char* name) {
+			m_dir = NULL;
+			m_de = NULL;
+			int fd = openat(dirfd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+			if (fd < 0) return;
+			m_dir = fdopendir(fd);
+			if (!m_dir) ::close(fd);
+		}
+#endif
+
+		~directory_reader() {
+#if defined(_WIN32)
+			if (m_handle != INVALID_HANDLE_VALUE) FindClose(m_handle);
+#else
+			if (m_dir) closedir(m_dir);
+#endif
+		}
+
+		bool is_open() const {
+#if defined(_WIN32)
+			return m_handle != INVALID_HANDLE_VALUE;
+#else
+			return m_dir != NULL;
+#endif
+		}
+
+		// advances to the next entry, skipping "." and ".."
+		bool next() {
+			if (!is_open()) return false;
+			for (;;) {
+#if defined(_WIN32)
+				if (!m_first && !FindNextFileA(m_handle, &m_fd)) return false;
+				m_first = false;
+#else
+				m_de = readdir(m_dir);
+				if (!m_de) return false;
+#endif
+				const char* n = name();
+				if (n[0] == '.' && (n[1] == 0 || (n[1] == '.' && n[2] == 0))) continue;
+				return true;
+			}
+		}
+
+		const char* name() const {
+#if defined(_WIN32)
+			return m_fd.cFileName;
+#else
+			return m_de->d_name;
+#endif
+		}
+
+		file_type type() const {
+#if defined(_WIN32)
+			if (m_fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) return file_type_symlink;
+			if (m_fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) return file_type_directory;
+			return file_type_regular;
+#elif defined(DT_UNKNOWN)
+			switch (m_de->d_type) {
+			case DT_REG: return file_type_regular;
+			case DT_DIR: return file_type_directory;
+			case DT_LNK: return file_type_symlink;
+			case DT_UNKNOWN: return file_type_unknown;
+			default: return file_type_other;
+			}
+#else
+			return file_type_unknown;
+#endif
+		}
+
+		// Type, size and mtime (nanoseconds since the unix epoch) of the
+		// current entry, symlinks are not followed. Comes for free with the
+		// listing on windows, costs one fstatat elsewhere.
+		bool stat(file_type& type, unsigned long long& size, long long& mtime) const {
+#if defined(_WIN32)
+			unsigned long long ft = ((unsigned long long)m_fd.ftLastWriteTime.dwHighDateTime << 32) | m_fd.ftLastWriteTime.dwLowDateTime;
+			type = this->type();
+			size = type == file_type_directory ? 0 : ((unsigned long long)m_fd.nFileSizeHigh << 32) | m_fd.nFileSizeLow;
+			mtime = ((long long)ft - 116444736000000000LL) * 100;
+			return true;
+#else
+			struct ::stat st;
+			if (fstatat(dirfd(m_dir), m_de->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) return false;
+			file_status fst;
+			status_from_stat(st, fst);
+			type = fst.type;
+			size = type == file_type_directory ? 0 : fst.size;
+			mtime = fst.mtime;
+			return true;
+#endif
+		}
+
+#if defined(_WIN32)
+		const WIN32_FIND_DATAA& find_data() const { return m_fd; }
+#else
+		// for fd-relative calls (fstatat, openat, unlinkat) on the current entry
+		int fd() const { return dirfd(m_dir); }
+#endif
+	};
+
+// [BYTE_SPAN]
+	// Non-owning view of a block of bytes, the pre C++20 stand-in for std::span.
+	struct byte_span {
+		unsigned char* ptr;
+		size_t len;
+
+		byte_span() : ptr(NULL), len(0) {}
+		byte_span(void* p, size_t n) : ptr(static_cast<unsigned char*>(p)), len(n) {}
+
+		unsigned char* data() const { return ptr; }
+		size_t size() const { return len; }
+		bool empty() const { return len == 0; }
+		unsigned char* begin() const { return ptr; }
+		unsigned char* end() const { return ptr + len; }
+		unsigned char& operator[](size_t i) const { return ptr[i]; }
+
+		// clamps to the end of the span like std::string::substr
+		byte_span subspan(size_t offset, size_t count = (size_t)-1) const {
+			if (offset > len) offset = len;
+			if (count > len - offset) count = len - offset;
+			return byte_span(ptr + offset, count);
+		}
+	};
+
+// [FILE_READER]
+	enum io_flags {
+		io_none = 0,
+		io_sequential = 1 << 0,	// posix_fadvise SEQUENTIAL, the kernel reads ahead further
+		io_random = 1 << 1,		// posix_fadvise RANDOM, no read ahead
+		io_noreuse = 1 << 2,	// drop pages from the page cache once consumed, for one-off scans
+		io_direct = 1 << 3,		// O_DIRECT (F_NOCACHE on macOS), bypass the page cache. Falls
+								// back to buffered I/O where the filesystem doesn't support it
+		io_append = 1 << 4		// file_writer: append instead of truncating
+	};
+
+	const size_t io_alignment = 4096;		// buffer/offset granularity for io_direct
+
+	inline unsigned char* io_alloc(size_t n) {
+#if defined(_WIN32)
+		return static_cast<unsigned char*>(_aligned_malloc(n, io_alignment));
+#else
+		void* p = NULL;
+		if (posix_memalign(&p, io_alignment, n) != 0) return NULL;
+		return static_cast<unsigned char*>(p);
+#endif
+	}
+
+	inline void io_free(unsigned char* p) {
+#if defined(_WIN32)
+		_aligned_free(p);
+#else
+		std::free(p);
+#endif
+	}
+
+	// opens with O_DIRECT when asked, without it if the filesystem refuses
+	inline int io_open(const path& p, int oflags, int flags, bool& direct) {
+		direct = false;
+#if defined(_WIN32)
+		(void)flags;
+		return _open(p.c_str(), oflags | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+		oflags |= O_CLOEXEC;
+	#if defined(O_DIRECT)
+		if (flags & io_direct) {
+			int fd = ::open(p.c_str(), oflags | O_DIRECT, 0644);
+			if (fd >= 0) { direct = true; return fd; }
+			if (errno != EINVAL) return -1;
+		}
+	#endif
+		int fd = ::open(p.c_str(), oflags, 0644);
+	#if defined(__APPLE__)
+		if (fd >= 0 && (flags & io_direct) && fcntl(fd, F_NOCACHE, 1) == 0) direct = true;
+	#endif
+		return fd;
+#endif
+	}
+
+	// Buffered reader over a raw file descriptor, no locale or sentry
+	// machinery. Lines, records and chunks come back as views into the
+	// buffer, valid until the next call on the reader.
+	class file_reader {
+		int m_fd;
+		unsigned char* m_buf;
+		size_t m_cap;
+		size_t m_pos, m_end;			// unread bytes are m_buf[m_pos, m_end)
+		unsigned long long m_offset;	// file offset of m_buf[m_end]
+		unsigned long long m_dropped;	// io_noreuse: everything below this is out of the cache
+		int m_flags;
+		int m_error;
+		bool m_eof;
+		bool m_direct;
+
+		file_reader(const file_reader&);
+		file_reader& operator=(const file_reader&);
+
+		long long raw_read(void* dst, size_t n) {
+			for (;;) {
+#if defined(_WIN32)
+				int got = _read(m_fd, dst, (unsigned)(n > 0x40000000 ? 0x40000000 : n));
+#else
+				ssize_t got = ::read(m_fd, dst, n);
+				if (got < 0 && errno == EINTR) continue;
+#endif
+				if (got < 0) { m_error = errno; return -1; }
+				if (got == 0) m_eof = true;
+				m_offset += (unsigned long long)got;
+				return got;
+			}
+		}
+
+		void drop_behind() {
+#if defined(POSIX_FADV_DONTNEED)
+			if (!(m_flags & io_noreuse)) return;
+			unsigned long long upto = (m_offset - (m_end - m_pos)) & ~(unsigned long long)(io_alignment - 1);
+			if (upto > m_dropped + (m_cap >> 1)) {
+				posix_fadvise(m_fd, (off_t)m_dropped, (off_t)(upto - m_dropped), POSIX_FADV_DONTNEED);
+				m_dropped = upto;
+			}
+#endif
+		}
+
+		// Moves what's unread to the front and reads more behind it. A buffer
+		// that's still full after that (a line or record longer than it)
+		// doubles. Returns false at the end of the file or on an error.
+		bool refill() {
+			if (m_eof || m_fd < 0) return false;
+			drop_behind();
+			// with io_direct reads have to stay aligned, so the data only moves
+			// down by whole blocks
+			size_t shift = m_direct ? (m_pos & ~(io_alignment - 1)) : m_pos;
+			if (shift) {
+				std::memmove(m_buf, m_buf + shift, m_end - shift);
+				m_pos -= shift;
+				m_end -= shift;
+			}
+			if (m_end == m_cap && !grow()) return false;
+			long long got = raw_read(m_buf + m_end, m_cap - m_end);
+			if (got <= 0) return false;
+			m_end += (size_t)got;
+			return true;
+		}
+
+		bool grow() {
+			size_t cap = m_cap * 2;
+			unsigned char* nb = io_alloc(cap);
+			if (!nb) { m_error = ENOMEM; return false; }
+			std::memcpy(nb, m_buf, m_end);
+			io_free(m_buf);
+			m_buf = nb;
+			m_cap = cap;
+			return true;
+		}
+
+	public:
+		file_reader() : m_fd(-1), m_buf(NULL), m_cap(0), m_pos(0), m_end(0), m_offset(0), m_dropped(0),
+			m_flags(0), m_error(0), m_eof(false), m_direct(false) {}
+		explicit file_reader(const path& p, size_t bufsize = 1 << 20, int flags = io_sequential)
+			: m_fd(-1), m_buf(NULL), m_cap(0), m_pos(0), m_end(0), m_offset(0), m_dropped(0),
+			m_flags(0), m_error(0), m_eof(false), m_direct(false) {
+			open(p, bufsize, flags);
+		}
+		~file_reader() { close(); }
+
+		bool open(const path& p, size_t bufsize = 1 << 20, int flags = io_sequential) {
+			close();
+			bufsize = (bufsize + io_alignment - 1) & ~(io_alignment - 1);
+			if (bufsize < io_alignment) bufsize = io_alignment;
+#if defined(_WIN32)
+			m_fd = io_open(p, _O_RDONLY, flags, m_direct);
+#else
+			m_fd = io_open(p, O_RDONLY, flags, m_direct);
+#endif
+			if (m_fd < 0) { m_error = errno; return false; }
+			m_buf = io_alloc(bufsize);
+			if (!m_buf) { close(); m_error = ENOMEM; return false; }
+			m_cap = bufsize;
+			m_flags = flags;
+#if defined(POSIX_FADV_SEQUENTIAL)
+			if (flags & io_sequential) posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+			if (flags & io_random) posix_fadvise(m_fd, 0, 0, POSIX_FADV_RANDOM);
+#endif
+			return true;
+		}
+
+		void close() {
+			if (m_fd >= 0) {
+#if defined(_WIN32)
+				_close(m_fd);
+#else
+				::close(m_fd);
+#endif
+			}
+			if (m_buf) io_free(m_buf);
+			m_fd = -1;
+			m_buf = NULL;
+			m_cap = m_pos = m_end = 0;
+			m_offset = m_dropped = 0;
+			m_error = 0;
+			m_eof = m_direct = false;
+		}
+
+		bool is_open() const { return m_fd >= 0; }
+		int fd() const { return m_fd; }
+		bool direct() const { return m_direct; }
+		int error() const { return m_error; }				// errno of the last failure, 0 if none
+		bool eof() const { return m_eof && m_pos == m_end; }
+		unsigned long long tell() const { return m_offset - (m_end - m_pos); }
+
+		// copies up to n bytes, returns how many (less only at the end or on an error)
+		size_t read(void* dst, size_t n) {
+			unsigned char* out = static_cast<unsigned char*>(dst);
+			size_t done = 0;
+			while (done < n) {
+				if (m_pos == m_end) {
+					// big reads skip the buffer when nothing's left in it
+					if (!m_direct && n - done >= m_cap && !m_eof) {
+						long long got = raw_read(out + done, n - done);
+						if (got <= 0) break;
+						done += (size_t)got;
+						continue;
+					}
+					if (!refill()) break;
+				}
+				size_t take = std::min(n - done, m_end - m_pos);
+				std::memcpy(out + done, m_buf + m_pos, take);
+				m_pos += take;
+				done += take;
+			}
+			return done;
+		}
+
+		// Next piece of the file straight from the buffer, up to the buffer size
+		bool read_chunk(byte_span& chunk) {
+			if (m_pos == m_end && !refill()) return false;
+			chunk = byte_span(m_buf + m_pos, m_end - m_pos);
+			m_pos = m_end;
+			return true;
+		}
+
+		// Next line without the delimiter (and without a '\r' before a '\n').
+		// The last line doesn't need a delimiter. Lines longer than the
+		// buffer grow it.
+		bool read_line(byte_span& line, char delim = '\n') {
+			size_t scanned = m_pos;
+			for (;;) {
+				unsigned char* hit = m_end > scanned
+					? static_cast<unsigned char*>(std::memchr(m_buf + scanned, (unsigned char)delim, m_end - scanned))
+					: NULL;
+				if (hit) {
+					size_t len = (size_t)(hit - (m_buf + m_pos));
+					line = byte_span(m_buf + m_pos, len);
+					m_pos += len + 1;
+					if (delim == '\n' && len && line[len - 1] == '\r') line.len--;
+					return true;
+				}
+				size_t had = m_pos;
+				scanned = m_end;
+				if (!refill()) {
+					if (m_pos == m_end) return false;
+					line = byte_span(m_buf + m_pos, m_end - m_pos);
+					m_pos = m_end;
+					if (delim == '\n' && line.len && line[line.len - 1] == '\r') line.len--;
+					return true;
+				}
+				scanned -= had - m_pos;		// refill shifted the buffer down
+			}
+		}
+
+		// Next record of exactly size bytes, false if fewer are left
+		bool read_record(byte_span& rec, size_t size) {
+			while (m_end - m_pos < size)
+				if (!refill()) return false;
+			rec = byte_span(m_buf + m_pos, size);
+			m_pos += size;
+			return true;
+		}
+
+		// Scatter read at an offset (preadv), independent of the buffered
+		// position. Returns the number of bytes read or -1.
+		long long read_at(const byte_span* bufs, size_t count, unsigned long long offset) const {
+#if defined(_WIN32)
+			if (_lseeki64(m_fd, (long long)offset, SEEK_SET) < 0) return -1;
+			long long total = 0;
+			for (size_t i = 0; i < count; i++) {
+				int got = _read(m_fd, bufs[i].data(), (unsigned)bufs[i].size());
+				if (got < 0) return -1;
+				total += got;
+				if ((size_t)got < bufs[i].size()) break;
+			}
+			_lseeki64(m_fd, (long long)m_offset, SEEK_SET);
+			return total;
+#else
+			struct iovec iov[64];
+			long long total = 0;
+			while (count) {
+				size_t n = count < 64 ? count : 64;
+				size_t want = 0;
+				for (size_t i = 0; i < n; i++) {
+					iov[i].iov_base = bufs[i].data();
+					iov[i].iov_len = bufs[i].size();
+					want += bufs[i].size();
+				}
+				ssize_t got = ::preadv(m_fd, iov, (int)n, (off_t)offset);
+				if (got < 0) {
+					if (errno == EINTR) continue;
+					return total ? total : -1;
+				}
+				total += got;
+				if ((size_t)got < want) break;
+				offset += (unsigned long long)got;
+				bufs += n;
+				count -= n;
+			}
+			return total;
+#endif
+		}
+
+		long long read_at(void* dst, size_t n, unsigned long long offset) const {
+			byte_span b(dst, n);
+			return read_at(&b, 1, offset);
+		}
+	};
+
+// [FILE_WRITER]
+	// Buffered writer over a raw file descriptor. Data reaches the file on
+	// flush(), close() or when the buffer fills, durable only after sync().
+	class file_writer {
+		int m_fd;
+		unsigned char* m_buf;
+		size_t m_cap, m_used;
+		unsigned long long m_written;
+		int m_error;
+		bool m_direct;
+
+		file_writer(const file_writer&);
+		file_writer& operator=(const file_writer&);
+
+		bool raw_write(const unsigned char* p, size_t n) {
+			while (n) {
+#if defined(_WIN32)
+				int put = _write(m_fd, p, (unsigned)(n > 0x40000000 ? 0x40000000 : n));
+#else
+				ssize_t put = ::write(m_fd, p, n);
+				if (put < 0 && errno == EINTR) continue;
+#endif
+				if (put < 0) { m_error = errno; return false; }
+				p += put;
+				n -= (size_t)put;
+			}
+			return true;
+		}
+
+		// O_DIRECT can only write whole blocks, everything but the tail goes out aligned
+		bool flush_direct(bool all) {
+			size_t whole = m_used & ~(io_alignment - 1);
+			if (whole && !raw_write(m_buf, whole)) return false;
+			size_t rest = m_used - whole;
+			if (rest) std::memmove(m_buf, m_buf + whole, rest);
+			m_used = rest;
+			if (all && rest) {
+#if defined(O_DIRECT)
+				// the unaligned tail goes through the page cache
+				fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) & ~O_DIRECT);
+				m_direct = false;
+#endif
+				if (!raw_write(m_buf, rest)) return false;
+				m_used = 0;
+			}
+			return true;
+		}
+
+	public:
+		file_writer() : m_fd(-1), m_buf(NULL), m_cap(0), m_used(0), m_written(0), m_error(0), m_direct(false) {}
+		explicit file_writer(const path& p, size_t bufsize = 1 << 20, int flags = io_none)
+			: m_fd(-1), m_buf(NULL), m_cap(0), m_used(0), m_written(0), m_error(0), m_direct(false) {
+			open(p, bufsize, flags);
+		}
+		~file_writer() { close(); }
+
+		// creates or truncates p (appends with io_append)
+		bool open(const path& p, size_t bufsize = 1 << 20, int flags = io_none) {
+			close();
+			bufsize = (bufsize + io_alignment - 1) & ~(io_alignment - 1);
+			if (bufsize < io_alignment) bufsize = io_alignment;
+#if defined(_WIN32)
+			int oflags = _O_WRONLY | _O_CREAT | ((flags & io_append) ? _O_APPEND : _O_TRUNC);
+#else
+			int oflags = O_WRONLY | O_CREAT | ((flags & io_append) ? O_APPEND : O_TRUNC);
+			// appends land at whatever offset the file ends, O_DIRECT can't promise alignment
+			if (flags & io_append) flags &= ~io_direct;
+#endif
+			m_fd = io_open(p, oflags, flags, m_direct);
+			if (m_fd < 0) { m_error = errno; return false; }
+			m_buf = io_alloc(bufsize);
+			if (!m_buf) { close(); m_error = ENOMEM; return false; }
+			m_cap = bufsize;
+			return true;
+		}
+
+		// flushes and closes, false if any write since open failed
+		bool close() {
+			bool ok = true;
+			if (m_fd >= 0) {
+				ok = (m_direct ? flush_direct(true) : flush()) && m_error == 0;
+#if defined(_WIN32)
+				if (_close(m_fd) != 0) ok = false;
+#else
+				if (::close(m_fd) != 0) ok = false;
+#endif
+			}
+			if (m_buf) io_free(m_buf);
+			m_fd = -1;
+			m_buf = NULL;
+			m_cap = m_used = 0;
+			m_written = 0;
+			m_error = 0;
+			m_direct = false;
+			return ok;
+		}
+
+		bool is_open() const { return m_fd >= 0; }
+		int fd() const { return m_fd; }
+		bool direct() const { return m_direct; }
+		int error() const { return m_error; }
+		unsigned long long written() const { return m_written; }	// bytes accepted so far, flushed or not
+
+		bool write(const void* src, size_t n) {
+			if (m_fd < 0) return false;
+			const unsigned char* p = static_cast<const unsigned char*>(src);
+			m_written += n;
+			// big writes skip the buffer when it's empty
+			if (!m_direct && !m_used && n >= m_cap) return raw_write(p, n);
+			while (n) {
+				size_t take = std::min(n, m_cap - m_used);
+				std::memcpy(m_buf + m_used, p, take);
+				m_used += take;
+				p += take;
+				n -= take;
+				if (m_used == m_cap) {
+					if (m_direct) { if (!flush_direct(false)) return false; }
+					else {
+						if (!raw_write(m_buf, m_used)) return false;
+						m_used = 0;
+					}
+				}
+			}
+			return true;
+		}
+
+		bool write(path_view s) { return write(s.data(), s.size()); }
+
+		bool write_line(path_view s, char delim = '\n') {
+			return write(s.data(), s.size()) && write(&delim, 1);
+		}
+
+		// hands buffered bytes to the kernel (for io_direct, all but a partial last block)
+		bool flush() {
+			if (m_fd < 0) return false;
+			if (!m_used) return true;
+			if (m_direct) return flush_direct(false);
+			bool ok = raw_write(m_buf, m_used);
+			m_used = 0;
+			return ok;
+		}
+
+		// flush() plus fdatasync, the data survives a crash once this returns true
+		bool sync() {
+			if (m_fd < 0) return false;
+			if (m_direct && !flush_direct(true)) return false;
+			if (!flush()) return false;
+#if defined(_WIN32)
+			return _commit(m_fd) == 0;
+#elif defined(__APPLE__)
+			return fcntl(m_fd, F_FULLFSYNC) == 0 || ::fsync(m_fd) == 0;
+#elif defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+			return ::fdatasync(m_fd) == 0;
+#else
+			return ::fsync(m_fd) == 0;
+#endif
+		}
+
+		// Gather write at an offset (pwritev), bypassing the buffer. Flush first
+		// if the ranges overlap buffered data. Returns the bytes written or -1.
+		long long write_at(const byte_span* bufs, size_t count, unsigned long long offset) {
+#if defined(_WIN32)
+			long long here = _telli64(m_fd);
+			if (_lseeki64(m_fd, (long long)offset, SEEK_SET) < 0) return -1;
+			long long total = 0;
+			for (size_t i = 0; i < count; i++) {
+				if (!raw_write(bufs[i].data(), bufs[i].size())) { total = -1; break; }
+				total += (long long)bufs[i].size();
+			}
+			_lseeki64(m_fd, here, SEEK_SET);
+			return total;
+#else
+			struct iovec iov[64];
+			long long total = 0;
+			while (count) {
+				size_t n = count < 64 ? count : 64;
+				for (size_t i = 0; i < n; i++) {
+					iov[i].iov_base = bufs[i].data();
+					iov[i].iov_len = bufs[i].size();
+				}
+				ssize_t put = ::pwritev(m_fd, iov, (int)n, (off_t)offset);
+				if (put < 0) {
+					if (errno == EINTR) continue;
+					m_error = errno;
+					return total ? total : -1;
+				}
+				total += put;
+				offset += (unsigned long long)put;
+				// skip what went out, a short write can stop mid-buffer
+				size_t left = (size_t)put;
+				while (n && left >= bufs[0].size()) {
+					left -= bufs[0].size();
+					bufs++;
+					count--;
+					n--;
+				}
+				if (left) {
+					// finish the partly written buffer on its own
+					long long more = write_at(bufs[0].data() + left, bufs[0].size() - left, offset);
+					if (more < 0) return total;
+					total += more;
+					offset += (unsigned long long)more;
+					bufs++;
+					count--;
+				}
+			}
+			return total;
+#endif
+		}
+
+		long long write_at(const void* src, size_t n, unsigned long long offset) {
+			byte_span b(const_cast<void*>(src), n);
+			return write_at(&b, 1, offset);
+		}
+	};
+
+// [ATOMIC_WRITER]
+	// fsyncs a directory so a rename (or create/unlink) in it survives a crash.
+	// Windows has no equivalent, MOVEFILE_WRITE_THROUGH covers the rename there.
+	inline bool sync_directory(const path& dir) {
+#if defined(_WIN32)
+		(void)dir;
+		return true;
+#else
+		int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (fd < 0) return false;
+		bool ok = ::fsync(fd) == 0;
+		::close(fd);
+		return ok;
+#endif
+	}
+
+	// Unique name next to target for a temp file, so the final rename stays
+	// on one filesystem. The pid keeps processes apart, the counter threads.
+	inline path temp_path_for(const path& target) {
+		static std::atomic<unsigned> counter(0);
+		char suffix[48];
+#if defined(_WIN32)
+		snprintf(suffix, sizeof(suffix), ".tmp.%lu.%u", (unsigned long)GetCurrentProcessId(), counter.fetch_add(1));
+#else
+		snprintf(suffix, sizeof(suffix), ".tmp.%ld.%u", (long)getpid(), counter.fetch_add(1));
+#endif
+		return path(target.string() + suffix);
+	}
+
+	// replaces to with from in one step, also when to exists
+	inline bool replace_file(const path& from, const path& to, bool write_through = false) {
+#if defined(_WIN32)
+		return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | (write_through ? MOVEFILE_WRITE_THROUGH : 0)) != 0;
+#else
+		(void)write_through;
+		return ::rename(from.c_str(), to.c_str()) == 0;
+#endif
+	}
+
+	class commit_batch;
+
+	// Writes to a temp file next to the target and renames it over the
+	// target on commit(), so readers see either the old file or the new
+	// one, never half of it. commit() also fsyncs the file before the
+	// rename and the directory after it, so the same holds after a crash.
+	// Dropping the writer without commit() throws the temp file away.
+	//
+	//	fs::atomic_writer w("out/config.json");
+	//	w.write(text);
+	//	if (!w.commit()) ...
+	class atomic_writer {
+		file_writer m_out;
+		path m_target;
+		path m_temp;
+		bool m_active;
+
+		atomic_writer(const atomic_writer&);
+		atomic_writer& operator=(const atomic_writer&);
+
+		friend class commit_batch;
+
+		// closes the temp file, with its data on disk if durable
+		bool finish(bool durable) {
+			bool ok = m_out.error() == 0;
+			if (ok && durable) ok = m_out.sync();
+			if (!m_out.close()) ok = false;
+			return ok;
+		}
+
+	public:
+		atomic_writer() : m_active(false) {}
+		explicit atomic_writer(const path& target, size_t bufsize = 1 << 20) : m_active(false) { open(target, bufsize); }
+		~atomic_writer() { abort(); }
+
+		bool open(const path& target, size_t bufsize = 1 << 20) {
+			abort();
+			m_target = target;
+			m_temp = temp_path_for(target);
+			if (!m_out.open(m_temp, bufsize)) return false;
+#if !defined(_WIN32)
+			// a replaced file keeps its permissions
+			struct stat st;
+			if (::stat(target.c_str(), &st) == 0) fchmod(m_out.fd(), st.st_mode & 07777);
+#endif
+			m_active = true;
+			return true;
+		}
+
+		bool is_open() const { return m_active; }
+		const path& target() const { return m_target; }
+		const path& temp_path() const { return m_temp; }
+		file_writer& writer() { return m_out; }
+
+		bool write(const void* data, size_t n) { return m_active && m_out.write(data, n); }
+		bool write(path_view s) { return write(s.data(), s.size()); }
+
+		// Publishes the file. With durable = false it's still atomic for
+		// readers, just not guaranteed to survive a crash.
+		bool commit(bool durable = true) {
+			if (!m_active) return false;
+			m_active = false;
+			bool ok = finish(durable) && replace_file(m_temp, m_target, durable);
+			if (!ok) {
+				::remove(m_temp.c_str());
+				return false;
+			}
+			if (durable) ok = sync_directory(m_target.parent_path());
+			return ok;
+		}
+
+		// hands the finished temp file to batch, which publishes it on its commit()
+		bool commit(commit_batch& batch);
+
+		void abort() {
+			if (!m_active) return;
+			m_active = false;
+			m_out.close();
+			::remove(m_temp.c_str());
+		}
+	};
+
+// [COMMIT_BATCH]
+	// Group commit for publishing many files. fsync per file costs a disk
+	// flush each, here all files are written first, their data is flushed
+	// once, then everything is renamed and each directory involved gets a
+	// single fsync. Per file that's the same guarantee as
+	// atomic_writer::commit(): after a crash a target is either old or
+	// complete, but the batch as a whole is not atomic.
+	//
+	// batch_syncfs (linux) flushes each filesystem with one syncfs() call.
+	// That also flushes unrelated dirty data on it, on a busy box
+	// batch_fsync_each (fdatasync per file, still no per-file directory
+	// fsync) can be the cheaper choice.
+	//
+	//	fs::commit_batch batch;
+	//	for (...) batch.write(out_dir / name, data, size);
+	//	if (!batch.commit()) ...
+	class commit_batch {
+	public:
+		enum sync_mode {
+			batch_syncfs,		// falls back to batch_fsync_each outside linux
+			batch_fsync_each,
+			batch_no_sync		// atomic for readers only
+		};
+
+	private:
+		struct staged {
+			path temp, target;
+		};
+		std::vector<staged> m_staged;
+		std::vector<path> m_failed;
+		sync_mode m_mode;
+		bool m_done;			// commit() ran, the next batch starts with a clean failed()
+
+		commit_batch(const commit_batch&);
+		commit_batch& operator=(const commit_batch&);
+
+		static bool fdatasync_path(const path& p) {
+#if defined(_WIN32)
+			int fd = _open(p.c_str(), _O_RDWR | _O_BINARY);
+			if (fd < 0) return false;
+			bool ok = _commit(fd) == 0;
+			_close(fd);
+#else
+			int fd = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0) return false;
+	#if defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0 && !defined(__APPLE__)
+			bool ok = ::fdatasync(fd) == 0;
+	#else
+			bool ok = ::fsync(fd) == 0;
+	#endif
+			::close(fd);
+#endif
+			return ok;
+		}
+
+		void begin() {
+			if (!m_done) return;
+			m_done = false;
+			m_failed.clear();
+		}
+
+		// flushes the data of every staged file, false if any of it may not be on disk
+		bool sync_data() {
+			if (m_mode == batch_no_sync) return true;
+#if defined(__linux__)
+			if (m_mode == batch_syncfs) {
+				// one syncfs per filesystem the temp files are on
+				std::vector<unsigned long long> devs;
+				bool ok = true;
+				for (size_t i = 0; i < m_staged.size(); i++) {
+					struct stat st;
+					if (::stat(m_staged[i].temp.c_str(), &st) != 0) { ok = false; continue; }
+					if (std::find(devs.begin(), devs.end(), (unsigned long long)st.st_dev) != devs.end()) continue;
+					devs.push_back((unsigned long long)st.st_dev);
+					int fd = ::open(m_staged[i].temp.c_str(), O_RDONLY | O_CLOEXEC);
+					if (fd < 0 || syncfs(fd) != 0) ok = false;
+					if (fd >= 0) ::close(fd);
+				}
+				return ok;
+			}
+#endif
+			bool ok = true;
+			for (size_t i = 0; i < m_staged.size(); i++)
+				if (!fdatasync_path(m_staged[i].temp)) ok = false;
+			return ok;
+		}
+
+	public:
+		explicit commit_batch(sync_mode mode = batch_syncfs) : m_mode(mode), m_done(false) {}
+		~commit_batch() { abort(); }
+
+		size_t size() const { return m_staged.size(); }
+		// targets of this batch that failed to write or publish
+		const std::vector<path>& failed() const { return m_failed; }
+
+		// stages a finished temp file, normally reached through atomic_writer::commit(batch)
+		void stage(const path& temp, const path& target) {
+			begin();
+			staged s = { temp, target };
+			m_staged.push_back(s);
+		}
+
+		// writes data to a temp file next to target, published on commit()
+		bool write(const path& target, const void* data, size_t n) {
+			begin();
+			atomic_writer w;
+			if (!w.open(target, n < (1 << 20) ? n + 1 : (1 << 20)) || !w.write(data, n) || !w.commit(*this)) {
+				m_failed.push_back(target);
+				return false;
+			}
+			return true;
+		}
+
+		// Flushes, renames and syncs the directories. Returns false if any
+		// target couldn't be published (see failed()). When the data flush
+		// fails nothing is renamed, the old files stay as they were.
+		bool commit() {
+			begin();
+			m_done = true;
+			bool ok = m_failed.empty();
+			if (!sync_data()) {
+				for (size_t i = 0; i < m_staged.size(); i++) {
+					::remove(m_staged[i].temp.c_str());
+					m_failed.push_back(m_staged[i].target);
+				}
+				m_staged.clear();
+				return false;
+			}
+
+			std::vector<path> dirs;
+			for (size_t i = 0; i < m_staged.size(); i++) {
+				if (!replace_file(m_staged[i].temp, m_staged[i].target)) {
+					::remove(m_staged[i].temp.c_str());
+					m_failed.push_back(m_staged[i].target);
+					ok = false;
+					continue;
+				}
+				path dir = m_staged[i].target.parent_path();
+				if (std::find(dirs.begin(), dirs.end(), dir) == dirs.end()) dirs.push_back(dir);
+			}
+			m_staged.clear();
+
+			if (m_mode != batch_no_sync) {
+				for (size_t i = 0; i < dirs.size(); i++)
+					if (!sync_directory(dirs[i])) ok = false;
+			}
+			return ok;
+		}
+
+		// drops everything staged, the targets are left untouched
+		void abort() {
+			m_done = false;
+			for (size_t i = 0; i < m_staged.size(); i++) ::remove(m_staged[i].temp.c_str());
+			m_staged.clear();
+			m_failed.clear();
+		}
+	};
+
+	inline bool atomic_writer::commit(commit_batch& batch) {
+		if (!m_active) return false;
+		m_active = false;
+		if (!finish(false)) {
+			::remove(m_temp.c_str());
+			return false;
+		}
+		batch.stage(m_temp, m_target);
+		return true;
+	}
+
+	// one-shot durable replace of target with data
+	inline bool write_file_atomic(const path& target, const void* data, size_t n, bool durable = true) {
+		atomic_writer w;
+		if (!w.open(target, n < (1 << 20) ? n + 1 : (1 << 20))) return false;
+		return w.write(data, n) && w.commit(durable);
+	}
+
 	// (COPY_FILE)
 	inline bool copy_file(const path& src, const path& dst, int options = copy_options_none) {
 		// if src doesn't exist or is directory -> fail
@@ -312,7 +1732,7 @@ namespace fs {
 			return false;
 		}
 
-		std::ifstream in(src.string().c_str(), std::ios::binary);
+		file_reader in(src, 1 << 20, io_sequential);
 		if (!in.is_open()) return false;
 
 		// ensure destination directory exists
@@ -327,21 +1747,15 @@ namespace fs {
 			}
 		}
 
-		std::ofstream out(dst.string().c_str(), std::ios::binary | std::ios::trunc);
-		if (!out.is_open()) {
-			in.close();
-			return false;
-		}
+		// unbuffered writer, the reader's chunks go straight to write()
+		file_writer out(dst, io_alignment);
+		if (!out.is_open()) return false;
 
-		const std::size_t bufsize = 4096;
-		char buffer[bufsize];
-		while (in.good()) {
-			in.read(buffer, bufsize);
-			std::streamsize s = in.gcount();
-			if (s > 0) out.write(buffer, s);
+		byte_span chunk;
+		while (in.read_chunk(chunk)) {
+			if (!out.write(chunk.data(), chunk.size())) return false;
 		}
-		in.close(); out.close();
-		return true;
+		return in.error() == 0 && out.close();
 	}
 
 	// (COPY_DIRECTORY)
@@ -404,6 +1818,366 @@ namespace fs {
 		}
 	}
 
+// (REMOVE_ALL)
+	struct remove_error {
+		std::string path;
+		int error;				// errno, or GetLastError() on windows
+	};
+
+	struct remove_result {
+		unsigned long long files;			// everything that isn't a directory, symlinks included
+		unsigned long long directories;
+		std::vector<remove_error> errors;
+
+		remove_result() : files(0), directories(0) {}
+		bool ok() const { return errors.empty(); }
+		unsigned long long removed() const { return files + directories; }
+	};
+
+	// Removes name (relative to dirfd) and everything below it. Symlinks are
+	// removed, never followed. pathbuf holds the path of name and is only
+	// used for error messages. Returns false if anything in the subtree
+	// stayed, in which case the directories above it aren't even tried.
+#if defined(_WIN32)
+	inline bool remove_tree(std::string& pathbuf, bool is_dir, remove_result& r, bool stop_on_error) {
+		if (!is_dir) {
+			if (DeleteFileA(pathbuf.c_str())) { r.files++; return true; }
+			// read-only files can't be deleted until the attribute is gone
+			DWORD err = GetLastError();
+			if (err == ERROR_ACCESS_DENIED && SetFileAttributesA(pathbuf.c_str(), FILE_ATTRIBUTE_NORMAL) && DeleteFileA(pathbuf.c_str())) {
+				r.files++;
+				return true;
+			}
+			if (err == ERROR_FILE_NOT_FOUND) return true;
+			remove_error e = { pathbuf, (int)err };
+			r.errors.push_back(e);
+			return false;
+		}
+
+		bool ok = true;
+		DWORD attrib = GetFileAttributesA(pathbuf.c_str());
+		// junctions and directory symlinks go like files, without their targets
+		if (attrib != INVALID_FILE_ATTRIBUTES && !(attrib & FILE_ATTRIBUTE_REPARSE_POINT)) {
+			directory_reader rd(path(pathbuf));
+			size_t len = pathbuf.size();
+			while (rd.next()) {
+				pathbuf += '\\';
+				pathbuf += rd.name();
+				if (!remove_tree(pathbuf, rd.type() == file_type_directory, r, stop_on_error)) ok = false;
+				pathbuf.resize(len);
+				if (!ok && stop_on_error) return false;
+			}
+		}
+		if (!ok) return false;
+		if (RemoveDirectoryA(pathbuf.c_str())) { r.directories++; return true; }
+		DWORD err = GetLastError();
+		if (err == ERROR_FILE_NOT_FOUND || err == ERROR_PATH_NOT_FOUND) return true;
+		remove_error e = { pathbuf, (int)err };
+		r.errors.push_back(e);
+		return false;
+	}
+#else
+	inline bool remove_tree_at(int dirfd, const char* name, std::string& pathbuf, file_type type, remove_result& r, bool stop_on_error) {
+		if (type != file_type_directory) {
+			if (unlinkat(dirfd, name, 0) == 0) { r.files++; return true; }
+			int err = errno;
+			if (err == ENOENT) return true;
+			// d_type was unknown or stale, or this is linux calling a directory EISDIR
+			if (err != EISDIR && err != EPERM) {
+				remove_error e = { pathbuf, err };
+				r.errors.push_back(e);
+				return false;
+			}
+			struct stat st;
+			if (fstatat(dirfd, name, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISDIR(st.st_mode)) {
+				remove_error e = { pathbuf, err };
+				r.errors.push_back(e);
+				return false;
+			}
+		}
+
+		bool ok = true;
+		{
+			directory_reader rd(dirfd, name);
+			if (!rd.is_open()) {
+				int err = errno;
+				if (err == ENOENT) return true;
+				remove_error e = { pathbuf, err };
+				r.errors.push_back(e);
+				return false;
+			}
+			size_t len = pathbuf.size();
+			while (rd.next()) {
+				pathbuf += '/';
+				pathbuf += rd.name();
+				if (!remove_tree_at(rd.fd(), rd.name(), pathbuf, rd.type(), r, stop_on_error)) ok = false;
+				pathbuf.resize(len);
+				if (!ok && stop_on_error) return false;
+			}
+		}
+		if (!ok) return false;
+		if (unlinkat(dirfd, name, AT_REMOVEDIR) == 0) { r.directories++; return true; }
+		int err = errno;
+		if (err == ENOENT) return true;
+		remove_error e = { pathbuf, err };
+		r.errors.push_back(e);
+		return false;
+	}
+#endif
+
+	// Error collecting version, keeps going past failures and reports every
+	// path it couldn't remove. A p that doesn't exist is not an error.
+	inline bool remove_all(const path& p, remove_result& result) {
+		std::string buf = p.string();
+#if defined(_WIN32)
+		DWORD attrib = GetFileAttributesA(buf.c_str());
+		if (attrib == INVALID_FILE_ATTRIBUTES) return true;
+		remove_tree(buf, (attrib & FILE_ATTRIBUTE_DIRECTORY) != 0, result, false);
+#else
+		// buf grows and shrinks during the walk, the name needs its own copy
+		std::string name = buf;
+		struct stat st;
+		if (lstat(name.c_str(), &st) != 0) return errno == ENOENT;
+		remove_tree_at(AT_FDCWD, name.c_str(), buf, S_ISDIR(st.st_mode) ? file_type_directory : file_type_regular, result, false);
+#endif
+		return result.ok();
+	}
+
+	// Like remove(), throws on the first failure. Returns the number of
+	// files and directories removed.
+	inline unsigned long long remove_all(const path& p) {
+		remove_result r;
+		std::string buf = p.string();
+#if defined(_WIN32)
+		DWORD attrib = GetFileAttributesA(buf.c_str());
+		if (attrib == INVALID_FILE_ATTRIBUTES) return 0;
+		remove_tree(buf, (attrib & FILE_ATTRIBUTE_DIRECTORY) != 0, r, true);
+#else
+		std::string name = buf;
+		struct stat st;
+		if (lstat(name.c_str(), &st) != 0) {
+			if (errno == ENOENT) return 0;
+			remove_error e = { buf, errno };
+			r.errors.push_back(e);
+		}
+		else remove_tree_at(AT_FDCWD, name.c_str(), buf, S_ISDIR(st.st_mode) ? file_type_directory : file_type_regular, r, true);
+#endif
+		if (!r.ok()) throw std::runtime_error("Failed to remove " + r.errors[0].path);
+		return r.removed();
+	}
+
+// [MAPPED_FILE]
+	enum map_mode {
+		map_read_only,
+		map_copy_on_write,		// writable, changes stay private to this mapping
+		map_read_write			// writable, changes go to the file
+	};
+
+	enum map_advice {
+		map_advice_normal,
+		map_advice_sequential,	// read ahead aggressively, drop pages behind
+		map_advice_random,		// no read ahead
+		map_advice_willneed,	// start reading the range in now
+		map_advice_hugepage		// back the range with huge pages where supported
+	};
+
+	// RAII wrapper over mmap / MapViewOfFile. The whole file (or a range of
+	// it) is mapped at once, on 64-bit that is fine even for multi-GB files
+	// since pages are only read in when touched.
+	class mapped_file {
+		unsigned char* m_data;		// first requested byte
+		size_t m_size;
+		void* m_base;				// start of the mapping, aligned down from m_data
+		size_t m_map_size;
+		map_mode m_mode;
+		bool m_open;
+#if defined(_WIN32)
+		HANDLE m_file;
+		HANDLE m_mapping;
+#endif
+
+		mapped_file(const mapped_file&);
+		mapped_file& operator=(const mapped_file&);
+
+		void reset() {
+			m_data = NULL; m_size = 0;
+			m_base = NULL; m_map_size = 0;
+			m_mode = map_read_only;
+			m_open = false;
+#if defined(_WIN32)
+			m_file = INVALID_HANDLE_VALUE;
+			m_mapping = NULL;
+#endif
+		}
+
+		static size_t granularity() {
+#if defined(_WIN32)
+			SYSTEM_INFO si;
+			GetSystemInfo(&si);
+			return si.dwAllocationGranularity;
+#else
+			return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+		}
+
+	public:
+		mapped_file() { reset(); }
+
+		mapped_file(const path& p, map_mode mode = map_read_only, unsigned long long offset = 0, size_t length = 0) {
+			reset();
+			open(p, mode, offset, length);
+		}
+
+		mapped_file(mapped_file&& other) { reset(); swap(other); }
+		mapped_file& operator=(mapped_file&& other) { close(); swap(other); return *this; }
+
+		~mapped_file() { close(); }
+
+		// Maps length bytes starting at offset (length 0 = up to the end of
+		// the file). The offset doesn't need to be page aligned. Mapping an
+		// empty range succeeds with data() == NULL.
+		bool open(const path& p, map_mode mode = map_read_only, unsigned long long offset = 0, size_t length = 0) {
+			close();
+			bool writable = mode == map_read_write;
+#if defined(_WIN32)
+			m_file = CreateFileA(p.c_str(), GENERIC_READ | (writable ? GENERIC_WRITE : 0),
+				FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (m_file == INVALID_HANDLE_VALUE) return false;
+			LARGE_INTEGER fsize;
+			if (!GetFileSizeEx(m_file, &fsize)) { close(); return false; }
+			unsigned long long total = (unsigned long long)fsize.QuadPart;
+#else
+			int fd = ::open(p.c_str(), writable ? O_RDWR : O_RDONLY);
+			if (fd < 0) return false;
+			struct stat st;
+			if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+			unsigned long long total = (unsigned long long)st.st_size;
+#endif
+			if (offset > total) offset = total;
+			if (!length || length > total - offset) length = (size_t)(total - offset);
+
+			m_mode = mode;
+			if (length) {
+				unsigned long long aligned = offset - offset % granularity();
+				size_t map_size = (size_t)(offset - aligned) + length;
+#if defined(_WIN32)
+				DWORD protect = mode == map_read_only ? PAGE_READONLY : mode == map_copy_on_write ? PAGE_WRITECOPY : PAGE_READWRITE;
+				DWORD access = mode == map_read_only ? FILE_MAP_READ : mode == map_copy_on_write ? FILE_MAP_COPY : FILE_MAP_WRITE;
+				m_mapping = CreateFileMappingA(m_file, NULL, protect, 0, 0, NULL);
+				if (!m_mapping) { close(); return false; }
+				m_base = MapViewOfFile(m_mapping, access, (DWORD)(aligned >> 32), (DWORD)aligned, map_size);
+				if (!m_base) { close(); return false; }
+#else
+				int prot = mode == map_read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+				int flags = mode == map_read_write ? MAP_SHARED : MAP_PRIVATE;
+				void* base = mmap(NULL, map_size, prot, flags, fd, (off_t)aligned);
+				if (base == MAP_FAILED) { ::close(fd); reset(); return false; }
+				m_base = base;
+#endif
+				m_map_size = map_size;
+				m_data = static_cast<unsigned char*>(m_base) + (offset - aligned);
+				m_size = length;
+			}
+#if !defined(_WIN32)
+			// the mapping keeps the file referenced, the descriptor isn't needed
+			::close(fd);
+#endif
+			m_open = true;
+			return true;
+		}
+
+		void close() {
+#if defined(_WIN32)
+			if (m_base) UnmapViewOfFile(m_base);
+			if (m_mapping) CloseHandle(m_mapping);
+			if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+#else
+			if (m_base) munmap(m_base, m_map_size);
+#endif
+			reset();
+		}
+
+		bool is_open() const { return m_open; }
+
+		map_mode mode() const { return m_mode; }
+
+		unsigned char* data() { return m_data; }
+		const unsigned char* data() const { return m_data; }
+		size_t size() const { return m_size; }
+		bool empty() const { return m_size == 0; }
+
+		unsigned char* begin() { return m_data; }
+		unsigned char* end() { return m_data + m_size; }
+		const unsigned char* begin() const { return m_data; }
+		const unsigned char* end() const { return m_data + m_size; }
+
+		unsigned char& operator[](size_t i) { return m_data[i]; }
+		const unsigned char& operator[](size_t i) const { return m_data[i]; }
+
+		// writing through the span of a read only mapping faults
+		byte_span span() const { return byte_span(m_data, m_size); }
+		byte_span subspan(size_t offset, size_t count = (size_t)-1) const { return span().subspan(offset, count); }
+
+		// Access pattern hint for a range (length 0 = to the end). Returns
+		// false if the platform doesn't support the hint.
+		bool advise(map_advice advice, size_t offset = 0, size_t length = 0) {
+			if (!m_data || offset >= m_size) return false;
+			if (!length || length > m_size - offset) length = m_size - offset;
+#if defined(_WIN32)
+			if (advice != map_advice_willneed) return advice == map_advice_normal;
+			typedef struct { PVOID VirtualAddress; SIZE_T NumberOfBytes; } range_entry;
+			typedef BOOL(WINAPI* prefetch_proc)(HANDLE, ULONG_PTR, range_entry*, ULONG);
+			static prefetch_proc prefetch = (prefetch_proc)GetProcAddress(GetModuleHandleA("kernel32.dll"), "PrefetchVirtualMemory");
+			if (!prefetch) return false;
+			range_entry r = { m_data + offset, length };
+			return prefetch(GetCurrentProcess(), 1, &r, 0) != 0;
+#else
+			int a;
+			switch (advice) {
+			case map_advice_sequential: a = MADV_SEQUENTIAL; break;
+			case map_advice_random: a = MADV_RANDOM; break;
+			case map_advice_willneed: a = MADV_WILLNEED; break;
+			case map_advice_hugepage:
+	#if defined(MADV_HUGEPAGE)
+				a = MADV_HUGEPAGE; break;
+	#else
+				return false;
+	#endif
+			default: a = MADV_NORMAL; break;
+			}
+			// madvise wants a page aligned start
+			unsigned char* start = m_data + offset;
+			size_t misalign = (size_t)(start - static_cast<unsigned char*>(m_base)) % granularity();
+			return madvise(start - misalign, length + misalign, a) == 0;
+#endif
+		}
+
+		// Writes dirty pages of a map_read_write mapping back to the file.
+		// async only schedules the write.
+		bool flush(bool async = false) {
+			if (!m_base || m_mode != map_read_write) return m_mode == map_read_write;
+#if defined(_WIN32)
+			if (!FlushViewOfFile(m_base, m_map_size)) return false;
+			return async || FlushFileBuffers(m_file) != 0;
+#else
+			return msync(m_base, m_map_size, async ? MS_ASYNC : MS_SYNC) == 0;
+#endif
+		}
+
+		void swap(mapped_file& other) {
+			std::swap(m_data, other.m_data);
+			std::swap(m_size, other.m_size);
+			std::swap(m_base, other.m_base);
+			std::swap(m_map_size, other.m_map_size);
+			std::swap(m_mode, other.m_mode);
+			std::swap(m_open, other.m_open);
+#if defined(_WIN32)
+			std::swap(m_file, other.m_file);
+			std::swap(m_mapping, other.m_mapping);
+#endif
+		}
+	};
+
 };
 
 #endif
@@ -0,0 +1,806 @@
+/*
+
+	Copyright (C) Nico Rajala 2025
+
+	fs_async.hpp
+	Asynchronous file I/O on top of filesystem.hpp. Requests are queued,
+	handed to the kernel in batches with io_uring where the kernel supports
+	it (linux 5.6+) and to a small thread pool everywhere else.
+
+	Needs C++11 (std::function, std::future, std::thread).
+
+	The engine is driven from one thread: queue requests, then call poll(),
+	wait() or drain(). Completion callbacks always run on that thread from
+	inside those calls, with the result of the operation (bytes transferred,
+	the new fd or 0) or -errno. Futures are fulfilled the same way, so
+	someone has to keep calling wait()/drain() before get() returns.
+
+	Usage:
+		fs::async_engine eng;
+		for (size_t i = 0; i < blocks; i++)
+			eng.read(fd, buf + i * 4096, 4096, i * 4096, [&](long long r) { ... });
+		eng.drain();
+
+	Table of contents: () - functions [] - classes/structs/other
+		[ASYNC_ENGINE]
+		(COPY_FILE_ASYNC)
+		(SCAN_DIRECTORY_ASYNC)
+		(STAT_MANY_ASYNC)
+
+*/
+
+#ifndef FS_ASYNC_HPP
+#define FS_ASYNC_HPP
+
+#include "filesystem.hpp"
+
+#include <stdint.h>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#if defined(__linux__) && !defined(FS_NO_IO_URING) && defined(__has_include)
+	#if __has_include(<linux/io_uring.h>)
+		#include <linux/io_uring.h>
+		#include <sys/syscall.h>
+		#include <sys/sysmacros.h>
+		// the 5.6 headers are the first with the open/close/statx opcodes
+		#if defined(IORING_FEAT_CUR_PERSONALITY) && defined(STATX_BASIC_STATS) && defined(__NR_io_uring_setup)
+			#define FS_HAVE_IO_URING
+		#endif
+	#endif
+#endif
+
+#if defined(_WIN32)
+	#include <io.h>
+#endif
+
+namespace fs {
+
+	typedef std::function<void(long long result)> async_callback;
+
+// [ASYNC_ENGINE]
+	class async_engine {
+	public:
+		enum backend {
+			backend_auto,		// io_uring if the kernel has it, threads otherwise
+			backend_io_uring,
+			backend_threads
+		};
+
+	private:
+		enum op_type { op_read, op_write, op_open, op_close, op_stat };
+
+		// requests are recycled through m_free, so a steady stream of reads
+		// doesn't allocate (beyond what the callback itself captures)
+		struct request {
+			op_type op;
+			int fd;
+			void* buf;
+			size_t len;
+			unsigned long long offset;
+			std::string path;
+			int flags, mode;
+			file_status* st;
+			async_callback cb;
+			long long result;
+#if defined(FS_HAVE_IO_URING)
+			struct statx sx;
+#endif
+		};
+
+		std::vector<request*> m_free;
+		std::deque<request*> m_queued;		// not handed to the kernel or the pool yet
+		size_t m_inflight;
+		unsigned m_depth;
+		bool m_uring;
+
+#if defined(FS_HAVE_IO_URING)
+		int m_ring;
+		void* m_sq_ptr; size_t m_sq_size;
+		void* m_cq_ptr; size_t m_cq_size;
+		struct io_uring_sqe* m_sqes; size_t m_sqes_size;
+		unsigned *m_sq_head, *m_sq_tail, *m_sq_mask, *m_sq_array;
+		unsigned *m_cq_head, *m_cq_tail, *m_cq_mask;
+		struct io_uring_cqe* m_cqes;
+		unsigned m_sq_entries, m_cq_entries;
+		unsigned m_unsubmitted;		// in the SQ ring, not taken by the kernel yet (counted in m_inflight)
+#endif
+
+		std::vector<std::thread> m_threads;
+		std::mutex m_lock;
+		std::condition_variable m_work_cv, m_done_cv;
+		std::deque<request*> m_work;
+		std::vector<request*> m_done;
+		bool m_stop;
+
+		async_engine(const async_engine&);
+		async_engine& operator=(const async_engine&);
+
+		request* alloc(op_type op, async_callback& cb) {
+			request* r;
+			if (m_free.empty()) r = new request();
+			else { r = m_free.back(); m_free.pop_back(); }
+			r->op = op;
+			r->fd = -1;
+			r->buf = NULL;
+			r->len = 0;
+			r->offset = 0;
+			r->flags = r->mode = 0;
+			r->st = NULL;
+			r->cb.swap(cb);
+			r->result = 0;
+			return r;
+		}
+
+		// runs the callbacks of finished requests and recycles them
+		size_t complete(std::vector<request*>& done) {
+			for (size_t i = 0; i < done.size(); i++) {
+				request* r = done[i];
+				async_callback cb;
+				cb.swap(r->cb);
+				long long res = r->result;
+				m_free.push_back(r);
+				if (cb) cb(res);
+			}
+			size_t n = done.size();
+			done.clear();
+			return n;
+		}
+
+		static long long errno_result() { return -(long long)errno; }
+
+		// executes one request synchronously, used by the thread pool
+		static void execute(request* r) {
+#if defined(_WIN32)
+			switch (r->op) {
+			case op_read:
+			case op_write: {
+				HANDLE h = (HANDLE)_get_osfhandle(r->fd);
+				OVERLAPPED ov;
+				std::memset(&ov, 0, sizeof(ov));
+				ov.Offset = (DWORD)r->offset;
+				ov.OffsetHigh = (DWORD)(r->offset >> 32);
+				DWORD n = 0;
+				BOOL ok = r->op == op_read ? ReadFile(h, r->buf, (DWORD)r->len, &n, &ov) : WriteFile(h, r->buf, (DWORD)r->len, &n, &ov);
+				if (ok || GetLastError() == ERROR_HANDLE_EOF) r->result = n;
+				else r->result = -EIO;
+				break;
+			}
+			case op_open:
+				r->result = _open(r->path.c_str(), r->flags | _O_BINARY, r->mode);
+				if (r->result < 0) r->result = errno_result();
+				break;
+			case op_close:
+				r->result = _close(r->fd) == 0 ? 0 : errno_result();
+				break;
+			case op_stat:
+				r->result = -stat_at(cwd_fd, r->path.c_str(), *r->st, (unsigned)r->mode, r->flags != 0);
+				break;
+			}
+#else
+			ssize_t n;
+			switch (r->op) {
+			case op_read:
+				n = pread(r->fd, r->buf, r->len, (off_t)r->offset);
+				r->result = n < 0 ? errno_result() : n;
+				break;
+			case op_write:
+				n = pwrite(r->fd, r->buf, r->len, (off_t)r->offset);
+				r->result = n < 0 ? errno_result() : n;
+				break;
+			case op_open:
+				r->result = ::open(r->path.c_str(), r->flags | O_CLOEXEC, r->mode);
+				if (r->result < 0) r->result = errno_result();
+				break;
+			case op_close:
+				r->result = ::close(r->fd) == 0 ? 0 : errno_result();
+				break;
+			case op_stat:
+				r->result = -stat_at(AT_FDCWD, r->path.c_str(), *r->st, (unsigned)r->mode, r->flags != 0);
+				break;
+			}
+#endif
+		}
+
+		void worker() {
+			std::unique_lock<std::mutex> lk(m_lock);
+			for (;;) {
+				while (m_work.empty() && !m_stop) m_work_cv.wait(lk);
+				if (m_work.empty()) return;
+				request* r = m_work.front();
+				m_work.pop_front();
+				lk.unlock();
+				execute(r);
+				lk.lock();
+				m_done.push_back(r);
+				m_done_cv.notify_one();
+			}
+		}
+
+		void start_threads(unsigned threads) {
+			if (!threads) threads = std::thread::hardware_concurrency();
+			if (threads < 2) threads = 2;
+			for (unsigned i = 0; i < threads; i++)
+				m_threads.push_back(std::thread(&async_engine::worker, this));
+		}
+
+#if defined(FS_HAVE_IO_URING)
+		static int uring_setup(unsigned entries, struct io_uring_params* p) {
+			return (int)syscall(__NR_io_uring_setup, entries, p);
+		}
+		static int uring_enter(int fd, unsigned submit, unsigned min_complete, unsigned flags) {
+			return (int)syscall(__NR_io_uring_enter, fd, submit, min_complete, flags, NULL, 0);
+		}
+		static int uring_register(int fd, unsigned op, void* arg, unsigned n) {
+			return (int)syscall(__NR_io_uring_register, fd, op, arg, n);
+		}
+
+		bool uring_init(unsigned depth) {
+			struct io_uring_params p;
+			std::memset(&p, 0, sizeof(p));
+			m_ring = uring_setup(depth, &p);
+			if (m_ring < 0) return false;
+
+			// the kernel can be new enough for io_uring but not for every opcode we use
+			std::vector<char> probe_mem(sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op), 0);
+			struct io_uring_probe* probe = (struct io_uring_probe*)&probe_mem[0];
+			if (uring_register(m_ring, IORING_REGISTER_PROBE, probe, 256) < 0) { ::close(m_ring); return false; }
+			const int ops[] = { IORING_OP_READ, IORING_OP_WRITE, IORING_OP_OPENAT, IORING_OP_CLOSE, IORING_OP_STATX };
+			for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+				if (ops[i] > probe->last_op || !(probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED)) { ::close(m_ring); return false; }
+			}
+
+			m_sq_entries = p.sq_entries;
+			m_cq_entries = p.cq_entries;
+			m_sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+			m_cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+			if (p.features & IORING_FEAT_SINGLE_MMAP) {
+				if (m_cq_size > m_sq_size) m_sq_size = m_cq_size;
+				m_cq_size = m_sq_size;
+			}
+
+			m_sq_ptr = mmap(NULL, m_sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQ_RING);
+			if (m_sq_ptr == MAP_FAILED) { ::close(m_ring); return false; }
+			if (p.features & IORING_FEAT_SINGLE_MMAP) m_cq_ptr = m_sq_ptr;
+			else {
+				m_cq_ptr = mmap(NULL, m_cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_CQ_RING);
+				if (m_cq_ptr == MAP_FAILED) { munmap(m_sq_ptr, m_sq_size); ::close(m_ring); return false; }
+			}
+			m_sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+			void* sqes = mmap(NULL, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQES);
+			if (sqes == MAP_FAILED) { uring_free(); return false; }
+			m_sqes = (struct io_uring_sqe*)sqes;
+
+			char* sq = (char*)m_sq_ptr;
+			m_sq_head = (unsigned*)(sq + p.sq_off.head);
+			m_sq_tail = (unsigned*)(sq + p.sq_off.tail);
+			m_sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+			m_sq_array = (unsigned*)(sq + p.sq_off.array);
+			char* cq = (char*)m_cq_ptr;
+			m_cq_head = (unsigned*)(cq + p.cq_off.head);
+			m_cq_tail = (unsigned*)(cq + p.cq_off.tail);
+			m_cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+			m_cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+			return true;
+		}
+
+		void uring_free() {
+			if (m_sqes) munmap(m_sqes, m_sqes_size);
+			if (m_cq_ptr && m_cq_ptr != m_sq_ptr) munmap(m_cq_ptr, m_cq_size);
+			if (m_sq_ptr) munmap(m_sq_ptr, m_sq_size);
+			if (m_ring >= 0) ::close(m_ring);
+			m_sqes = NULL;
+			m_sq_ptr = m_cq_ptr = NULL;
+			m_ring = -1;
+		}
+
+		// fills submission queue entries, returns how many were added
+		unsigned uring_fill() {
+			unsigned head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+			unsigned tail = *m_sq_tail;
+			unsigned added = 0;
+			// never have more in flight than the completion queue holds
+			while (!m_queued.empty() && tail - head < m_sq_entries && m_inflight < m_cq_entries) {
+				request* r = m_queued.front();
+				m_queued.pop_front();
+
+				unsigned idx = tail & *m_sq_mask;
+				struct io_uring_sqe* sqe = &m_sqes[idx];
+				std::memset(sqe, 0, sizeof(*sqe));
+				sqe->user_data = (unsigned long long)(uintptr_t)r;
+				switch (r->op) {
+				case op_read:
+				case op_write:
+					sqe->opcode = r->op == op_read ? IORING_OP_READ : IORING_OP_WRITE;
+					sqe->fd = r->fd;
+					sqe->addr = (unsigned long long)(uintptr_t)r->buf;
+					sqe->len = (unsigned)r->len;
+					sqe->off = r->offset;
+					break;
+				case op_open:
+					sqe->opcode = IORING_OP_OPENAT;
+					sqe->fd = AT_FDCWD;
+					sqe->addr = (unsigned long long)(uintptr_t)r->path.c_str();
+					sqe->len = (unsigned)r->mode;
+					sqe->open_flags = (unsigned)(r->flags | O_CLOEXEC);
+					break;
+				case op_close:
+					sqe->opcode = IORING_OP_CLOSE;
+					sqe->fd = r->fd;
+					break;
+				case op_stat:
+					sqe->opcode = IORING_OP_STATX;
+					sqe->fd = AT_FDCWD;
+					sqe->addr = (unsigned long long)(uintptr_t)r->path.c_str();
+					sqe->len = statx_mask((unsigned)r->mode);
+					sqe->off = (unsigned long long)(uintptr_t)&r->sx;
+					sqe->statx_flags = r->flags ? 0 : AT_SYMLINK_NOFOLLOW;
+					break;
+				}
+				m_sq_array[idx] = idx;
+				tail++;
+				added++;
+				m_inflight++;
+			}
+			__atomic_store_n(m_sq_tail, tail, __ATOMIC_RELEASE);
+			return added;
+		}
+
+		static unsigned statx_mask(unsigned fields) {
+			unsigned mask = 0;
+			if (fields & (status_type | status_perms)) mask |= STATX_TYPE | STATX_MODE;
+			if (fields & status_size) mask |= STATX_SIZE;
+			if (fields & status_mtime) mask |= STATX_MTIME;
+			if (fields & status_ino) mask |= STATX_INO;
+			if (fields & status_nlink) mask |= STATX_NLINK;
+			if (fields & status_blocks) mask |= STATX_BLOCKS;
+			return mask;
+		}
+
+		// moves finished requests from the completion queue into done
+		void uring_reap(std::vector<request*>& done) {
+			unsigned head = *m_cq_head;
+			unsigned tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+			while (head != tail) {
+				struct io_uring_cqe* cqe = &m_cqes[head & *m_cq_mask];
+				request* r = (request*)(uintptr_t)cqe->user_data;
+				r->result = cqe->res;
+				if (r->op == op_stat) {
+					if (cqe->res == 0) status_from_statx(r->sx, *r->st);
+					else {
+						memset(r->st, 0, sizeof(file_status));
+						r->st->type = (cqe->res == -ENOENT || cqe->res == -ENOTDIR) ? file_type_not_found : file_type_none;
+					}
+				}
+				done.push_back(r);
+				head++;
+				m_inflight--;
+			}
+			__atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+		}
+#endif
+
+		void queue(request* r) {
+			m_queued.push_back(r);
+			// keeps the batches big without letting the backlog grow without bound
+			if (m_queued.size() >= m_depth) submit();
+		}
+
+		static async_callback make_promise(std::future<long long>& f) {
+			std::shared_ptr<std::promise<long long> > p = std::make_shared<std::promise<long long> >();
+			f = p->get_future();
+			return [p](long long r) { p->set_value(r); };
+		}
+
+	public:
+		// queue_depth is the io_uring ring size and how many queued requests
+		// trigger an automatic submit. threads only matters for the pool.
+		async_engine(unsigned queue_depth = 256, backend b = backend_auto, unsigned threads = 0)
+			: m_inflight(0), m_depth(queue_depth ? queue_depth : 1), m_uring(false), m_stop(false) {
+#if defined(FS_HAVE_IO_URING)
+			m_ring = -1;
+			m_sqes = NULL;
+			m_sq_ptr = m_cq_ptr = NULL;
+			m_unsubmitted = 0;
+			if (b != backend_threads) m_uring = uring_init(m_depth);
+#else
+			(void)b;
+#endif
+			if (!m_uring) start_threads(threads);
+		}
+
+		// waits for everything in flight, their callbacks still run
+		~async_engine() {
+			drain();
+			{
+				std::lock_guard<std::mutex> lk(m_lock);
+				m_stop = true;
+			}
+			m_work_cv.notify_all();
+			for (size_t i = 0; i < m_threads.size(); i++) m_threads[i].join();
+#if defined(FS_HAVE_IO_URING)
+			if (m_uring) uring_free();
+#endif
+			for (size_t i = 0; i < m_free.size(); i++) delete m_free[i];
+		}
+
+		bool uses_io_uring() const { return m_uring; }
+
+		// queued but not yet completed
+		size_t pending() const { return m_queued.size() + m_inflight; }
+
+		// Largest transfer of a single read or write (linux's MAX_RW_COUNT, and it
+		// fits the 32 bit lengths of io_uring and ReadFile). Longer requests
+		// complete short, like read(2) and write(2) do.
+		static const size_t max_transfer = 0x7ffff000;
+
+		void read(int fd, void* buf, size_t len, unsigned long long offset, async_callback cb) {
+			if (len > max_transfer) len = max_transfer;
+			request* r = alloc(op_read, cb);
+			r->fd = fd; r->buf = buf; r->len = len; r->offset = offset;
+			queue(r);
+		}
+
+		void write(int fd, const void* buf, size_t len, unsigned long long offset, async_callback cb) {
+			if (len > max_transfer) len = max_transfer;
+			request* r = alloc(op_write, cb);
+			r->fd = fd; r->buf = const_cast<void*>(buf); r->len = len; r->offset = offset;
+			queue(r);
+		}
+
+		// flags and mode as for open(2), the result is the new descriptor
+		void open(const path& p, int flags, int mode, async_callback cb) {
+			request* r = alloc(op_open, cb);
+			r->path.assign(p.c_str());
+			r->flags = flags; r->mode = mode;
+			queue(r);
+		}
+
+		void close(int fd, async_callback cb) {
+			request* r = alloc(op_close, cb);
+			r->fd = fd;
+			queue(r);
+		}
+
+		// Symlinks are not followed unless asked to, out must stay valid until
+		// completion. fields is a status_fields mask like for fs::status.
+		void stat(const path& p, file_status* out, async_callback cb, unsigned fields = status_all, bool follow = false) {
+			request* r = alloc(op_stat, cb);
+			r->path.assign(p.c_str());
+			r->st = out;
+			r->mode = (int)fields;
+			r->flags = follow ? 1 : 0;
+			queue(r);
+		}
+
+		std::future<long long> read(int fd, void* buf, size_t len, unsigned long long offset) {
+			std::future<long long> f; read(fd, buf, len, offset, make_promise(f)); return f;
+		}
+		std::future<long long> write(int fd, const void* buf, size_t len, unsigned long long offset) {
+			std::future<long long> f; write(fd, buf, len, offset, make_promise(f)); return f;
+		}
+		std::future<long long> open(const path& p, int flags, int mode = 0644) {
+			std::future<long long> f; open(p, flags, mode, make_promise(f)); return f;
+		}
+		std::future<long long> close(int fd) {
+			std::future<long long> f; close(fd, make_promise(f)); return f;
+		}
+		std::future<long long> stat(const path& p, file_status* out, unsigned fields = status_all, bool follow = false) {
+			std::future<long long> f; stat(p, out, make_promise(f), fields, follow); return f;
+		}
+
+		// hands queued requests to the kernel or the pool, returns how many
+		size_t submit() {
+#if defined(FS_HAVE_IO_URING)
+			if (m_uring) {
+				unsigned n = uring_fill();
+				m_unsubmitted += n;
+				// On EAGAIN/EBUSY the entries stay in the ring, wait() hands them
+				// over again together with its wait for completions.
+				while (m_unsubmitted) {
+					int r = uring_enter(m_ring, m_unsubmitted, 0, 0);
+					if (r < 0 && errno == EINTR) continue;
+					if (r <= 0) break;
+					m_unsubmitted -= (unsigned)r;
+				}
+				return n;
+			}
+#endif
+			if (m_queued.empty()) return 0;
+			size_t n = m_queued.size();
+			{
+				std::lock_guard<std::mutex> lk(m_lock);
+				m_work.insert(m_work.end(), m_queued.begin(), m_queued.end());
+			}
+			m_queued.clear();
+			m_inflight += n;
+			if (n == 1) m_work_cv.notify_one();
+			else m_work_cv.notify_all();
+			return n;
+		}
+
+		// Submits and then waits until at least min_completions requests have
+		// finished (or nothing is left). Returns the number of callbacks run.
+		size_t wait(size_t min_completions = 1) {
+			std::vector<request*> done;
+			size_t total = 0;
+			for (;;) {
+				submit();
+#if defined(FS_HAVE_IO_URING)
+				if (m_uring) {
+					uring_reap(done);
+					if (done.empty() && total < min_completions && m_inflight) {
+						int r = uring_enter(m_ring, m_unsubmitted, 1, IORING_ENTER_GETEVENTS);
+						if (r >= 0) m_unsubmitted -= (unsigned)r;
+						else if (errno == EAGAIN || errno == EBUSY) {
+							// the kernel is short on resources, wait for what it already has
+							// or, if it has nothing, give it a moment before handing them over again
+							if (m_inflight > m_unsubmitted) uring_enter(m_ring, 0, 1, IORING_ENTER_GETEVENTS);
+							else std::this_thread::yield();
+						}
+						else if (errno != EINTR) break;
+						continue;
+					}
+				}
+				else
+#endif
+				{
+					std::unique_lock<std::mutex> lk(m_lock);
+					while (m_done.empty() && m_inflight && total < min_completions) m_done_cv.wait(lk);
+					done.swap(m_done);
+					m_inflight -= done.size();
+				}
+				// callbacks can queue more work, that counts towards the next round
+				total += complete(done);
+				if (total >= min_completions || (!m_inflight && m_queued.empty())) break;
+			}
+			return total;
+		}
+
+		// runs the callbacks of whatever has finished, without blocking
+		size_t poll() { return wait(0); }
+
+		// waits until every request, including ones queued by callbacks, is done
+		void drain() {
+			while (pending()) wait(pending());
+		}
+	};
+
+// (COPY_FILE_ASYNC)
+	// Copies src to dst through the engine with `depth` chunks in flight,
+	// reads and writes of different chunks overlap. done gets the number of
+	// bytes copied or -errno. The engine has to be polled until then.
+	inline void copy_file_async(async_engine& eng, const path& src, const path& dst, int options, async_callback done,
+		size_t chunk = 1 << 20, unsigned depth = 4) {
+
+		struct job : std::enable_shared_from_this<job> {
+			struct slot { unsigned long long off, end; };
+
+			async_engine& eng;
+			std::string src, dst;
+			int options;
+			async_callback done;
+			size_t chunk;
+			std::vector<char> buffer;
+			std::vector<slot> slots;
+			file_status st;
+			int in, out;
+			unsigned long long next, copied;
+			long long error;
+			unsigned active;
+
+			job(async_engine& e) : eng(e), in(-1), out(-1), next(0), copied(0), error(0), active(0) {}
+
+			void fail(long long err) { if (!error) error = err; }
+
+			void start() {
+				std::shared_ptr<job> self = shared_from_this();
+				eng.stat(src, &st, [self](long long r) {
+					if (r < 0) return self->finish(r);
+					if (self->st.type == file_type_directory) return self->finish(-EISDIR);
+
+					// mkdir isn't async on most kernels, do it like copy_file does
+					size_t pos = self->dst.find_last_of("/\\");
+					if (pos != std::string::npos && pos > 0) {
+						std::string dir = self->dst.substr(0, pos);
+						if (!exists(dir)) create_directories(dir);
+					}
+
+					self->eng.open(self->src, O_RDONLY, 0, [self](long long fd) {
+						if (fd < 0) return self->finish(fd);
+						self->in = (int)fd;
+						int flags = O_WRONLY | O_CREAT | ((self->options & copy_options_overwrite_existing) ? O_TRUNC : O_EXCL);
+						self->eng.open(self->dst, flags, 0666, [self](long long fd) {
+							if (fd < 0) return self->finish(fd);
+							self->out = (int)fd;
+							for (size_t i = 0; i < self->slots.size(); i++) self->refill(i);
+							if (!self->active) self->finish(0);
+						});
+					});
+				});
+			}
+
+			// gives slot i the next unclaimed chunk of the file
+			void refill(size_t i) {
+				if (error || next >= st.size) return;
+				slots[i].off = next;
+				slots[i].end = next + chunk < st.size ? next + chunk : st.size;
+				next = slots[i].end;
+				active++;
+				read_slot(i);
+			}
+
+			void read_slot(size_t i) {
+				std::shared_ptr<job> self = shared_from_this();
+				slot& s = slots[i];
+				char* buf = &buffer[i * chunk];
+				eng.read(in, buf, (size_t)(s.end - s.off), s.off, [self, i](long long r) {
+					if (r <= 0) {
+						// an early EOF means the file shrank while copying, stop there
+						if (r < 0) self->fail(r);
+						return self->slot_done(i);
+					}
+					self->write_slot(i, 0, (size_t)r);
+				});
+			}
+
+			void write_slot(size_t i, size_t from, size_t n) {
+				std::shared_ptr<job> self = shared_from_this();
+				slot& s = slots[i];
+				char* buf = &buffer[i * chunk];
+				eng.write(out, buf + from, n - from, s.off + from, [self, i, from, n](long long w) {
+					if (w <= 0) {
+						self->fail(w < 0 ? w : -EIO);
+						return self->slot_done(i);
+					}
+					if (from + (size_t)w < n) return self->write_slot(i, from + (size_t)w, n);
+
+					slot& s = self->slots[i];
+					s.off += n;
+					self->copied += n;
+					if (s.off < s.end && !self->error) return self->read_slot(i);
+					self->slot_done(i);
+				});
+			}
+
+			void slot_done(size_t i) {
+				active--;
+				refill(i);
+				if (!active) finish(0);
+			}
+
+			void finish(long long err) {
+				fail(err);
+				std::shared_ptr<job> self = shared_from_this();
+				unsigned closing = (in >= 0) + (out >= 0);
+				if (!closing) return report();
+				std::shared_ptr<unsigned> left = std::make_shared<unsigned>(closing);
+				async_callback closed = [self, left](long long r) {
+					if (r < 0) self->fail(r);
+					if (--*left == 0) self->report();
+				};
+				if (in >= 0) eng.close(in, closed);
+				if (out >= 0) eng.close(out, closed);
+				in = out = -1;
+			}
+
+			void report() {
+				async_callback cb;
+				cb.swap(done);
+				if (cb) cb(error ? error : (long long)copied);
+			}
+		};
+
+		if (!depth) depth = 1;
+		if (!chunk) chunk = 1 << 20;
+		std::shared_ptr<job> j = std::make_shared<job>(eng);
+		j->src = src.string();
+		j->dst = dst.string();
+		j->options = options;
+		j->done = done;
+		j->chunk = chunk;
+		j->buffer.resize(chunk * depth);
+		j->slots.resize(depth);
+		j->start();
+	}
+
+// (SCAN_DIRECTORY_ASYNC)
+	typedef std::function<void(const std::string& path, const file_status& st)> async_entry_callback;
+
+	// Lists dir (and its subdirectories when recursive) and stats every entry
+	// through the engine, so hundreds of stats are in flight at once. entry
+	// runs as each stat completes, done gets the number of entries or -errno
+	// if dir can't be opened. Listing itself is a plain readdir, there is
+	// no async getdents.
+	inline void scan_directory_async(async_engine& eng, const path& dir, bool recursive,
+		async_entry_callback entry, async_callback done) {
+
+		struct scan : std::enable_shared_from_this<scan> {
+			async_engine& eng;
+			bool recursive;
+			async_entry_callback entry;
+			async_callback done;
+			size_t outstanding;
+			long long count;
+
+			scan(async_engine& e) : eng(e), recursive(false), outstanding(0), count(0) {}
+
+			struct item {
+				std::string path;
+				file_status st;
+			};
+
+			bool list(const std::string& d) {
+				directory_reader r(d);
+				if (!r.is_open()) return false;
+				std::shared_ptr<scan> self = shared_from_this();
+				while (r.next()) {
+					std::shared_ptr<item> it = std::make_shared<item>();
+					it->path = d;
+					if (!it->path.empty() && it->path[it->path.size() - 1] != '/' && it->path[it->path.size() - 1] != '\\') it->path += PATH_SEP;
+					it->path += r.name();
+					outstanding++;
+					eng.stat(it->path, &it->st, [self, it](long long res) {
+						if (res == 0) {
+							self->count++;
+							if (self->entry) self->entry(it->path, it->st);
+							if (self->recursive && it->st.type == file_type_directory) self->list(it->path);
+						}
+						self->release();
+					});
+				}
+				return true;
+			}
+
+			void release() {
+				if (--outstanding) return;
+				async_callback cb;
+				cb.swap(done);
+				if (cb) cb(count);
+			}
+		};
+
+		std::shared_ptr<scan> s = std::make_shared<scan>(eng);
+		s->recursive = recursive;
+		s->entry = entry;
+		s->done = done;
+		s->outstanding = 1;		// held by the root listing itself
+		if (!s->list(dir.string())) {
+			s->outstanding = 0;
+			if (done) done(-ENOENT);
+			return;
+		}
+		s->release();
+	}
+
+// (STAT_MANY_ASYNC)
+	// stat_many from filesystem.hpp with the calls overlapped on the engine,
+	// statx batches through io_uring or the engine's thread pool. At most
+	// `window` requests are outstanding at a time. Blocks until all are
+	// done and returns how many succeeded.
+	inline size_t stat_many(async_engine& eng, const path* paths, size_t n, file_status* out,
+		unsigned fields = status_all, size_t window = 512) {
+		size_t ok = 0;
+		for (size_t i = 0; i < n; i++) {
+			while (eng.pending() >= window) eng.wait();
+			eng.stat(paths[i], &out[i], [&ok](long long r) { if (r == 0) ok++; }, fields, true);
+		}
+		eng.drain();
+		return ok;
+	}
+
+	inline size_t stat_many(async_engine& eng, const std::vector<path>& paths, std::vector<file_status>& out,
+		unsigned fields = status_all, size_t window = 512) {
+		out.resize(paths.size());
+		if (paths.empty()) return 0;
+		return stat_many(eng, &paths[0], paths.size(), &out[0], fields, window);
+	}
+
+};
+
+#endif
@@ -0,0 +1,442 @@
+/*
+
+	Copyright (C) Nico Rajala 2025
+
+	fs_cache.hpp
+	Content addressed file cache with a deduplicating copy, on top of
+	filesystem.hpp and fs_hash.hpp.
+
+	Every file that goes through the cache is stored once under
+	<root>/objects/<first 2 hex digits>/<xxh64 hex>-<size>. Copying a file
+	out of the cache doesn't rewrite its bytes if the filesystem can help:
+		- reflink (FICLONE on Linux btrfs/xfs, clonefile on macOS) shares
+		  the extents copy-on-write, the copy behaves like a normal file
+		- hardlink makes dst the very same inode as the cache object. Cheap
+		  and works everywhere, but dst is read-only and must never be
+		  modified in place (replace it instead), or the cache is poisoned
+		- plain copy as the last resort
+
+	Hashing is skipped for files that haven't changed. <root>/index maps
+	(device, inode, size, mtime) to the content hash and is loaded on
+	open() and written back by save() or the destructor.
+
+	The object name is a 64-bit hash plus the size, fine for build assets,
+	not for content someone could pick adversarially.
+
+	Not thread safe, use one content_cache per thread or lock around it.
+
+	Usage:
+		fs::content_cache cache(".cache/assets");
+		cache.copy("build/stage1/wall.png", "build/stage2/wall.png");
+		cache.copy("build/stage1", "build/stage2", fs::copy_options_recursive);
+		cache.save();
+
+	Table of contents: () - functions [] - classes/structs/other
+		[CACHE_LINK_MODE]
+		[CONTENT_CACHE]
+
+*/
+
+#ifndef FS_CACHE_HPP
+#define FS_CACHE_HPP
+
+#include "filesystem.hpp"
+#include "fs_hash.hpp"
+
+#include <stdint.h>
+#include <cstdio>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#else
+	#include <sys/ioctl.h>
+	#if defined(__linux__) && !defined(FICLONE)
+		#define FICLONE _IOW(0x94, 9, int)
+	#endif
+	#if defined(__APPLE__)
+		#include <sys/clonefile.h>
+	#endif
+#endif
+
+namespace fs {
+
+// [CACHE_LINK_MODE]
+	// How copy() materializes the destination from the cache object
+	enum cache_link_mode {
+		cache_link_auto,		// reflink, then hardlink, then copy
+		cache_link_reflink,
+		cache_link_hardlink,
+		cache_link_copy,
+		cache_link_none			// dst already had the same content, nothing written
+	};
+
+// [CONTENT_CACHE]
+	class content_cache {
+		struct file_key {
+			unsigned long long dev, ino, size;
+			long long mtime;
+			bool operator==(const file_key& o) const {
+				return ino == o.ino && dev == o.dev && size == o.size && mtime == o.mtime;
+			}
+		};
+		struct key_hash {
+			size_t operator()(const file_key& k) const {
+				uint64_t h = k.ino * 0x9E3779B185EBCA87ULL;
+				h ^= (k.dev + (uint64_t)k.mtime) * 0xC2B2AE3D27D4EB4FULL;
+				h ^= k.size;
+				return (size_t)(h ^ (h >> 29));
+			}
+		};
+		// on-disk index record, the file is a header followed by these
+		struct record {
+			uint64_t dev, ino, size;
+			int64_t mtime;
+			uint64_t hash;
+		};
+
+		static const uint32_t index_magic = 0x4346534E;	// "NSFC"
+		static const uint32_t index_version = 1;
+
+		std::unordered_map<file_key, uint64_t, key_hash> m_index;
+		path m_root;
+		bool m_open;
+		bool m_dirty;
+
+		content_cache(const content_cache&);
+		content_cache& operator=(const content_cache&);
+
+		static bool identify(const path& p, file_key& k, bool& is_dir) {
+#if defined(_WIN32)
+			HANDLE h = CreateFileA(p.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+				NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+			if (h == INVALID_HANDLE_VALUE) return false;
+			BY_HANDLE_FILE_INFORMATION info;
+			BOOL ok = GetFileInformationByHandle(h, &info);
+			CloseHandle(h);
+			if (!ok) return false;
+			k.dev = info.dwVolumeSerialNumber;
+			k.ino = ((unsigned long long)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+			k.size = ((unsigned long long)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+			k.mtime = (long long)(((unsigned long long)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime);
+			is_dir = (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+			struct stat st;
+			if (::stat(p.c_str(), &st) != 0) return false;
+			file_status fst;
+			status_from_stat(st, fst);
+			k.dev = fst.dev;
+			k.ino = fst.ino;
+			k.size = fst.size;
+			k.mtime = fst.mtime;
+			is_dir = fst.type == file_type_directory;
+#endif
+			return true;
+		}
+
+		static void remove_file(const path& p) {
+#if defined(_WIN32)
+			SetFileAttributesA(p.c_str(), FILE_ATTRIBUTE_NORMAL);
+			DeleteFileA(p.c_str());
+#else
+			::unlink(p.c_str());
+#endif
+		}
+
+		static bool reflink(const path& from, const path& to) {
+#if defined(__linux__) && defined(FICLONE)
+			int in = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+			if (in < 0) return false;
+			int out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+			if (out < 0) { ::close(in); return false; }
+			bool ok = ioctl(out, FICLONE, in) == 0;
+			::close(in);
+			::close(out);
+			if (!ok) ::unlink(to.c_str());
+			return ok;
+#elif defined(__APPLE__)
+			return clonefile(from.c_str(), to.c_str(), 0) == 0;
+#else
+			(void)from; (void)to;
+			return false;
+#endif
+		}
+
+		static bool hardlink(const path& from, const path& to) {
+#if defined(_WIN32)
+			return CreateHardLinkA(to.c_str(), from.c_str(), NULL) != 0;
+#else
+			return ::link(from.c_str(), to.c_str()) == 0;
+#endif
+		}
+
+		// copies the bytes and hashes them on the way if h isn't NULL
+		static bool copy_bytes(const path& from, const path& to, uint64_t* h) {
+			const size_t bufsize = 1 << 20;
+			std::vector<unsigned char> buf(bufsize);
+			hasher hs;
+			FILE* in = fopen(from.c_str(), "rb");
+			if (!in) return false;
+			FILE* out = fopen(to.c_str(), "wb");
+			if (!out) { fclose(in); return false; }
+			setvbuf(in, NULL, _IONBF, 0);
+			setvbuf(out, NULL, _IONBF, 0);
+			bool ok = true;
+			for (;;) {
+				size_t got = fread(&buf[0], 1, bufsize, in);
+				if (got) {
+					if (h) hs.update(&buf[0], got);
+					if (fwrite(&buf[0], 1, got, out) != got) { ok = false; break; }
+				}
+				if (got < bufsize) { ok = !ferror(in); break; }
+			}
+			fclose(in);
+			if (fclose(out) != 0) ok = false;
+			if (!ok) { remove_file(to); return false; }
+			if (h) *h = hs.digest();
+			return true;
+		}
+
+		static void make_read_only(const path& p) {
+#if defined(_WIN32)
+			SetFileAttributesA(p.c_str(), FILE_ATTRIBUTE_READONLY);
+#else
+			::chmod(p.c_str(), 0444);
+#endif
+		}
+
+		void remember(const file_key& k, uint64_t h) {
+			std::pair<std::unordered_map<file_key, uint64_t, key_hash>::iterator, bool> r = m_index.insert(std::make_pair(k, h));
+			if (!r.second) {
+				if (r.first->second == h) return;
+				r.first->second = h;
+			}
+			m_dirty = true;
+		}
+
+		bool load_index() {
+			path name = m_root / "index";
+			FILE* f = fopen(name.c_str(), "rb");
+			if (!f) return true;	// fresh cache
+			uint32_t head[2];
+			uint64_t count;
+			bool ok = fread(head, sizeof(head), 1, f) == 1 && fread(&count, sizeof(count), 1, f) == 1
+				&& head[0] == index_magic && head[1] == index_version;
+			// the count comes off the disk, it has to fit the file before anything is allocated for it
+			unsigned long long size = file_size(name);
+			const unsigned long long header = sizeof(head) + sizeof(count);
+			if (ok && (size == (unsigned long long)-1 || size < header || count > (size - header) / sizeof(record))) ok = false;
+			if (ok) {
+				std::vector<record> recs((size_t)count);
+				if (count && fread(&recs[0], sizeof(record), (size_t)count, f) != count) ok = false;
+				for (size_t i = 0; ok && i < recs.size(); i++) {
+					file_key k = { recs[i].dev, recs[i].ino, recs[i].size, recs[i].mtime };
+					m_index[k] = recs[i].hash;
+				}
+			}
+			fclose(f);
+			// a damaged or old index only costs re-hashing, so just drop it
+			if (!ok) m_index.clear();
+			return true;
+		}
+
+		bool copy_tree(const path& src, const path& dst, int options) {
+			if (!create_directories(dst)) return false;
+			directory_reader rd(src);
+			if (!rd.is_open()) return false;
+			bool ok = true;
+			while (rd.next()) {
+				path from = src / rd.name();
+				path to = dst / rd.name();
+				file_type t = rd.type();
+				bool is_dir = t == file_type_directory;
+				if (t == file_type_unknown || t == file_type_symlink) {
+					file_key k;
+					if (!identify(from, k, is_dir)) { ok = false; continue; }
+				}
+				if (is_dir) {
+					if (!copy_tree(from, to, options)) ok = false;
+				}
+				else if (!copy(from, to, options)) ok = false;
+			}
+			return ok;
+		}
+
+	public:
+		content_cache() : m_open(false), m_dirty(false) {}
+		explicit content_cache(const path& root) : m_open(false), m_dirty(false) { open(root); }
+		~content_cache() { close(); }
+
+		// creates the cache directory if needed and loads its index
+		bool open(const path& root) {
+			close();
+			if (!create_directories(root / "objects")) return false;
+			m_root = root;
+			m_open = true;
+			return load_index();
+		}
+
+		void close() {
+			if (!m_open) return;
+			save();
+			m_index.clear();
+			m_open = false;
+		}
+
+		bool is_open() const { return m_open; }
+		const path& root() const { return m_root; }
+		size_t indexed_files() const { return m_index.size(); }
+
+		// writes the index if anything changed, atomically through a temp file
+		bool save() {
+			if (!m_open) return false;
+			if (!m_dirty) return true;
+			path final_name = m_root / "index";
+			path tmp = temp_path_for(final_name);
+			FILE* f = fopen(tmp.c_str(), "wb");
+			if (!f) return false;
+			uint32_t head[2] = { index_magic, index_version };
+			uint64_t count = m_index.size();
+			bool ok = fwrite(head, sizeof(head), 1, f) == 1 && fwrite(&count, sizeof(count), 1, f) == 1;
+			std::vector<record> recs;
+			recs.reserve(m_index.size());
+			for (std::unordered_map<file_key, uint64_t, key_hash>::const_iterator it = m_index.begin(); it != m_index.end(); ++it) {
+				record r = { it->first.dev, it->first.ino, it->first.size, it->first.mtime, it->second };
+				recs.push_back(r);
+			}
+			if (ok && !recs.empty()) ok = fwrite(&recs[0], sizeof(record), recs.size(), f) == recs.size();
+			if (fclose(f) != 0) ok = false;
+			if (!ok || !replace_file(tmp, final_name)) {
+				remove_file(tmp);
+				return false;
+			}
+			m_dirty = false;
+			return true;
+		}
+
+		path object_path(uint64_t hash, unsigned long long size) const {
+			std::string hex = hash_to_hex(hash);
+			char sz[24];
+			snprintf(sz, sizeof(sz), "-%llu", size);
+			return m_root / "objects" / hex.substr(0, 2) / (hex + sz);
+		}
+
+		// content hash of a file, from the index if it hasn't changed
+		bool hash(const path& file, uint64_t& out, unsigned long long* size = NULL) {
+			file_key k;
+			bool is_dir;
+			if (!identify(file, k, is_dir) || is_dir) return false;
+			if (size) *size = k.size;
+			std::unordered_map<file_key, uint64_t, key_hash>::const_iterator it = m_index.find(k);
+			if (it != m_index.end()) {
+				out = it->second;
+				return true;
+			}
+			if (!hash_file(file, out)) return false;
+			// only trust the hash if the file didn't change while we read it
+			file_key after;
+			if (identify(file, after, is_dir) && after == k) remember(k, out);
+			return true;
+		}
+
+		// makes sure the content of file is in the cache, optionally returns
+		// the object and the hash of what was stored
+		bool store(const path& file, path* object = NULL, uint64_t* content = NULL) {
+			if (!m_open) return false;
+			uint64_t h;
+			unsigned long long size;
+			if (!hash(file, h, &size)) return false;
+			path obj = object_path(h, size);
+			if (!exists(obj)) {
+				if (!create_directories(obj.parent_path())) return false;
+				path tmp = temp_path_for(obj);
+				uint64_t copied;
+				if (reflink(file, tmp)) {
+					if (!hash_file(tmp, copied)) { remove_file(tmp); return false; }
+				}
+				else if (!copy_bytes(file, tmp, &copied)) return false;
+
+				// file changed between hashing and copying, file it under what we actually got
+				if (copied != h) {
+					file_key k;
+					bool is_dir;
+					if (!identify(tmp, k, is_dir)) { remove_file(tmp); return false; }
+					h = copied;
+					size = k.size;
+					obj = object_path(h, size);
+					create_directories(obj.parent_path());
+				}
+				make_read_only(tmp);
+				if (!replace_file(tmp, obj)) {
+					remove_file(tmp);
+					if (!exists(obj)) return false;		// lost a race to an identical object, that's fine
+				}
+			}
+			file_key k;
+			bool is_dir;
+			if (identify(obj, k, is_dir)) remember(k, h);
+			if (object) *object = obj;
+			if (content) *content = h;
+			return true;
+		}
+
+		// Copies src to dst through the cache. Directories need
+		// copy_options_recursive, an existing dst copy_options_overwrite_existing
+		// unless it already has the same content, in which case it's left alone.
+		bool copy(const path& src, const path& dst, int options = copy_options_none,
+			cache_link_mode mode = cache_link_auto, cache_link_mode* used = NULL) {
+			if (!m_open) return false;
+			file_key sk;
+			bool is_dir;
+			if (!identify(src, sk, is_dir)) return false;
+			if (is_dir) {
+				if (!(options & copy_options_recursive)) return false;
+				return copy_tree(src, dst, options);
+			}
+
+			path obj;
+			uint64_t h;
+			if (!store(src, &obj, &h)) return false;
+
+			file_key dk;
+			bool dst_dir;
+			if (identify(dst, dk, dst_dir)) {
+				if (dst_dir) return false;
+				uint64_t dh;
+				std::unordered_map<file_key, uint64_t, key_hash>::const_iterator it = m_index.find(dk);
+				if (it != m_index.end()) dh = it->second;
+				else if (dk.size != sk.size || !hash(dst, dh)) dh = ~h;
+				if (dh == h && dk.size == sk.size) {
+					if (used) *used = cache_link_none;
+					return true;
+				}
+				if (!(options & copy_options_overwrite_existing)) return false;
+			}
+			else if (!dst.parent_path().empty() && !create_directories(dst.parent_path())) return false;
+
+			// build next to dst and rename over it, so a failure leaves dst as it was
+			path tmp = temp_path_for(dst);
+			cache_link_mode got = cache_link_none;
+			if ((mode == cache_link_auto || mode == cache_link_reflink) && reflink(obj, tmp)) got = cache_link_reflink;
+			else if ((mode == cache_link_auto || mode == cache_link_hardlink) && hardlink(obj, tmp)) got = cache_link_hardlink;
+			else if ((mode == cache_link_auto || mode == cache_link_copy) && copy_bytes(obj, tmp, NULL)) got = cache_link_copy;
+			if (got == cache_link_none) return false;
+
+#if !defined(_WIN32)
+			// the object is read-only, a private copy gets normal permissions back
+			if (got != cache_link_hardlink) ::chmod(tmp.c_str(), 0644);
+#else
+			if (got != cache_link_hardlink) SetFileAttributesA(tmp.c_str(), FILE_ATTRIBUTE_NORMAL);
+#endif
+			if (!replace_file(tmp, dst)) {
+				remove_file(tmp);
+				return false;
+			}
+			if (identify(dst, dk, dst_dir)) remember(dk, h);
+			if (used) *used = got;
+			return true;
+		}
+	};
+
+};
+
+#endif // FS_CACHE_HPP
@@ -0,0 +1,415 @@
+/*
+
+	Copyright (C) Nico Rajala 2025
+
+	fs_copy.hpp
+	Chunked, resumable, checksummed copy of large files.
+
+	Needs C++11 (std::function).
+
+	The data goes to "<dst>.part" in fixed size chunks. Every few chunks the
+	part file is fdatasync'ed and the XXH64 of each chunk that is now on
+	disk is appended to "<dst>.part.journal", together with the size and
+	mtime of the source it came from. An interrupted copy (crash, kill,
+	progress callback returning false) leaves both files behind, and the
+	next call with copy_resume reads the journaled prefix back, keeps every
+	chunk up to the first one whose hash doesn't match, and copies only the
+	rest. If the source changed in between, it starts over.
+
+	The whole-file checksum is computed from the chunk while it is still
+	in the buffer, and matches xxhsum -H1 of the file. copy_verify reads
+	the finished copy back and compares. When everything is done the part
+	file is renamed over dst, so dst never holds a half copy.
+
+	Usage:
+		fs::chunked_copy_options opt;
+		opt.flags = fs::copy_resume | fs::copy_checksum | fs::copy_preallocate;
+		opt.progress = [](unsigned long long done, unsigned long long total) {
+			printf("\r%llu / %llu", done, total);
+			return true;		// false stops, the copy can be resumed later
+		};
+		fs::chunked_copy_result r;
+		if (!fs::copy_file_chunked("data/big.bin", "backup/big.bin", opt, &r)) ...
+		printf("%s\n", fs::hash_to_hex(r.checksum).c_str());
+
+	Table of contents: () - functions [] - classes/structs/other
+		[CHUNKED_COPY_OPTIONS]
+		(COPY_FILE_CHUNKED)
+
+*/
+
+#ifndef FS_COPY_HPP
+#define FS_COPY_HPP
+
+#include "filesystem.hpp"
+#include "fs_hash.hpp"
+
+#include <stdint.h>
+#include <functional>
+
+namespace fs {
+
+// [CHUNKED_COPY_OPTIONS]
+	enum chunked_copy_flags {
+		copy_none = 0,
+		copy_resume = 1 << 0,		// continue an interrupted copy to the same dst
+		copy_checksum = 1 << 1,		// XXH64 of the whole file in chunked_copy_result::checksum
+		copy_verify = 1 << 2,		// read the copy back and compare, implies copy_checksum
+		copy_preallocate = 1 << 3,	// reserve the full size up front (fallocate), less fragmentation
+		copy_durable = 1 << 4		// fsync the file and its directory before returning
+	};
+
+	// return false to stop, the copy stays resumable
+	typedef std::function<bool(unsigned long long done, unsigned long long total)> copy_progress;
+
+	struct chunked_copy_options {
+		int flags;					// chunked_copy_flags
+		int options;				// copy_options, only copy_options_overwrite_existing matters
+		size_t chunk_size;			// rounded up to io_alignment
+		unsigned sync_every;		// chunks between fdatasync + journal update, bounds lost work
+		copy_progress progress;		// called after every chunk
+
+		chunked_copy_options() : flags(copy_resume), options(copy_options_none), chunk_size(8 << 20), sync_every(8) {}
+	};
+
+	struct chunked_copy_result {
+		unsigned long long size;		// of the source
+		unsigned long long copied;		// bytes copied by this call
+		unsigned long long resumed;		// bytes kept from an earlier attempt
+		uint64_t checksum;				// with copy_checksum / copy_verify
+		int error;						// errno of the failure, ECANCELED if progress said stop
+
+		chunked_copy_result() : size(0), copied(0), resumed(0), checksum(0), error(0) {}
+	};
+
+// (COPY_FILE_CHUNKED)
+	namespace copy_detail {
+
+		const char journal_magic[4] = { 'N', 'S', 'C', 'J' };
+		const uint32_t journal_version = 1;
+		const size_t block_size = 1 << 20;		// I/O unit inside a chunk, small enough to stay in L2
+
+		// what the chunks in a journal were copied from
+		struct journal_header {
+			char magic[4];
+			uint32_t version;
+			uint64_t chunk_size;
+			uint64_t src_size;
+			int64_t src_mtime;
+		};
+
+		inline int open_rw(const path& p, bool truncate) {
+#if defined(_WIN32)
+			return _open(p.c_str(), _O_RDWR | _O_CREAT | _O_BINARY | (truncate ? _O_TRUNC : 0), _S_IREAD | _S_IWRITE);
+#else
+			return ::open(p.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+#endif
+		}
+
+		inline void close_fd(int fd) {
+#if defined(_WIN32)
+			_close(fd);
+#else
+			::close(fd);
+#endif
+		}
+
+		// reads up to n bytes at offset, short only at the end of the file
+		inline long long read_full(int fd, void* dst, size_t n, unsigned long long offset) {
+			unsigned char* p = static_cast<unsigned char*>(dst);
+			size_t total = 0;
+#if defined(_WIN32)
+			if (_lseeki64(fd, (long long)offset, SEEK_SET) < 0) return -1;
+#endif
+			while (total < n) {
+#if defined(_WIN32)
+				int got = _read(fd, p + total, (unsigned)(n - total > 0x40000000 ? 0x40000000 : n - total));
+#else
+				ssize_t got = ::pread(fd, p + total, n - total, (off_t)(offset + total));
+				if (got < 0 && errno == EINTR) continue;
+#endif
+				if (got < 0) return -1;
+				if (got == 0) break;
+				total += (size_t)got;
+			}
+			return (long long)total;
+		}
+
+		inline bool write_full(int fd, const void* src, size_t n, unsigned long long offset) {
+			const unsigned char* p = static_cast<const unsigned char*>(src);
+#if defined(_WIN32)
+			if (_lseeki64(fd, (long long)offset, SEEK_SET) < 0) return false;
+#endif
+			while (n) {
+#if defined(_WIN32)
+				int put = _write(fd, p, (unsigned)(n > 0x40000000 ? 0x40000000 : n));
+#else
+				ssize_t put = ::pwrite(fd, p, n, (off_t)offset);
+				if (put < 0 && errno == EINTR) continue;
+#endif
+				if (put <= 0) return false;
+				p += put;
+				n -= (size_t)put;
+				offset += (unsigned long long)put;
+			}
+			return true;
+		}
+
+		inline bool data_sync(int fd) {
+#if defined(_WIN32)
+			return _commit(fd) == 0;
+#elif defined(__APPLE__)
+			return fcntl(fd, F_FULLFSYNC) == 0 || ::fsync(fd) == 0;
+#elif defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+			return ::fdatasync(fd) == 0;
+#else
+			return ::fsync(fd) == 0;
+#endif
+		}
+
+		inline bool truncate_fd(int fd, unsigned long long size) {
+#if defined(_WIN32)
+			return _chsize_s(fd, (long long)size) == 0;
+#else
+			return ::ftruncate(fd, (off_t)size) == 0;
+#endif
+		}
+
+		// Blocks for the whole file without changing its size, so a partial
+		// copy still looks partial. Only where the filesystem can do it cheaply.
+		inline void preallocate(int fd, unsigned long long size) {
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+			if (size) fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)size);
+#else
+			(void)fd;
+			(void)size;
+#endif
+		}
+
+		inline void drop_cache(int fd) {
+#if defined(POSIX_FADV_DONTNEED)
+			posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#else
+			(void)fd;
+#endif
+		}
+
+		// Number of chunks in the journal at jpath that still match the part
+		// file, feeding their bytes into hs. 0 if the journal is missing, from
+		// another source or chunk size, or the first chunk is already bad.
+		inline size_t verify_prefix(const path& jpath, int part, const journal_header& want, unsigned char* buf, size_t bufsize,
+			hasher* hs, std::vector<uint64_t>& hashes) {
+			hashes.clear();
+			FILE* f = fopen(jpath.c_str(), "rb");
+			if (!f) return 0;
+			journal_header h;
+			bool ok = fread(&h, sizeof(h), 1, f) == 1 && std::memcmp(h.magic, journal_magic, 4) == 0 &&
+				h.version == journal_version && h.chunk_size == want.chunk_size &&
+				h.src_size == want.src_size && h.src_mtime == want.src_mtime;
+			uint64_t v;
+			// a torn last record is just shorter than 8 bytes and gets dropped here
+			while (ok && fread(&v, sizeof(v), 1, f) == 1) hashes.push_back(v);
+			fclose(f);
+			if (!ok) {
+				hashes.clear();
+				return 0;
+			}
+
+			size_t good = 0;
+			for (; good < hashes.size(); good++) {
+				unsigned long long off = (unsigned long long)good * want.chunk_size;
+				if (off >= want.src_size) break;
+				size_t n = (size_t)(want.src_size - off < want.chunk_size ? want.src_size - off : want.chunk_size);
+				// hs only takes the chunk once it checks out
+				hasher ch, whole = hs ? *hs : hasher();
+				size_t done = 0;
+				while (done < n) {
+					size_t b = n - done < bufsize ? n - done : bufsize;
+					if (read_full(part, buf, b, off + done) != (long long)b) break;
+					ch.update(buf, b);
+					if (hs) whole.update(buf, b);
+					done += b;
+				}
+				if (done < n || ch.digest() != hashes[good]) break;
+				if (hs) *hs = whole;
+			}
+			hashes.resize(good);
+			return good;
+		}
+
+		inline bool write_journal(const path& jpath, const journal_header& h, const std::vector<uint64_t>& hashes) {
+			FILE* f = fopen(jpath.c_str(), "wb");
+			if (!f) return false;
+			bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+			if (ok && !hashes.empty()) ok = fwrite(&hashes[0], sizeof(uint64_t), hashes.size(), f) == hashes.size();
+			if (fclose(f) != 0) ok = false;
+			return ok;
+		}
+
+		inline bool append_journal(FILE* f, const uint64_t* hashes, size_t n) {
+			if (!n) return true;
+			return fwrite(hashes, sizeof(uint64_t), n, f) == n && fflush(f) == 0;
+		}
+
+	};
+
+	// Copies src to dst in chunks, see the top of this file. Returns false
+	// with result->error set on failure; unless the failure was with the
+	// source itself, dst.part and its journal stay for a later copy_resume.
+	inline bool copy_file_chunked(const path& src, const path& dst, const chunked_copy_options& opt = chunked_copy_options(),
+		chunked_copy_result* result = NULL) {
+		chunked_copy_result local;
+		chunked_copy_result& r = result ? *result : local;
+		r = chunked_copy_result();
+
+		file_status sst;
+		if ((r.error = stat_at(cwd_fd, src.c_str(), sst, status_type | status_size | status_mtime | status_perms)) != 0) return false;
+		if (sst.type == file_type_directory) { r.error = EISDIR; return false; }
+		if (!(opt.options & copy_options_overwrite_existing) && exists(dst)) { r.error = EEXIST; return false; }
+		r.size = sst.size;
+
+		int flags = opt.flags;
+		if (flags & copy_verify) flags |= copy_checksum;
+		size_t chunk = (opt.chunk_size + io_alignment - 1) & ~(io_alignment - 1);
+		if (!chunk) chunk = io_alignment;
+		unsigned sync_every = opt.sync_every ? opt.sync_every : 1;
+
+		file_reader in(src, io_alignment, io_sequential);
+		if (!in.is_open()) { r.error = in.error() ? in.error() : errno; return false; }
+
+		path part(dst.string() + ".part");
+		path jpath(dst.string() + ".part.journal");
+
+		copy_detail::journal_header jh;
+		std::memcpy(jh.magic, copy_detail::journal_magic, 4);
+		jh.version = copy_detail::journal_version;
+		jh.chunk_size = chunk;
+		jh.src_size = sst.size;
+		jh.src_mtime = sst.mtime;
+
+		size_t block = chunk < copy_detail::block_size ? chunk : copy_detail::block_size;
+		unsigned char* buf = io_alloc(block);
+		if (!buf) { r.error = ENOMEM; return false; }
+
+		bool resume = (flags & copy_resume) && exists(part);
+		int out = copy_detail::open_rw(part, !resume);
+		if (out < 0) {
+			r.error = errno;
+			io_free(buf);
+			return false;
+		}
+
+		hasher whole;
+		std::vector<uint64_t> hashes;
+		size_t first = 0;
+		if (resume) first = copy_detail::verify_prefix(jpath, out, jh, buf, block, (flags & copy_checksum) ? &whole : NULL, hashes);
+
+		// the journal is rewritten with just the chunks that checked out,
+		// anything after them gets overwritten below
+		FILE* journal = NULL;
+		if (flags & copy_resume) {
+			if (copy_detail::write_journal(jpath, jh, hashes)) journal = fopen(jpath.c_str(), "ab");
+		}
+		if (flags & copy_preallocate) copy_detail::preallocate(out, sst.size);
+
+		unsigned long long off = (unsigned long long)first * chunk;
+		r.resumed = off < sst.size ? off : sst.size;
+		std::vector<uint64_t> pending;
+		bool ok = true;
+
+		while (off < sst.size) {
+			size_t n = (size_t)(sst.size - off < chunk ? sst.size - off : chunk);
+			// the chunk goes through in blocks that stay in cache between the read,
+			// the hashing and the write
+			hasher ch;
+			for (size_t done = 0; ok && done < n; ) {
+				size_t b = n - done < block ? n - done : block;
+				long long got = in.read_at(buf, b, off + done);
+				if (got != (long long)b) {
+					// shorter than it was a moment ago, or a read error
+					r.error = got < 0 ? errno : EIO;
+					ok = false;
+					break;
+				}
+				if (flags & copy_checksum) whole.update(buf, b);
+				if (journal) ch.update(buf, b);
+				if (!copy_detail::write_full(out, buf, b, off + done)) {
+					r.error = errno ? errno : EIO;
+					ok = false;
+					break;
+				}
+				done += b;
+			}
+			if (!ok) break;
+			if (journal) pending.push_back(ch.digest());
+			off += n;
+			r.copied += n;
+
+			// data first, then the journal entries that describe it
+			if (journal && (pending.size() >= sync_every || off == sst.size)) {
+				if (!copy_detail::data_sync(out) || !copy_detail::append_journal(journal, &pending[0], pending.size())) {
+					r.error = errno ? errno : EIO;
+					ok = false;
+					break;
+				}
+				pending.clear();
+			}
+			if (opt.progress && !opt.progress(off, sst.size)) {
+				// keep what is already written resumable
+				if (journal && !pending.empty() && copy_detail::data_sync(out))
+					copy_detail::append_journal(journal, &pending[0], pending.size());
+				r.error = ECANCELED;
+				ok = false;
+				break;
+			}
+		}
+		if (journal) fclose(journal);
+		in.close();
+
+		if (ok && !copy_detail::truncate_fd(out, sst.size)) { r.error = errno; ok = false; }
+		if (ok && (flags & (copy_durable | copy_verify)) && !copy_detail::data_sync(out)) { r.error = errno; ok = false; }
+		if (ok && (flags & copy_checksum)) r.checksum = whole.digest();
+
+		if (ok && (flags & copy_verify)) {
+			// synced above, so dropping the cached pages makes this read the disk
+			copy_detail::drop_cache(out);
+			hasher check;
+			for (unsigned long long at = 0; at < sst.size; ) {
+				size_t n = (size_t)(sst.size - at < block ? sst.size - at : block);
+				if (copy_detail::read_full(out, buf, n, at) != (long long)n) { r.error = EIO; ok = false; break; }
+				check.update(buf, n);
+				at += n;
+			}
+			if (ok && check.digest() != r.checksum) {
+				// the part file is bad, resuming from it would keep the damage
+				r.error = EIO;
+				ok = false;
+				copy_detail::close_fd(out);
+				out = -1;
+				::remove(part.c_str());
+				::remove(jpath.c_str());
+			}
+		}
+#if !defined(_WIN32)
+		if (ok) fchmod(out, (mode_t)sst.perms);
+#endif
+		if (out >= 0) copy_detail::close_fd(out);
+		io_free(buf);
+		if (!ok) return false;
+
+		if (!replace_file(part, dst, (flags & copy_durable) != 0)) {
+			r.error = errno;
+			return false;
+		}
+		if (flags & copy_resume) ::remove(jpath.c_str());
+		if (flags & copy_durable) {
+			std::string d = dst.string();
+			size_t slash = d.find_last_of("/\\");
+			sync_directory(path(slash == std::string::npos ? std::string(".") : d.substr(0, slash + (slash == 0 ? 1 : 0))));
+		}
+		return true;
+	}
+
+};
+
+#endif // FS_COPY_HPP
@@ -0,0 +1,532 @@
+/*
+
+	Copyright (C) Nico Rajala 2025
+
+	fs_glob.hpp
+	Shell style glob over directory trees, on top of filesystem.hpp.
+
+	Needs C++11 (std::function, std::thread).
+
+	A pattern is compiled once into a glob_matcher. The leading components
+	without wildcards become the base directory and are never listed, and
+	the walk only opens a directory if some part of the pattern can still
+	match below it. Components that are plain names again after a wildcard
+	are checked with one stat instead of listing the directory. Examples
+	are in the comments at (GLOB), the patterns don't fit in this block.
+
+	Syntax, per path component:
+		*		any run of characters except the separator
+		?		any one character
+		[abc]	one of a, b, c. Ranges [a-z], negation [!a-z] or [^a-z]
+		{a,b}	either alternative, inside one component
+		**		as a whole component: any number of directories, including none
+		\x		x literally (not on windows, where the backslash is a separator)
+	Names starting with '.' are only matched by patterns that spell the
+	dot out, unless glob_dotfiles is given. Symlinks to directories are
+	matched but not descended into unless glob_follow_symlinks is given.
+
+	Usage:
+		std::vector<std::string> files;
+		fs::glob(pattern, files);
+
+		fs::glob_matcher m(pattern, fs::glob_files_only);
+		if (m.match(some_path)) ...
+		fs::glob(m, [](fs::path_view p, fs::file_type t) { ... }, 8);
+
+	Table of contents: () - functions [] - classes/structs/other
+		[GLOB_SEGMENT]
+		[GLOB_MATCHER]
+		(GLOB)
+
+*/
+
+#ifndef FS_GLOB_HPP
+#define FS_GLOB_HPP
+
+#include "filesystem.hpp"
+#include "fs_jobs.hpp"
+
+#include <stdint.h>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+
+namespace fs {
+
+	enum glob_flags {
+		glob_none = 0,
+		glob_files_only = 1 << 0,		// don't report directories
+		glob_dirs_only = 1 << 1,		// only report directories
+		glob_dotfiles = 1 << 2,			// wildcards match a leading '.'
+		glob_follow_symlinks = 1 << 3,	// descend into symlinked directories
+		glob_unsorted = 1 << 4			// skip sorting the results of glob(pattern, out)
+	};
+
+// [GLOB_SEGMENT]
+	// One path component of a pattern, compiled. Most real patterns are a
+	// literal, "*suffix", "prefix*" or "*", those skip the general matcher.
+	class glob_segment {
+	public:
+		enum kind {
+			seg_literal,		// no wildcards
+			seg_any,			// "*"
+			seg_prefix,			// "abc*"
+			seg_suffix,			// "*.png"
+			seg_general,
+			seg_globstar		// "**"
+		};
+
+	private:
+		kind m_kind;
+		std::string m_text;					// the literal / prefix / suffix, or the raw alternative
+		std::vector<glob_segment> m_alts;	// from {a,b}, matched if any of them does
+		bool m_explicit_dot;				// starts with a literal '.'
+
+		static bool is_wild(char c) { return c == '*' || c == '?' || c == '['; }
+
+		// [...] at p (just past '['), advances p past ']'
+		static bool match_class(const char*& p, const char* end, char c) {
+			bool neg = false;
+			if (p < end && (*p == '!' || *p == '^')) { neg = true; p++; }
+			bool hit = false;
+			bool first = true;
+			while (p < end && (*p != ']' || first)) {
+				first = false;
+				char lo = *p++;
+#if !defined(_WIN32)
+				if (lo == '\\' && p < end) lo = *p++;
+#endif
+				char hi = lo;
+				if (p + 1 < end && *p == '-' && p[1] != ']') {
+					hi = p[1];
+					p += 2;
+				}
+				if ((unsigned char)c >= (unsigned char)lo && (unsigned char)c <= (unsigned char)hi) hit = true;
+			}
+			if (p < end) p++;	// ']'
+			return hit != neg;
+		}
+
+		// classic single-star backtracking matcher, linear for patterns
+		// with one '*' and never worse than O(n*m)
+		static bool match_general(const char* p, const char* pend, const char* s, const char* send) {
+			const char* star_p = NULL;
+			const char* star_s = NULL;
+			while (s < send) {
+				if (p < pend) {
+					char c = *p;
+					if (c == '*') {
+						star_p = ++p;
+						star_s = s;
+						continue;
+					}
+					if (c == '?') { p++; s++; continue; }
+					if (c == '[') {
+						const char* q = p + 1;
+						if (match_class(q, pend, *s)) { p = q; s++; continue; }
+					}
+					else {
+#if !defined(_WIN32)
+						if (c == '\\' && p + 1 < pend) c = *++p;
+#endif
+						if (c == *s) { p++; s++; continue; }
+					}
+				}
+				if (!star_p) return false;
+				p = star_p;
+				s = ++star_s;
+			}
+			while (p < pend && *p == '*') p++;
+			return p == pend;
+		}
+
+		static std::string unescape(const std::string& s) {
+#if defined(_WIN32)
+			return s;
+#else
+			std::string out;
+			for (size_t i = 0; i < s.size(); i++) {
+				if (s[i] == '\\' && i + 1 < s.size()) i++;
+				out += s[i];
+			}
+			return out;
+#endif
+		}
+
+		void compile_single(const std::string& text) {
+			m_text = text;
+			m_explicit_dot = !text.empty() && text[0] == '.';
+			if (text == "**") { m_kind = seg_globstar; return; }
+
+			size_t stars = 0, wild = 0;
+			bool escaped = false;
+			for (size_t i = 0; i < text.size(); i++) {
+#if !defined(_WIN32)
+				if (text[i] == '\\') { escaped = true; i++; continue; }
+#endif
+				if (is_wild(text[i])) wild++;
+				if (text[i] == '*') stars++;
+			}
+			if (!wild) { m_kind = seg_literal; m_text = unescape(text); return; }
+			if (escaped || wild != stars) { m_kind = seg_general; return; }
+			if (text == "*") { m_kind = seg_any; m_text.clear(); return; }
+			if (stars == 1 && text[text.size() - 1] == '*') { m_kind = seg_prefix; m_text = text.substr(0, text.size() - 1); return; }
+			if (stars == 1 && text[0] == '*') { m_kind = seg_suffix; m_text = text.substr(1); return; }
+			m_kind = seg_general;
+		}
+
+	public:
+		glob_segment() : m_kind(seg_literal), m_explicit_dot(false) {}
+
+		explicit glob_segment(const std::string& text) : m_kind(seg_literal), m_explicit_dot(false) {
+			// {a,b,c} expands into alternatives (one level, no nesting)
+			size_t open = std::string::npos;
+			for (size_t i = 0; i < text.size(); i++) {
+#if !defined(_WIN32)
+				if (text[i] == '\\') { i++; continue; }
+#endif
+				if (text[i] == '{') { open = i; break; }
+			}
+			size_t close = open == std::string::npos ? open : text.find('}', open);
+			if (close == std::string::npos) {
+				compile_single(text);
+				return;
+			}
+			std::string head = text.substr(0, open), tail = text.substr(close + 1);
+			size_t start = open + 1;
+			for (size_t i = open + 1; i <= close; i++) {
+				if (i == close || text[i] == ',') {
+					m_alts.push_back(glob_segment(head + text.substr(start, i - start) + tail));
+					start = i + 1;
+				}
+			}
+			m_kind = seg_general;
+			m_explicit_dot = true;
+			for (size_t i = 0; i < m_alts.size(); i++)
+				if (!m_alts[i].m_explicit_dot) m_explicit_dot = false;
+		}
+
+		kind type() const { return m_kind; }
+		bool is_literal() const { return m_kind == seg_literal && m_alts.empty(); }
+		const std::string& literal() const { return m_text; }
+
+		bool match(const char* s, size_t n, bool dotfiles) const {
+			if (!m_alts.empty()) {
+				for (size_t i = 0; i < m_alts.size(); i++)
+					if (m_alts[i].match(s, n, dotfiles)) return true;
+				return false;
+			}
+			if (n && s[0] == '.' && !dotfiles && !m_explicit_dot && m_kind != seg_literal) return false;
+			size_t t = m_text.size();
+			switch (m_kind) {
+			case seg_literal: return n == t && std::memcmp(s, m_text.data(), n) == 0;
+			case seg_any: return true;
+			case seg_prefix: return n >= t && std::memcmp(s, m_text.data(), t) == 0;
+			case seg_suffix: return n >= t && std::memcmp(s + n - t, m_text.data(), t) == 0;
+			case seg_globstar: return true;
+			default: return match_general(m_text.data(), m_text.data() + m_text.size(), s, s + n);
+			}
+		}
+	};
+
+// [GLOB_MATCHER]
+	class glob_matcher {
+		std::string m_base;						// leading literal components, "" for the current directory
+		std::vector<glob_segment> m_segs;		// the rest
+		int m_flags;
+
+		static bool is_sep_char(char c) {
+#if defined(_WIN32)
+			return c == '/' || c == '\\';
+#else
+			return c == '/';
+#endif
+		}
+
+	public:
+		// matcher states are positions in m_segs, small sets of them travel down the walk
+		typedef std::vector<uint32_t> state_set;
+
+		glob_matcher() : m_flags(0) {}
+		explicit glob_matcher(const std::string& pattern, int flags = glob_none) : m_flags(0) { compile(pattern, flags); }
+
+		void compile(const std::string& pattern, int flags = glob_none) {
+			m_flags = flags;
+			m_base.clear();
+			m_segs.clear();
+
+			std::vector<std::string> parts;
+			bool absolute = !pattern.empty() && is_sep_char(pattern[0]);
+			size_t i = 0;
+			while (i < pattern.size()) {
+				while (i < pattern.size() && is_sep_char(pattern[i])) i++;
+				size_t j = i;
+				while (j < pattern.size() && !is_sep_char(pattern[j])) {
+#if !defined(_WIN32)
+					if (pattern[j] == '\\' && j + 1 < pattern.size()) j++;
+#endif
+					j++;
+				}
+				if (j > i) parts.push_back(pattern.substr(i, j - i));
+				i = j;
+			}
+
+			size_t k = 0;
+			if (absolute) m_base = std::string(1, PATH_SEP);
+			// "." components at the front just mean "here"
+			while (k < parts.size() && parts[k] == ".") k++;
+			for (; k + 1 < parts.size(); k++) {
+				glob_segment seg(parts[k]);
+				if (!seg.is_literal()) break;
+				if (!m_base.empty() && !is_sep_char(m_base[m_base.size() - 1])) m_base += PATH_SEP;
+				m_base += seg.literal();
+			}
+			for (; k < parts.size(); k++) {
+				// "**/**" is the same as "**"
+				if (parts[k] == "**" && !m_segs.empty() && m_segs.back().type() == glob_segment::seg_globstar) continue;
+				m_segs.push_back(glob_segment(parts[k]));
+			}
+		}
+
+		const std::string& base() const { return m_base; }
+		int flags() const { return m_flags; }
+		size_t segments() const { return m_segs.size(); }
+		const glob_segment& segment(size_t i) const { return m_segs[i]; }
+		bool accepting(uint32_t s) const { return s == m_segs.size(); }
+
+		// adds s and, past any "**", the positions reachable without consuming a name
+		void add_state(state_set& set, uint32_t s) const {
+			for (;;) {
+				if (std::find(set.begin(), set.end(), s) == set.end()) set.push_back(s);
+				if (s < m_segs.size() && m_segs[s].type() == glob_segment::seg_globstar) s++;
+				else return;
+			}
+		}
+
+		state_set initial() const {
+			state_set s;
+			add_state(s, 0);
+			return s;
+		}
+
+		// States after consuming the name of a directory entry. Returns true if
+		// the entry itself matches (some state reaches the end).
+		bool step(const state_set& from, const char* name, size_t n, state_set& to) const {
+			to.clear();
+			bool dot = (m_flags & glob_dotfiles) != 0;
+			bool hit = false;
+			for (size_t i = 0; i < from.size(); i++) {
+				uint32_t s = from[i];
+				if (s >= m_segs.size()) continue;
+				const glob_segment& seg = m_segs[s];
+				if (seg.type() == glob_segment::seg_globstar) {
+					// ** consumes the name and stays, but never descends into hidden dirs
+					if (dot || !n || name[0] != '.') add_state(to, s);
+					continue;
+				}
+				if (seg.match(name, n, dot)) {
+					add_state(to, s + 1);
+					if (s + 1 == m_segs.size()) hit = true;
+				}
+			}
+			// a trailing "**" accepts everything below it
+			for (size_t i = 0; !hit && i < to.size(); i++) if (accepting(to[i])) hit = true;
+			return hit;
+		}
+
+		// true if something below a directory reached with states can still match
+		bool can_descend(const state_set& states) const {
+			for (size_t i = 0; i < states.size(); i++) if (!accepting(states[i])) return true;
+			return false;
+		}
+
+		// All remaining states want one specific name, so the names can be
+		// looked up directly instead of listing the directory.
+		bool only_literals(const state_set& states, std::vector<const std::string*>& names) const {
+			names.clear();
+			for (size_t i = 0; i < states.size(); i++) {
+				if (accepting(states[i])) continue;
+				const glob_segment& seg = m_segs[states[i]];
+				if (!seg.is_literal()) return false;
+				names.push_back(&seg.literal());
+			}
+			return !names.empty();
+		}
+
+		// Matches a whole path against the pattern without touching the
+		// filesystem. The path has to start with base() the way it was written.
+		bool match(path_view p) const {
+			const char* s = p.data();
+			const char* end = s + p.size();
+			if (!m_base.empty()) {
+				if (p.size() < m_base.size() || std::memcmp(s, m_base.data(), m_base.size()) != 0) return false;
+				s += m_base.size();
+				if (s < end && !is_sep_char(*s) && !is_sep_char(m_base[m_base.size() - 1])) return false;
+			}
+			state_set cur = initial(), next;
+			bool hit = m_segs.empty() && s == end;
+			while (s < end) {
+				while (s < end && is_sep_char(*s)) s++;
+				if (s == end) break;
+				const char* e = s;
+				while (e < end && !is_sep_char(*e)) e++;
+				hit = step(cur, s, (size_t)(e - s), next);
+				cur.swap(next);
+				if (cur.empty()) return false;
+				s = e;
+			}
+			return hit;
+		}
+	};
+
+// (GLOB)
+	// fs::glob("assets/**/*.png", files)			every png under assets
+	// fs::glob("src/*/test/*.{cpp,hpp}", files)	lists src, then stats src/<x>/test
+	// fs::glob("**", files, fs::glob_dirs_only)	all directories below here
+	typedef std::function<void(path_view path, file_type type)> glob_callback;
+
+	namespace glob_detail {
+
+		struct job {
+			std::string dir;					// path to list, as the results should be spelled
+			glob_matcher::state_set states;
+		};
+
+		inline std::string join(const std::string& dir, const char* name, size_t n) {
+			std::string p;
+			p.reserve(dir.size() + n + 1);
+			p = dir;
+			if (!p.empty() && p[p.size() - 1] != '/' && p[p.size() - 1] != PATH_SEP) p += PATH_SEP;
+			p.append(name, n);
+			return p;
+		}
+
+		inline bool wanted(const glob_matcher& m, file_type t) {
+			if ((m.flags() & glob_files_only) && t == file_type_directory) return false;
+			if ((m.flags() & glob_dirs_only) && t != file_type_directory) return false;
+			return true;
+		}
+
+		// resolves unknown types and, with glob_follow_symlinks, symlinks to directories
+		inline file_type resolve(const glob_matcher& m, const std::string& p, file_type t) {
+			if (t == file_type_unknown || (t == file_type_symlink && (m.flags() & glob_follow_symlinks))) {
+				file_status st;
+				bool follow = t == file_type_symlink;
+				if (stat_at(cwd_fd, p.c_str(), st, status_type, follow) == 0) {
+					if (t == file_type_symlink && st.type != file_type_directory) return file_type_symlink;
+					return st.type;
+				}
+			}
+			return t;
+		}
+
+		// Processes one directory: reports matches, returns subdirectories to visit in more
+		inline void visit(const glob_matcher& m, const job& j, const glob_callback& cb, std::vector<job>& more) {
+			std::vector<const std::string*> names;
+			glob_matcher::state_set next;
+
+			if (m.only_literals(j.states, names)) {
+				// no listing, just look the names up
+				for (size_t i = 0; i < names.size(); i++) {
+					const std::string& n = *names[i];
+					std::string p = join(j.dir, n.data(), n.size());
+					file_status st;
+					if (stat_at(cwd_fd, p.c_str(), st, status_type, false) != 0) continue;
+					file_type t = resolve(m, p, st.type);
+					bool hit = m.step(j.states, n.data(), n.size(), next);
+					if (hit && wanted(m, t)) cb(path_view(p), t);
+					if (t == file_type_directory && m.can_descend(next)) {
+						job c;
+						c.dir.swap(p);
+						c.states.swap(next);
+						more.push_back(c);
+					}
+				}
+				return;
+			}
+
+			directory_reader rd(path(j.dir.empty() ? std::string(".") : j.dir));
+			while (rd.next()) {
+				const char* name = rd.name();
+				size_t n = std::strlen(name);
+				bool hit = m.step(j.states, name, n, next);
+				bool descend = m.can_descend(next);
+				if (!hit && !descend) continue;
+
+				std::string p = join(j.dir, name, n);
+				file_type t = rd.type();
+				if (t == file_type_unknown || t == file_type_symlink) t = resolve(m, p, t);
+				if (hit && wanted(m, t)) cb(path_view(p), t);
+				if (descend && t == file_type_directory) {
+					job c;
+					c.dir.swap(p);
+					c.states.swap(next);
+					more.push_back(c);
+				}
+			}
+		}
+
+	};
+
+	// Calls cb for every match. With threads > 1 (0 = one per core) the
+	// directories are spread over a pool and cb runs on those threads,
+	// concurrently and in no particular order.
+	inline void glob(const glob_matcher& m, const glob_callback& cb, unsigned threads = 1) {
+		glob_detail::job root;
+		root.dir = m.base();
+		root.states = m.initial();
+
+		if (m.segments() == 0) {
+			// no wildcards at all, the pattern is a single path
+			file_status st;
+			if (!root.dir.empty() && stat_at(cwd_fd, root.dir.c_str(), st, status_type, false) == 0) {
+				file_type t = glob_detail::resolve(m, root.dir, st.type);
+				if (glob_detail::wanted(m, t)) cb(path_view(root.dir), t);
+			}
+			return;
+		}
+		if (!root.dir.empty() && !is_directory(path(root.dir))) return;
+
+		if (pool_threads(threads) <= 1) {
+			std::vector<glob_detail::job> stack(1, root), more;
+			while (!stack.empty()) {
+				glob_detail::job j;
+				j.dir.swap(stack.back().dir);
+				j.states.swap(stack.back().states);
+				stack.pop_back();
+				more.clear();
+				glob_detail::visit(m, j, cb, more);
+				// reversed so the walk goes depth first in listing order
+				for (size_t i = more.size(); i-- > 0; ) stack.push_back(more[i]);
+			}
+			return;
+		}
+
+		job_pool<glob_detail::job> jobs;
+		jobs.push(root);
+		jobs.run(threads, [&](unsigned, glob_detail::job& j, std::vector<glob_detail::job>& more) {
+			glob_detail::visit(m, j, cb, more);
+		});
+	}
+
+	// Collects the matching paths, sorted unless glob_unsorted is set
+	inline size_t glob(const glob_matcher& m, std::vector<std::string>& out, unsigned threads = 1) {
+		std::mutex lock;
+		size_t before = out.size();
+		glob(m, [&](path_view p, file_type) {
+			if (threads == 1) { out.push_back(p.string()); return; }
+			std::lock_guard<std::mutex> g(lock);
+			out.push_back(p.string());
+		}, threads);
+		if (!(m.flags() & glob_unsorted)) std::sort(out.begin() + before, out.end());
+		return out.size() - before;
+	}
+
+	inline size_t glob(const std::string& pattern, std::vector<std::string>& out, int flags = glob_none, unsigned threads = 1) {
+		glob_matcher m(pattern, flags);
+		return glob(m, out, threads);
+	}
+
+};
+
+#endif // FS_GLOB_HPP
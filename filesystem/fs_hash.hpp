@@ -0,0 +1,255 @@
+/*
+
+	Copyright (C) Nico Rajala 2025
+
+	fs_hash.hpp
+	Fast non-cryptographic content hashing of buffers and files (XXH64).
+
+	XXH64 keeps four independent 64-bit accumulators, so the hot loop eats
+	32 bytes per iteration with no dependency between lanes and runs close
+	to memory bandwidth without needing SIMD intrinsics. The output matches
+	the reference xxHash implementation, so hashes can be checked against
+	xxhsum -H1.
+
+	Good enough to tell files apart, not to defend against someone crafting
+	collisions on purpose.
+
+	Usage:
+		uint64_t h = fs::hash_bytes(data, size);
+
+		fs::hasher hs;
+		hs.update(chunk1, n1);
+		hs.update(chunk2, n2);
+		uint64_t h = hs.digest();
+
+		uint64_t h;
+		if (fs::hash_file("assets/wall.png", h)) ...
+
+	Table of contents: () - functions [] - classes/structs/other
+		[HASHER]
+		(HASH_BYTES)
+		(HASH_FILE)
+		(HASH_TO_HEX)
+
+*/
+
+#ifndef FS_HASH_HPP
+#define FS_HASH_HPP
+
+#include "filesystem.hpp"
+
+#include <stdint.h>
+#include <cstdio>
+
+namespace fs {
+
+// [HASHER]
+	// Streaming XXH64. update() can be fed any chunk sizes, the result only
+	// depends on the concatenated bytes.
+	class hasher {
+		static const uint64_t P1 = 0x9E3779B185EBCA87ULL;
+		static const uint64_t P2 = 0xC2B2AE3D27D4EB4FULL;
+		static const uint64_t P3 = 0x165667B19E3779F9ULL;
+		static const uint64_t P4 = 0x85EBCA77C2B2CA63ULL;
+		static const uint64_t P5 = 0x27D4EB2F165667C5ULL;
+
+		uint64_t m_v[4];
+		uint64_t m_seed;
+		uint64_t m_total;
+		unsigned char m_buf[32];	// tail that didn't fill a whole stripe yet
+		size_t m_buffered;
+
+		static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+		static uint64_t read64(const unsigned char* p) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+			uint64_t v = 0;
+			for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+			return v;
+#else
+			uint64_t v;
+			memcpy(&v, p, 8);
+			return v;
+#endif
+		}
+		static uint32_t read32(const unsigned char* p) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+			return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+#else
+			uint32_t v;
+			memcpy(&v, p, 4);
+			return v;
+#endif
+		}
+
+		static uint64_t round(uint64_t acc, uint64_t input) {
+			acc += input * P2;
+			acc = rotl(acc, 31);
+			return acc * P1;
+		}
+		static uint64_t merge(uint64_t acc, uint64_t v) {
+			acc ^= round(0, v);
+			return acc * P1 + P4;
+		}
+
+		// consumes whole 32 byte stripes, returns how many bytes it ate
+		size_t stripes(const unsigned char* p, size_t n) {
+			uint64_t v1 = m_v[0], v2 = m_v[1], v3 = m_v[2], v4 = m_v[3];
+			const unsigned char* start = p;
+			const unsigned char* limit = p + (n & ~(size_t)31);
+			while (p < limit) {
+				v1 = round(v1, read64(p));
+				v2 = round(v2, read64(p + 8));
+				v3 = round(v3, read64(p + 16));
+				v4 = round(v4, read64(p + 24));
+				p += 32;
+			}
+			m_v[0] = v1; m_v[1] = v2; m_v[2] = v3; m_v[3] = v4;
+			return (size_t)(p - start);
+		}
+
+	public:
+		explicit hasher(uint64_t seed = 0) { reset(seed); }
+
+		void reset(uint64_t seed = 0) {
+			m_seed = seed;
+			m_v[0] = seed + P1 + P2;
+			m_v[1] = seed + P2;
+			m_v[2] = seed;
+			m_v[3] = seed - P1;
+			m_total = 0;
+			m_buffered = 0;
+		}
+
+		void update(const void* data, size_t n) {
+			const unsigned char* p = static_cast<const unsigned char*>(data);
+			m_total += n;
+
+			if (m_buffered) {
+				size_t take = 32 - m_buffered;
+				if (take > n) take = n;
+				memcpy(m_buf + m_buffered, p, take);
+				m_buffered += take;
+				p += take;
+				n -= take;
+				if (m_buffered < 32) return;
+				stripes(m_buf, 32);
+				m_buffered = 0;
+			}
+
+			size_t done = stripes(p, n);
+			p += done;
+			n -= done;
+			if (n) {
+				memcpy(m_buf, p, n);
+				m_buffered = n;
+			}
+		}
+
+		uint64_t digest() const {
+			uint64_t h;
+			if (m_total >= 32) {
+				h = rotl(m_v[0], 1) + rotl(m_v[1], 7) + rotl(m_v[2], 12) + rotl(m_v[3], 18);
+				h = merge(h, m_v[0]);
+				h = merge(h, m_v[1]);
+				h = merge(h, m_v[2]);
+				h = merge(h, m_v[3]);
+			}
+			else {
+				h = m_seed + P5;
+			}
+			h += m_total;
+
+			const unsigned char* p = m_buf;
+			size_t n = m_buffered;
+			while (n >= 8) {
+				h ^= round(0, read64(p));
+				h = rotl(h, 27) * P1 + P4;
+				p += 8;
+				n -= 8;
+			}
+			if (n >= 4) {
+				h ^= (uint64_t)read32(p) * P1;
+				h = rotl(h, 23) * P2 + P3;
+				p += 4;
+				n -= 4;
+			}
+			while (n) {
+				h ^= (uint64_t)(*p) * P5;
+				h = rotl(h, 11) * P1;
+				p++;
+				n--;
+			}
+
+			h ^= h >> 33;
+			h *= P2;
+			h ^= h >> 29;
+			h *= P3;
+			h ^= h >> 32;
+			return h;
+		}
+	};
+
+// (HASH_BYTES)
+	inline uint64_t hash_bytes(const void* data, size_t n, uint64_t seed = 0) {
+		hasher hs(seed);
+		hs.update(data, n);
+		return hs.digest();
+	}
+
+// (HASH_FILE)
+	// Streams the file through a 1 MB buffer. Returns false if the file
+	// couldn't be opened or a read failed.
+	inline bool hash_file(const path& p, uint64_t& out, uint64_t seed = 0) {
+		const size_t bufsize = 1 << 20;
+		std::vector<unsigned char> buf(bufsize);
+		hasher hs(seed);
+#if defined(_WIN32)
+		FILE* f = fopen(p.c_str(), "rb");
+		if (!f) return false;
+		setvbuf(f, NULL, _IONBF, 0);
+		for (;;) {
+			size_t got = fread(&buf[0], 1, bufsize, f);
+			if (got) hs.update(&buf[0], got);
+			if (got < bufsize) break;
+		}
+		bool ok = !ferror(f);
+		fclose(f);
+		if (!ok) return false;
+#else
+		int fd = open(p.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) return false;
+	#if defined(POSIX_FADV_SEQUENTIAL)
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	#endif
+		for (;;) {
+			ssize_t got = read(fd, &buf[0], bufsize);
+			if (got < 0) {
+				if (errno == EINTR) continue;
+				close(fd);
+				return false;
+			}
+			if (got == 0) break;
+			hs.update(&buf[0], (size_t)got);
+		}
+		close(fd);
+#endif
+		out = hs.digest();
+		return true;
+	}
+
+// (HASH_TO_HEX)
+	// 16 lowercase hex digits, the same form xxhsum prints
+	inline std::string hash_to_hex(uint64_t h) {
+		static const char digits[] = "0123456789abcdef";
+		char s[16];
+		for (int i = 15; i >= 0; i--) {
+			s[i] = digits[h & 15];
+			h >>= 4;
+		}
+		return std::string(s, 16);
+	}
+
+};
+
+#endif // FS_HASH_HPP
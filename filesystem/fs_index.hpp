@@ -0,0 +1,547 @@
+/*
+
+	Copyright (C) Nico Rajala 2025
+
+	fs_index.hpp
+	Parallel directory tree scanner that builds a compact in-memory
+	index of a tree (path, size, mtime, type) on top of filesystem.hpp.
+
+	Needs C++11 (std::thread).
+
+	Entries don't own strings. Every file name is interned once into a
+	single string_pool and an entry only stores the id of its name and the
+	index of its parent directory, so the full path is the chain of names
+	up to the root. Lookups by path don't allocate either:
+		- find() hashes the path and probes an open addressing table
+		- find_sorted() binary searches the entries in path order
+
+	Usage:
+		fs::file_index idx;
+		idx.scan("assets");
+		size_t i = idx.find("assets/textures/wall.png");
+		if (i != fs::file_index::npos) idx[i].size ...
+
+	Table of contents: () - functions [] - classes/structs/other
+		[STRING_POOL]
+		[INDEX_ENTRY]
+		[FILE_INDEX]
+
+*/
+
+#ifndef FS_INDEX_HPP
+#define FS_INDEX_HPP
+
+#include "filesystem.hpp"
+#include "fs_jobs.hpp"
+
+#include <stdint.h>
+#include <algorithm>
+#include <mutex>
+#include <functional>
+
+namespace fs {
+
+	// FNV-1a, streamed so a path hash can be continued from its parents hash
+	inline uint64_t fnv1a_continue(uint64_t h, const char* s, size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			h ^= (unsigned char)s[i];
+			h *= 1099511628211ULL;
+		}
+		return h;
+	}
+
+	// "\" is a legal file name character outside of windows
+	inline bool is_sep(char c) {
+#if defined(_WIN32)
+		return c == '/' || c == '\\';
+#else
+		return c == '/';
+#endif
+	}
+
+// [STRING_POOL]
+	// Append only string storage with interning. Strings live back to back in
+	// one buffer and are referred to by their offset, so the ids stay valid
+	// while the buffer grows. Each string is prefixed with its length.
+	class string_pool {
+		std::vector<char> m_data;
+		std::vector<uint32_t> m_table;		// open addressing, 0 = empty, else id
+		size_t m_count;
+
+		uint32_t hash(const char* s, size_t n) const {
+			uint64_t h = fnv1a_continue(14695981039346656037ULL, s, n);
+			return (uint32_t)(h ^ (h >> 32));
+		}
+
+		void rehash(size_t cap) {
+			std::vector<uint32_t> old;
+			old.swap(m_table);
+			m_table.assign(cap, 0);
+			for (size_t i = 0; i < old.size(); i++) {
+				if (!old[i]) continue;
+				size_t slot = hash(str(old[i]), length(old[i])) & (cap - 1);
+				while (m_table[slot]) slot = (slot + 1) & (cap - 1);
+				m_table[slot] = old[i];
+			}
+		}
+
+	public:
+		string_pool() : m_count(0) {
+			m_data.push_back(0);		// keeps id 0 free for "empty slot"
+			m_table.assign(1024, 0);
+		}
+
+		uint32_t intern(const char* s, size_t n) {
+			if ((m_count + 1) * 2 > m_table.size()) rehash(m_table.size() * 2);
+
+			size_t mask = m_table.size() - 1;
+			size_t slot = hash(s, n) & mask;
+			while (uint32_t id = m_table[slot]) {
+				if (length(id) == n && std::memcmp(str(id), s, n) == 0) return id;
+				slot = (slot + 1) & mask;
+			}
+
+			uint32_t len = (uint32_t)n;
+			size_t at = m_data.size();
+			m_data.resize(at + sizeof(len) + n + 1);
+			std::memcpy(&m_data[at], &len, sizeof(len));
+			std::memcpy(&m_data[at + sizeof(len)], s, n);
+			m_data[at + sizeof(len) + n] = 0;
+
+			uint32_t id = (uint32_t)(at + sizeof(len));
+			m_table[slot] = id;
+			m_count++;
+			return id;
+		}
+		uint32_t intern(const char* s) { return intern(s, std::strlen(s)); }
+
+		const char* str(uint32_t id) const { return &m_data[id]; }
+		size_t length(uint32_t id) const {
+			uint32_t len;
+			std::memcpy(&len, &m_data[id - sizeof(len)], sizeof(len));
+			return len;
+		}
+
+		size_t count() const { return m_count; }
+		size_t bytes() const { return m_data.size() + m_table.size() * sizeof(uint32_t); }
+
+		void clear() {
+			m_data.assign(1, 0);
+			m_table.assign(1024, 0);
+			m_count = 0;
+		}
+	};
+
+// [INDEX_ENTRY]
+	struct index_entry {
+		uint32_t parent;	// index of the parent directory, file_index::npos for the root
+		uint32_t name;		// id in the index string pool
+		uint64_t hash;		// FNV-1a of the full path, see file_index::hash_path
+		uint64_t size;
+		int64_t mtime;		// nanoseconds since the unix epoch
+		file_type type;
+	};
+
+// [FILE_INDEX]
+	class file_index {
+	public:
+		static const size_t npos = 0xffffffff;
+
+	private:
+		string_pool m_names;
+		std::vector<index_entry> m_entries;
+		std::vector<uint32_t> m_table;		// hash lookup, npos = empty
+		std::vector<uint32_t> m_sorted;		// entry indices in path order
+		bool m_root_has_sep;
+
+		// one unit of work for the scanner threads
+		struct scan_job {
+			uint32_t dir;
+			std::string dirpath;
+		};
+
+		// entry as read by a scanner thread, before it gets merged into the index
+		struct scanned_entry {
+			uint32_t name_off, name_len;
+			uint64_t size;
+			int64_t mtime;
+			file_type type;
+		};
+
+		// one scanner thread's buffers, reused from directory to directory
+		struct scan_buffers {
+			std::vector<scanned_entry> batch;
+			std::vector<char> names;
+		};
+
+		uint64_t child_hash(uint32_t parent, const char* name, size_t n) const {
+			uint64_t h = m_entries[parent].hash;
+			if (!(parent == 0 && m_root_has_sep)) h = fnv1a_continue(h, "/", 1);
+			return fnv1a_continue(h, name, n);
+		}
+
+		// appends one scanned directory to the index, must hold the merge lock
+		void merge(uint32_t dir, const std::vector<scanned_entry>& batch, const std::vector<char>& names,
+			const std::string& dirpath, std::vector<scan_job>& jobs) {
+			for (size_t i = 0; i < batch.size(); i++) {
+				const scanned_entry& se = batch[i];
+				const char* n = &names[se.name_off];
+
+				index_entry e;
+				e.parent = dir;
+				e.name = m_names.intern(n, se.name_len);
+				e.hash = child_hash(dir, n, se.name_len);
+				e.size = se.size;
+				e.mtime = se.mtime;
+				e.type = se.type;
+				m_entries.push_back(e);
+
+				if (se.type == file_type_directory) {
+					scan_job job;
+					job.dir = (uint32_t)(m_entries.size() - 1);
+					job.dirpath = dirpath;
+					job.dirpath += PATH_SEP;
+					job.dirpath.append(n, se.name_len);
+					jobs.push_back(job);
+				}
+			}
+		}
+
+		static void read_directory(const std::string& dirpath, std::vector<scanned_entry>& batch, std::vector<char>& names) {
+			batch.clear();
+			names.clear();
+			directory_reader r(dirpath);
+			while (r.next()) {
+				const char* n = r.name();
+				scanned_entry se;
+				se.name_len = (uint32_t)std::strlen(n);
+				se.name_off = (uint32_t)names.size();
+				names.insert(names.end(), n, n + se.name_len);
+				se.size = 0;
+				se.mtime = 0;
+				se.type = r.type();
+				unsigned long long size;
+				long long mtime;
+				if (r.stat(se.type, size, mtime)) {
+					se.size = size;
+					se.mtime = mtime;
+				}
+				batch.push_back(se);
+			}
+		}
+
+		void build_table() {
+			size_t cap = 16;
+			while (cap < m_entries.size() * 2) cap <<= 1;
+			m_table.assign(cap, (uint32_t)npos);
+			for (size_t i = 0; i < m_entries.size(); i++) {
+				size_t slot = (size_t)m_entries[i].hash & (cap - 1);
+				while (m_table[slot] != npos) slot = (slot + 1) & (cap - 1);
+				m_table[slot] = (uint32_t)i;
+			}
+		}
+
+		// Path order compares component by component (like std::filesystem),
+		// so a directory is directly followed by its subtree. That makes the
+		// order a depth first walk with every directory's children sorted.
+		void build_sorted() {
+			size_t n = m_entries.size();
+			std::vector<uint32_t> first(n + 1, 0), children(n ? n - 1 : 0);
+			for (size_t i = 1; i < n; i++) first[m_entries[i].parent + 1]++;
+			for (size_t i = 0; i < n; i++) first[i + 1] += first[i];
+			std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+			for (size_t i = 1; i < n; i++) children[fill[m_entries[i].parent]++] = (uint32_t)i;
+
+			for (size_t d = 0; d < n; d++) {
+				if (first[d + 1] - first[d] > 1)
+					std::sort(children.begin() + first[d], children.begin() + first[d + 1], name_less(*this));
+			}
+
+			m_sorted.clear();
+			m_sorted.reserve(n);
+			if (!n) return;
+			std::vector<uint32_t> stack(1, 0);
+			while (!stack.empty()) {
+				uint32_t e = stack.back();
+				stack.pop_back();
+				m_sorted.push_back(e);
+				for (uint32_t c = first[e + 1]; c > first[e]; c--) stack.push_back(children[c - 1]);
+			}
+		}
+
+		struct name_less {
+			const file_index& idx;
+			name_less(const file_index& i) : idx(i) {}
+			bool operator()(uint32_t a, uint32_t b) const {
+				return compare_names(idx.name(a), idx.name_length(a), idx.name(b), idx.name_length(b)) < 0;
+			}
+		};
+
+		static int compare_names(const char* a, size_t an, const char* b, size_t bn) {
+			int c = std::memcmp(a, b, an < bn ? an : bn);
+			if (c) return c;
+			return an < bn ? -1 : (an > bn ? 1 : 0);
+		}
+
+		// compares root strings with runs of separators collapsed
+		static bool same_root(const char* a, size_t an, const char* b, size_t bn) {
+			size_t i = 0, j = 0;
+			while (i < an && j < bn) {
+				if (is_sep(a[i]) && is_sep(b[j])) {
+					while (i < an && is_sep(a[i])) i++;
+					while (j < bn && is_sep(b[j])) j++;
+					continue;
+				}
+				if (a[i] != b[j]) return false;
+				i++; j++;
+			}
+			while (i < an && is_sep(a[i])) i++;
+			while (j < bn && is_sep(b[j])) j++;
+			return i == an && j == bn;
+		}
+
+		// a path below the root, as split_query leaves it
+		struct query {
+			const char* s;			// the components, separators between them
+			size_t n;
+			size_t depth;			// number of components
+		};
+
+		// matches the root part of q, the rest and its component count go to out
+		bool split_query(const char* q, size_t n, query& out) const {
+			size_t rn = name_length(0);
+			const char* root = name(0);
+
+			// the root string may itself contain separators, match it as a prefix
+			size_t i = 0, j = 0;
+			while (i < rn && j < n) {
+				if (is_sep(root[i]) && is_sep(q[j])) {
+					while (i < rn && is_sep(root[i])) i++;
+					while (j < n && is_sep(q[j])) j++;
+					continue;
+				}
+				if (root[i] != q[j]) return false;
+				i++; j++;
+			}
+			if (i != rn) return false;
+			if (j < n && !is_sep(q[j]) && !m_root_has_sep) return false;
+
+			out.s = q + j;
+			out.n = n - j;
+			out.depth = 0;
+			while (j < n) {
+				while (j < n && is_sep(q[j])) j++;
+				if (j == n) break;
+				while (j < n && !is_sep(q[j])) j++;
+				out.depth++;
+			}
+			return true;
+		}
+
+		// the component of q that ends at or before end, end moves to its start
+		static void previous_component(const query& q, size_t& end, const char*& comp, size_t& len) {
+			while (end > 0 && is_sep(q.s[end - 1])) end--;
+			size_t e = end;
+			while (end > 0 && !is_sep(q.s[end - 1])) end--;
+			comp = q.s + end;
+			len = e - end;
+		}
+
+		// Component-wise comparison of entry e against q. Both are walked from
+		// the leaf up, entry through its parents and the query backwards, so no
+		// depth limit is needed; the topmost difference decides.
+		int compare_entry(uint32_t e, const query& q) const {
+			size_t depth = 0;
+			for (uint32_t c = e; c != 0; c = m_entries[c].parent) depth++;
+
+			size_t common = depth < q.depth ? depth : q.depth;
+			uint32_t c = e;
+			for (size_t k = depth; k > common; k--) c = m_entries[c].parent;
+			size_t end = q.n;
+			const char* comp;
+			size_t len;
+			for (size_t k = q.depth; k > common; k--) previous_component(q, end, comp, len);
+
+			int r = 0;
+			for (size_t k = common; k > 0; k--) {
+				previous_component(q, end, comp, len);
+				int d = compare_names(name(c), name_length(c), comp, len);
+				if (d) r = d;
+				c = m_entries[c].parent;
+			}
+			if (r) return r;
+			return depth < q.depth ? -1 : (depth > q.depth ? 1 : 0);
+		}
+
+	public:
+		file_index() : m_root_has_sep(false) {}
+
+		// Hashes a path the same way the index hashes its entries: "\" counts
+		// as "/" on windows, repeated separators count as one and trailing ones are ignored.
+		static uint64_t hash_path(const char* p, size_t n) {
+			while (n > 1 && is_sep(p[n - 1])) n--;
+			uint64_t h = 14695981039346656037ULL;
+			for (size_t i = 0; i < n; i++) {
+				if (is_sep(p[i])) {
+					if (i > 0 && is_sep(p[i - 1])) continue;
+					h = fnv1a_continue(h, "/", 1);
+				}
+				else {
+					h = fnv1a_continue(h, p + i, 1);
+				}
+			}
+			return h;
+		}
+
+		// Scans the tree under root with the given number of threads
+		// (0 = one per hardware thread). Replaces the previous contents.
+		bool scan(const path& root, unsigned threads = 0) {
+			clear();
+
+			std::string r = root.string();
+			while (r.size() > 1 && is_sep(r[r.size() - 1])) r.erase(r.size() - 1);
+			if (r.empty() || !is_directory(r)) return false;
+			m_root_has_sep = is_sep(r[r.size() - 1]);
+
+			index_entry e;
+			e.parent = (uint32_t)npos;
+			e.name = m_names.intern(r.c_str(), r.size());
+			e.hash = hash_path(r.c_str(), r.size());
+			e.size = 0;
+			e.mtime = 0;
+			e.type = file_type_directory;
+			m_entries.push_back(e);
+
+			scan_job job;
+			job.dir = 0;
+			job.dirpath = r;
+
+			threads = pool_threads(threads);
+			std::vector<scan_buffers> bufs(threads);
+			std::mutex merge_lock;
+			job_pool<scan_job> jobs;
+			jobs.push(job);
+			jobs.run(threads, [&](unsigned t, scan_job& j, std::vector<scan_job>& more) {
+				// the slow part (readdir + stat) runs without the lock
+				read_directory(j.dirpath, bufs[t].batch, bufs[t].names);
+				std::lock_guard<std::mutex> g(merge_lock);
+				merge(j.dir, bufs[t].batch, bufs[t].names, j.dirpath, more);
+			});
+
+			build_table();
+			build_sorted();
+			return true;
+		}
+
+		size_t size() const { return m_entries.size(); }
+		bool empty() const { return m_entries.empty(); }
+		const index_entry& operator[](size_t i) const { return m_entries[i]; }
+
+		const char* name(size_t i) const { return m_names.str(m_entries[i].name); }
+		size_t name_length(size_t i) const { return m_names.length(m_entries[i].name); }
+
+		// writes the full path of entry i into buf, returns its length (not
+		// counting the terminator) or 0 if it doesn't fit
+		size_t path_of(size_t i, char* buf, size_t cap) const {
+			size_t len = 0;
+			for (size_t c = i; c != npos; c = m_entries[c].parent) {
+				len += name_length(c);
+				if (m_entries[c].parent != npos && !(m_entries[c].parent == 0 && m_root_has_sep)) len++;
+			}
+			if (len + 1 > cap) return 0;
+
+			buf[len] = 0;
+			size_t at = len;
+			for (size_t c = i; c != npos; c = m_entries[c].parent) {
+				size_t n = name_length(c);
+				at -= n;
+				std::memcpy(buf + at, name(c), n);
+				if (m_entries[c].parent != npos && !(m_entries[c].parent == 0 && m_root_has_sep)) buf[--at] = PATH_SEP;
+			}
+			return len;
+		}
+
+		std::string path_of(size_t i) const {
+			std::vector<char> buf(256);
+			size_t n;
+			while ((n = path_of(i, &buf[0], buf.size())) == 0) buf.resize(buf.size() * 2);
+			return std::string(&buf[0], n);
+		}
+
+		// hashed lookup, returns npos if the path isn't in the index
+		size_t find(const char* p, size_t n) const {
+			if (m_table.empty()) return npos;
+			uint64_t h = hash_path(p, n);
+			size_t mask = m_table.size() - 1;
+			for (size_t slot = (size_t)h & mask; m_table[slot] != npos; slot = (slot + 1) & mask) {
+				uint32_t e = m_table[slot];
+				if (m_entries[e].hash != h) continue;
+
+				// confirm by comparing names from the end of the path upwards
+				size_t end = n;
+				uint32_t c = e;
+				for (;;) {
+					while (end > 0 && is_sep(p[end - 1]) && c != 0) end--;
+					if (c == 0) {
+						if (same_root(name(0), name_length(0), p, end)) return e;
+						break;
+					}
+					size_t s = end;
+					while (s > 0 && !is_sep(p[s - 1])) s--;
+					if (compare_names(name(c), name_length(c), p + s, end - s) != 0) break;
+					end = s;
+					c = m_entries[c].parent;
+				}
+			}
+			return npos;
+		}
+		size_t find(const std::string& p) const { return find(p.c_str(), p.size()); }
+
+		// binary search over the entries in path order, returns npos if not found
+		size_t find_sorted(const char* p, size_t n) const {
+			size_t pos = lower_bound(p, n);
+			if (pos == m_sorted.size()) return npos;
+
+			query q;
+			if (!split_query(p, n, q)) return npos;
+			return compare_entry(m_sorted[pos], q) == 0 ? m_sorted[pos] : npos;
+		}
+		size_t find_sorted(const std::string& p) const { return find_sorted(p.c_str(), p.size()); }
+
+		// Position in sorted() of the first entry not ordered before p. Since
+		// a subtree is contiguous in path order, the entries of directory d
+		// are the ones that follow it while their path still starts with d.
+		size_t lower_bound(const char* p, size_t n) const {
+			query q;
+			if (m_sorted.empty() || !split_query(p, n, q)) return m_sorted.size();
+
+			size_t lo = 0, hi = m_sorted.size();
+			while (lo < hi) {
+				size_t mid = lo + (hi - lo) / 2;
+				if (compare_entry(m_sorted[mid], q) < 0) lo = mid + 1;
+				else hi = mid;
+			}
+			return lo;
+		}
+
+		const std::vector<uint32_t>& sorted() const { return m_sorted; }
+		const string_pool& names() const { return m_names; }
+
+		// approximate heap usage of the index
+		size_t memory_usage() const {
+			return m_names.bytes() + m_entries.capacity() * sizeof(index_entry) +
+				(m_table.capacity() + m_sorted.capacity()) * sizeof(uint32_t);
+		}
+
+		void clear() {
+			m_names.clear();
+			m_entries.clear();
+			m_table.clear();
+			m_sorted.clear();
+			m_root_has_sep = false;
+		}
+	};
+
+};
+
+#endif
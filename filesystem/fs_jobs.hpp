@@ -0,0 +1,107 @@
+/*
+
+	Copyright (C) Nico Rajala 2025
+
+	fs_jobs.hpp
+	The work queue behind the threaded tree walks (fs_remove.hpp,
+	fs_usage.hpp, fs_index.hpp, fs_glob.hpp).
+
+	Needs C++11 (std::thread).
+
+	A job is usually one directory. Workers take the newest job, run it
+	without holding the lock and queue whatever it found. LIFO keeps the
+	walk close to depth first, so the number of directories that are open
+	or half done at once stays small. The queue counts jobs that are queued
+	or running, and the walk is over when that drops to 0, so a thread
+	never waits for work that nobody is going to queue.
+
+	Usage:
+		fs::job_pool<node*> pool;
+		pool.push(root);
+		pool.run(threads, [&](unsigned thread, node*& n, std::vector<node*>& more) {
+			// list n, append its subdirectories to more
+		});
+
+	Table of contents: () - functions [] - classes/structs/other
+		(POOL_THREADS)
+		[JOB_POOL]
+
+*/
+
+#ifndef FS_JOBS_HPP
+#define FS_JOBS_HPP
+
+#include <vector>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace fs {
+
+// (POOL_THREADS)
+	// the thread count a pool runs with, 0 means one per core
+	inline unsigned pool_threads(unsigned threads) {
+		if (!threads) threads = std::thread::hardware_concurrency();
+		return threads ? threads : 1;
+	}
+
+// [JOB_POOL]
+	template <class Job>
+	class job_pool {
+		std::mutex m_lock;
+		std::condition_variable m_cv;
+		std::vector<Job> m_jobs;
+		size_t m_pending;					// queued + running
+
+		job_pool(const job_pool&);
+		job_pool& operator=(const job_pool&);
+
+		template <class Visit>
+		void work(unsigned thread, Visit& visit) {
+			std::vector<Job> more;
+			std::unique_lock<std::mutex> lk(m_lock);
+			for (;;) {
+				while (m_jobs.empty() && m_pending) m_cv.wait(lk);
+				if (m_jobs.empty()) return;
+				Job j(std::move(m_jobs.back()));
+				m_jobs.pop_back();
+				lk.unlock();
+
+				more.clear();
+				visit(thread, j, more);
+
+				lk.lock();
+				for (size_t i = 0; i < more.size(); i++) m_jobs.push_back(std::move(more[i]));
+				m_pending += more.size();
+				m_pending--;
+				if (!more.empty() || !m_pending) m_cv.notify_all();
+			}
+		}
+
+	public:
+		job_pool() : m_pending(0) {}
+
+		// queues a starting job, before run()
+		void push(const Job& j) {
+			m_jobs.push_back(j);
+			m_pending++;
+		}
+
+		// Calls visit(thread, job, more) for every job until none are left,
+		// on pool_threads(threads) threads counting the calling one. thread
+		// is 0..count-1, for per-thread results that need no lock.
+		template <class Visit>
+		void run(unsigned threads, Visit visit) {
+			threads = pool_threads(threads);
+			std::vector<std::thread> pool;
+			for (unsigned i = 1; i < threads; i++)
+				pool.push_back(std::thread(&job_pool::work<Visit>, this, i, std::ref(visit)));
+			work(0, visit);
+			for (size_t i = 0; i < pool.size(); i++) pool[i].join();
+		}
+	};
+
+};
+
+#endif // FS_JOBS_HPP
@@ -0,0 +1,625 @@
+/*
+
+	Copyright (C) Nico Rajala 2025
+
+	fs_pack.hpp
+	Single file archive for bundling a directory tree, read through one
+	mapping instead of an open/read/close per file.
+
+	Layout (little-endian, every section 8 byte aligned):
+		pack_header			64 bytes
+		pack_entry[count]	sorted by name, bytewise
+		uint32_t[slots]		open addressing table over the entries, by name hash
+		names				"dir/file.ext\0" for every entry, '/' separated
+		data				each entry starts on the pack's alignment (64 by default)
+
+	Entries can be LZ4 compressed (standard LZ4 block format, fast to
+	decode, no external library needed). Stored entries are handed out as
+	a byte_span straight into the mapping, so reading one is a page fault
+	at most.
+
+	Usage:
+		fs::pack_writer w;
+		w.add_directory("assets");
+		w.write("assets.pak", fs::pack_compress);
+
+		fs::pack_reader pak("assets.pak");
+		size_t i = pak.find("textures/wall.png");
+		if (i != fs::pack_reader::npos) {
+			if (!pak.is_compressed(i)) use(pak.data(i));
+			else { std::vector<unsigned char> buf; pak.read(i, buf); use(buf); }
+		}
+
+	Table of contents: () - functions [] - classes/structs/other
+		(LZ4_COMPRESS)
+		(LZ4_DECOMPRESS)
+		[PACK_HEADER]
+		[PACK_ENTRY]
+		(PACK_NAME_IS_SAFE)
+		[PACK_WRITER]
+		[PACK_READER]
+		(UNPACK)
+
+*/
+
+#ifndef FS_PACK_HPP
+#define FS_PACK_HPP
+
+#include "filesystem.hpp"
+#include "fs_hash.hpp"
+
+#include <stdint.h>
+#include <cstdio>
+#include <algorithm>
+
+namespace fs {
+
+// (LZ4_COMPRESS)
+	// Greedy LZ4 block compressor with a 4K entry hash table. Returns the
+	// compressed size, or 0 if it wouldn't fit in cap.
+	inline size_t lz4_compress(const unsigned char* src, size_t n, unsigned char* dst, size_t cap) {
+		const size_t min_match = 4, last_literals = 5, mf_limit = 12;
+		const int hash_bits = 12;
+		uint32_t table[1 << hash_bits];		// position + 1, 0 is empty
+		memset(table, 0, sizeof(table));
+
+		size_t ip = 0, anchor = 0, op = 0;
+		unsigned misses = 0;
+
+		struct emit {
+			static bool length(unsigned char* dst, size_t cap, size_t& op, size_t len) {
+				while (len >= 255) {
+					if (op >= cap) return false;
+					dst[op++] = 255;
+					len -= 255;
+				}
+				if (op >= cap) return false;
+				dst[op++] = (unsigned char)len;
+				return true;
+			}
+		};
+
+		if (n > mf_limit) {
+			size_t match_limit = n - last_literals;
+			while (ip < n - mf_limit) {
+				uint32_t seq;
+				memcpy(&seq, src + ip, 4);
+				uint32_t h = (seq * 2654435761U) >> (32 - hash_bits);
+				size_t ref = table[h];
+				table[h] = (uint32_t)(ip + 1);
+				uint32_t cand;
+				if (!ref || ip - (ref - 1) > 65535 || (memcpy(&cand, src + ref - 1, 4), cand != seq)) {
+					// skip faster through data that doesn't compress
+					ip += 1 + (misses++ >> 6);
+					continue;
+				}
+				misses = 0;
+				ref--;
+
+				// extend 8 bytes at a time, then finish byte by byte
+				size_t len = min_match;
+				while (ip + len + 8 <= match_limit) {
+					uint64_t a, b;
+					memcpy(&a, src + ip + len, 8);
+					memcpy(&b, src + ref + len, 8);
+					if (a != b) break;
+					len += 8;
+				}
+				while (ip + len < match_limit && src[ref + len] == src[ip + len]) len++;
+
+				size_t lit = ip - anchor;
+				if (op + 1 + lit + lit / 255 + 2 + 1 > cap) return 0;
+				unsigned char* token = dst + op++;
+				*token = (unsigned char)(((lit >= 15 ? 15 : lit) << 4) | (len - min_match >= 15 ? 15 : len - min_match));
+				if (lit >= 15 && !emit::length(dst, cap, op, lit - 15)) return 0;
+				memcpy(dst + op, src + anchor, lit);
+				op += lit;
+				size_t off = ip - ref;
+				dst[op++] = (unsigned char)(off & 0xFF);
+				dst[op++] = (unsigned char)(off >> 8);
+				if (len - min_match >= 15 && !emit::length(dst, cap, op, len - min_match - 15)) return 0;
+
+				ip += len;
+				anchor = ip;
+			}
+		}
+
+		// the rest goes out as literals
+		size_t lit = n - anchor;
+		if (op + 1 + lit + lit / 255 + 1 > cap) return 0;
+		dst[op++] = (unsigned char)((lit >= 15 ? 15 : lit) << 4);
+		if (lit >= 15 && !emit::length(dst, cap, op, lit - 15)) return 0;
+		memcpy(dst + op, src + anchor, lit);
+		return op + lit;
+	}
+
+	// worst case output size of lz4_compress
+	inline size_t lz4_bound(size_t n) { return n + n / 255 + 16; }
+
+// (LZ4_DECOMPRESS)
+	// Decodes a whole block into exactly n bytes. Bounds checked, a damaged
+	// block makes it return false rather than read or write out of range.
+	inline bool lz4_decompress(const unsigned char* src, size_t srclen, unsigned char* dst, size_t n) {
+		size_t ip = 0, op = 0;
+		for (;;) {
+			if (ip >= srclen) return false;
+			unsigned token = src[ip++];
+
+			size_t lit = token >> 4;
+			if (lit == 15) {
+				unsigned char b;
+				do {
+					if (ip >= srclen) return false;
+					b = src[ip++];
+					lit += b;
+				} while (b == 255);
+			}
+			if (lit > srclen - ip || lit > n - op) return false;
+			// short runs (the usual case) as one fixed size copy when there's room
+			if (lit <= 16 && srclen - ip >= 16 && n - op >= 16) memcpy(dst + op, src + ip, 16);
+			else memcpy(dst + op, src + ip, lit);
+			ip += lit;
+			op += lit;
+			if (ip == srclen) break;		// last sequence has no match
+
+			if (srclen - ip < 2) return false;
+			size_t off = src[ip] | ((size_t)src[ip + 1] << 8);
+			ip += 2;
+			if (off == 0 || off > op) return false;
+
+			size_t len = token & 15;
+			if (len == 15) {
+				unsigned char b;
+				do {
+					if (ip >= srclen) return false;
+					b = src[ip++];
+					len += b;
+				} while (b == 255);
+			}
+			len += 4;
+			if (len > n - op) return false;
+
+			// The match may overlap what it's writing. 16 byte steps are still
+			// fine as long as the source is at least 16 bytes behind, and
+			// writing a little past the match is harmless while it stays inside
+			// dst, the next sequence overwrites it.
+			const unsigned char* m = dst + op - off;
+			unsigned char* d = dst + op;
+			if (off >= 16 && n - op >= len + 16) {
+				for (size_t i = 0; i < len; i += 16) memcpy(d + i, m + i, 16);
+			}
+			else for (size_t i = 0; i < len; i++) d[i] = m[i];
+			op += len;
+		}
+		return op == n;
+	}
+
+// [PACK_HEADER]
+	enum pack_flags {
+		pack_none = 0,
+		pack_compress = 1 << 0		// LZ4 entries that shrink by at least 1/8
+	};
+
+	enum pack_compression {
+		pack_stored = 0,
+		pack_lz4 = 1
+	};
+
+	struct pack_header {
+		char magic[4];				// "NSPK"
+		uint32_t version;
+		uint32_t count;
+		uint32_t alignment;
+		uint64_t toc_offset;
+		uint64_t slots_offset;
+		uint32_t slot_count;		// power of two
+		uint32_t reserved0;
+		uint64_t names_offset;
+		uint64_t names_size;
+		uint64_t data_offset;
+	};
+
+// [PACK_ENTRY]
+	struct pack_entry {
+		uint64_t offset;			// from the start of the file
+		uint64_t stored_size;
+		uint64_t size;				// after decompression
+		uint64_t name_hash;			// xxh64 of the name
+		uint64_t content_hash;		// xxh64 of the uncompressed bytes
+		uint32_t name_offset;		// into the names section
+		uint32_t name_size;
+		uint32_t compression;		// pack_compression
+		uint32_t reserved;
+	};
+
+	const uint32_t pack_version = 1;
+
+	inline uint64_t pack_align(uint64_t v, uint64_t a) { return (v + a - 1) & ~(a - 1); }
+
+// (PACK_NAME_IS_SAFE)
+	// Whether an entry name stays below whatever directory it is extracted to,
+	// on any platform: '/' and '\\' both separate, and empty or ".." components,
+	// a leading separator and ':' anywhere (drive letters, streams) are refused.
+	inline bool pack_name_is_safe(const std::string& name) {
+		if (name.empty()) return false;
+		size_t start = 0;
+		for (size_t i = 0; i <= name.size(); i++) {
+			char c = i < name.size() ? name[i] : '/';
+			if (c == ':') return false;
+			if (c != '/' && c != '\\') continue;
+			size_t len = i - start;
+			if (len == 0) return false;
+			if (len == 2 && name[start] == '.' && name[start + 1] == '.') return false;
+			start = i + 1;
+		}
+		return true;
+	}
+
+// [PACK_WRITER]
+	class pack_writer {
+		struct item {
+			std::string name;
+			path source;				// file to read, or empty
+			std::vector<unsigned char> bytes;
+			bool operator<(const item& o) const { return name < o.name; }
+		};
+		std::vector<item> m_items;
+
+		// '/' separators, no leading "./" or "/", so lookups have one spelling
+		static std::string clean_name(path_view name) {
+			std::string s;
+			s.reserve(name.size());
+			for (size_t i = 0; i < name.size(); i++) {
+				char c = name[i];
+#if defined(_WIN32)
+				if (c == '\\') c = '/';
+#endif
+				if (c == '/' && (s.empty() || s[s.size() - 1] == '/')) continue;
+				s += c;
+			}
+			while (s.size() >= 2 && s[0] == '.' && s[1] == '/') s.erase(0, 2);
+			return s;
+		}
+
+		static bool load(const path& p, std::vector<unsigned char>& out) {
+			FILE* f = fopen(p.c_str(), "rb");
+			if (!f) return false;
+			out.clear();
+			unsigned char buf[1 << 16];
+			size_t got;
+			while ((got = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + got);
+			bool ok = !ferror(f);
+			fclose(f);
+			return ok;
+		}
+
+		static bool pad(FILE* f, uint64_t& pos, uint64_t to) {
+			static const char zeros[64] = { 0 };
+			while (pos < to) {
+				size_t n = (size_t)std::min<uint64_t>(sizeof(zeros), to - pos);
+				if (fwrite(zeros, 1, n, f) != n) return false;
+				pos += n;
+			}
+			return true;
+		}
+
+	public:
+		size_t size() const { return m_items.size(); }
+		void clear() { m_items.clear(); }
+
+		// the file is read when write() runs, not now
+		void add_file(path_view name, const path& source) {
+			item it;
+			it.name = clean_name(name);
+			it.source = source;
+			m_items.push_back(it);
+		}
+
+		void add_data(path_view name, const void* data, size_t n) {
+			item it;
+			it.name = clean_name(name);
+			const unsigned char* p = static_cast<const unsigned char*>(data);
+			it.bytes.assign(p, p + n);
+			m_items.push_back(it);
+		}
+
+		// adds every regular file below dir, named relative to it (plus prefix)
+		bool add_directory(const path& dir, const std::string& prefix = std::string()) {
+			directory_reader rd(dir);
+			if (!rd.is_open()) return false;
+			bool ok = true;
+			while (rd.next()) {
+				std::string name = prefix.empty() ? std::string(rd.name()) : prefix + "/" + rd.name();
+				path full = dir / rd.name();
+				file_type t = rd.type();
+				if (t == file_type_unknown || t == file_type_symlink) {
+					if (is_directory(full)) t = file_type_directory;
+					else if (exists(full)) t = file_type_regular;
+				}
+				if (t == file_type_directory) {
+					if (!add_directory(full, name)) ok = false;
+				}
+				else if (t == file_type_regular) add_file(name, full);
+			}
+			return ok;
+		}
+
+		// Writes the archive to a temp file next to out and renames it into
+		// place. Fails on duplicate or unsafe names (see pack_name_is_safe) or
+		// if a source file can't be read.
+		bool write(const path& out, int flags = pack_none, uint32_t alignment = 64) {
+			if (alignment < 8 || (alignment & (alignment - 1))) return false;
+			for (size_t i = 0; i < m_items.size(); i++)
+				if (!pack_name_is_safe(m_items[i].name)) return false;
+			std::stable_sort(m_items.begin(), m_items.end());
+			for (size_t i = 1; i < m_items.size(); i++)
+				if (m_items[i].name == m_items[i - 1].name) return false;
+
+			size_t count = m_items.size();
+			uint32_t slot_count = 16;
+			while (slot_count < count * 2) slot_count <<= 1;
+
+			std::vector<pack_entry> toc(count);
+			std::vector<uint32_t> slots(slot_count, 0);
+			std::string names;
+			for (size_t i = 0; i < count; i++) {
+				pack_entry& e = toc[i];
+				memset(&e, 0, sizeof(e));
+				e.name_offset = (uint32_t)names.size();
+				e.name_size = (uint32_t)m_items[i].name.size();
+				e.name_hash = hash_bytes(m_items[i].name.data(), m_items[i].name.size());
+				names += m_items[i].name;
+				names += '\0';
+
+				uint32_t s = (uint32_t)e.name_hash & (slot_count - 1);
+				while (slots[s]) s = (s + 1) & (slot_count - 1);
+				slots[s] = (uint32_t)i + 1;
+			}
+
+			pack_header head;
+			memset(&head, 0, sizeof(head));
+			memcpy(head.magic, "NSPK", 4);
+			head.version = pack_version;
+			head.count = (uint32_t)count;
+			head.alignment = alignment;
+			head.toc_offset = pack_align(sizeof(pack_header), 8);
+			head.slots_offset = pack_align(head.toc_offset + count * sizeof(pack_entry), 8);
+			head.slot_count = slot_count;
+			head.names_offset = pack_align(head.slots_offset + slot_count * sizeof(uint32_t), 8);
+			head.names_size = names.size();
+			head.data_offset = pack_align(head.names_offset + names.size(), alignment);
+
+			std::string tmp = out.string() + ".tmp";
+			FILE* f = fopen(tmp.c_str(), "wb");
+			if (!f) return false;
+
+			// zeros up to the data first, the tables go over them at the end
+			// once the entry offsets are known
+			uint64_t pos = 0;
+			bool ok = pad(f, pos, head.data_offset);
+			std::vector<unsigned char> bytes, packed;
+			for (size_t i = 0; ok && i < count; i++) {
+				item& it = m_items[i];
+				pack_entry& e = toc[i];
+				if (!it.source.empty()) {
+					if (!load(it.source, bytes)) { ok = false; break; }
+				}
+				else bytes.swap(it.bytes);
+
+				e.size = bytes.size();
+				e.content_hash = hash_bytes(bytes.empty() ? NULL : &bytes[0], bytes.size());
+				const unsigned char* src = bytes.empty() ? NULL : &bytes[0];
+				size_t stored = bytes.size();
+				e.compression = pack_stored;
+				if ((flags & pack_compress) && bytes.size() >= 64) {
+					packed.resize(lz4_bound(bytes.size()));
+					size_t n = lz4_compress(&bytes[0], bytes.size(), &packed[0], bytes.size() - bytes.size() / 8);
+					if (n) {
+						src = &packed[0];
+						stored = n;
+						e.compression = pack_lz4;
+					}
+				}
+
+				if (!pad(f, pos, pack_align(pos, alignment))) { ok = false; break; }
+				e.offset = pos;
+				e.stored_size = stored;
+				if (stored && fwrite(src, 1, stored, f) != stored) { ok = false; break; }
+				pos += stored;
+				if (it.source.empty()) bytes.swap(it.bytes);
+			}
+
+			if (ok) {
+				uint64_t p = 0;
+				ok = fseek(f, 0, SEEK_SET) == 0
+					&& fwrite(&head, sizeof(head), 1, f) == 1
+					&& ((p = sizeof(head)), pad(f, p, head.toc_offset))
+					&& (!count || fwrite(&toc[0], sizeof(pack_entry), count, f) == count)
+					&& ((p = head.toc_offset + count * sizeof(pack_entry)), pad(f, p, head.slots_offset))
+					&& fwrite(&slots[0], sizeof(uint32_t), slot_count, f) == slot_count
+					&& ((p = head.slots_offset + slot_count * sizeof(uint32_t)), pad(f, p, head.names_offset))
+					&& (names.empty() || fwrite(names.data(), 1, names.size(), f) == names.size());
+			}
+			if (fclose(f) != 0) ok = false;
+#if defined(_WIN32)
+			if (ok) ok = MoveFileExA(tmp.c_str(), out.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+			if (ok) ok = ::rename(tmp.c_str(), out.c_str()) == 0;
+#endif
+			if (!ok) ::remove(tmp.c_str());
+			return ok;
+		}
+	};
+
+// [PACK_READER]
+	class pack_reader {
+		mapped_file m_map;
+		const pack_header* m_head;
+		const pack_entry* m_toc;
+		const uint32_t* m_slots;
+		const char* m_names;
+
+		pack_reader(const pack_reader&);
+		pack_reader& operator=(const pack_reader&);
+
+		bool validate() const {
+			uint64_t size = m_map.size();
+			const pack_header& h = *m_head;
+			if (memcmp(h.magic, "NSPK", 4) != 0 || h.version != pack_version) return false;
+			if (!h.slot_count || (h.slot_count & (h.slot_count - 1)) || h.slot_count < h.count) return false;
+			// offset + length can wrap, so each table is checked against what's left after its offset
+			if (h.toc_offset > size || h.count > (size - h.toc_offset) / sizeof(pack_entry)) return false;
+			if (h.slots_offset > size || h.slot_count > (size - h.slots_offset) / sizeof(uint32_t)) return false;
+			if (h.names_offset > size || h.names_size > size - h.names_offset) return false;
+			if ((h.toc_offset | h.slots_offset) & 7) return false;
+			const pack_entry* toc = reinterpret_cast<const pack_entry*>(m_map.data() + h.toc_offset);
+			for (uint32_t i = 0; i < h.count; i++) {
+				const pack_entry& e = toc[i];
+				if (e.offset > size || e.stored_size > size - e.offset) return false;
+				if ((uint64_t)e.name_offset + e.name_size >= h.names_size) return false;
+				if (e.compression > pack_lz4) return false;
+				if (e.compression == pack_stored && e.stored_size != e.size) return false;
+				if (e.compression == pack_lz4 && e.size / 255 > e.stored_size) return false;	// beyond what LZ4 can expand to
+			}
+			const uint32_t* slots = reinterpret_cast<const uint32_t*>(m_map.data() + h.slots_offset);
+			for (uint32_t i = 0; i < h.slot_count; i++)
+				if (slots[i] > h.count) return false;
+			return true;
+		}
+
+	public:
+		static const size_t npos = (size_t)-1;
+
+		pack_reader() : m_head(NULL), m_toc(NULL), m_slots(NULL), m_names(NULL) {}
+		explicit pack_reader(const path& p) : m_head(NULL), m_toc(NULL), m_slots(NULL), m_names(NULL) { open(p); }
+
+		// maps the archive and checks that every table and entry lies inside it
+		bool open(const path& p) {
+			close();
+			if (!m_map.open(p, map_read_only)) return false;
+			if (m_map.size() < sizeof(pack_header)) { close(); return false; }
+			m_head = reinterpret_cast<const pack_header*>(m_map.data());
+			if (!validate()) { close(); return false; }
+			m_toc = reinterpret_cast<const pack_entry*>(m_map.data() + m_head->toc_offset);
+			m_slots = reinterpret_cast<const uint32_t*>(m_map.data() + m_head->slots_offset);
+			m_names = reinterpret_cast<const char*>(m_map.data() + m_head->names_offset);
+			return true;
+		}
+
+		void close() {
+			m_map.close();
+			m_head = NULL;
+			m_toc = NULL;
+			m_slots = NULL;
+			m_names = NULL;
+		}
+
+		bool is_open() const { return m_head != NULL; }
+		size_t size() const { return m_head ? m_head->count : 0; }
+		const pack_entry& entry(size_t i) const { return m_toc[i]; }
+		path_view name(size_t i) const { return path_view(m_names + m_toc[i].name_offset, m_toc[i].name_size); }
+		bool is_compressed(size_t i) const { return m_toc[i].compression != pack_stored; }
+
+		// hashed lookup, one probe in the common case
+		size_t find(path_view name) const {
+			if (!m_head) return npos;
+			uint64_t h = hash_bytes(name.data(), name.size());
+			uint32_t mask = m_head->slot_count - 1;
+			for (uint32_t s = (uint32_t)h & mask, n = 0; n <= mask; s = (s + 1) & mask, n++) {
+				uint32_t v = m_slots[s];
+				if (!v) return npos;
+				const pack_entry& e = m_toc[v - 1];
+				if (e.name_hash == h && this->name(v - 1) == name) return v - 1;
+			}
+			return npos;
+		}
+
+		// first entry whose name is not less than key. Entries are sorted, so
+		// everything under "dir/" is the range starting at lower_bound("dir/").
+		size_t lower_bound(path_view key) const {
+			size_t lo = 0, hi = size();
+			while (lo < hi) {
+				size_t mid = lo + (hi - lo) / 2;
+				path_view n = name(mid);
+				size_t common = std::min(n.size(), key.size());
+				int c = memcmp(n.data(), key.data(), common);
+				if (c < 0 || (c == 0 && n.size() < key.size())) lo = mid + 1;
+				else hi = mid;
+			}
+			return lo;
+		}
+
+		// the bytes as stored, straight from the mapping
+		byte_span data(size_t i) const {
+			return m_map.subspan((size_t)m_toc[i].offset, (size_t)m_toc[i].stored_size);
+		}
+
+		// the uncompressed bytes, copied (or decompressed) into out
+		bool read(size_t i, std::vector<unsigned char>& out) const {
+			const pack_entry& e = m_toc[i];
+			byte_span raw = data(i);
+			out.resize((size_t)e.size);
+			if (e.compression == pack_stored) {
+				if (!raw.empty()) memcpy(&out[0], raw.data(), raw.size());
+				return true;
+			}
+			if (out.empty()) return raw.empty();
+			return lz4_decompress(raw.data(), raw.size(), &out[0], out.size());
+		}
+
+		// checks the content hash, needs to read (and decompress) the entry
+		bool verify(size_t i) const {
+			const pack_entry& e = m_toc[i];
+			if (e.compression == pack_stored) {
+				byte_span raw = data(i);
+				return hash_bytes(raw.data(), raw.size()) == e.content_hash;
+			}
+			std::vector<unsigned char> buf;
+			if (!read(i, buf)) return false;
+			return hash_bytes(buf.empty() ? NULL : &buf[0], buf.size()) == e.content_hash;
+		}
+
+		void advise(map_advice advice) { m_map.advise(advice); }
+	};
+
+// (UNPACK)
+	// Extracts every entry below dir. Entry names are trusted only as far as
+	// they stay inside dir, anything pack_name_is_safe refuses is skipped.
+	inline bool unpack(const pack_reader& pak, const path& dir) {
+		if (!pak.is_open()) return false;
+		directory_cache made;
+		if (!create_directories(dir, made)) return false;
+		std::vector<unsigned char> buf;
+		bool ok = true;
+		for (size_t i = 0; i < pak.size(); i++) {
+			path_view name = pak.name(i);
+			std::string s = name.string();
+			if (!pack_name_is_safe(s)) { ok = false; continue; }
+
+			path out = dir / s;
+			path parent = out.parent_path();
+			if (!parent.empty() && !create_directories(parent, made)) { ok = false; continue; }
+
+			byte_span bytes;
+			if (pak.is_compressed(i)) {
+				if (!pak.read(i, buf)) { ok = false; continue; }
+				bytes = byte_span(buf.empty() ? NULL : &buf[0], buf.size());
+			}
+			else bytes = pak.data(i);
+
+			FILE* f = fopen(out.c_str(), "wb");
+			if (!f) { ok = false; continue; }
+			if (!bytes.empty() && fwrite(bytes.data(), 1, bytes.size(), f) != bytes.size()) ok = false;
+			if (fclose(f) != 0) ok = false;
+		}
+		return ok;
+	}
+
+	inline bool unpack(const path& pak_file, const path& dir) {
+		pack_reader pak(pak_file);
+		return unpack(pak, dir);
+	}
+
+};
+
+#endif // FS_PACK_HPP
@@ -0,0 +1,223 @@
+/*
+
+	Copyright (C) Nico Rajala 2025
+
+	fs_remove.hpp
+	Multithreaded remove_all for big trees, on top of filesystem.hpp.
+
+	Needs C++11 (std::thread).
+
+	Every directory is a job. A worker lists it, unlinks the files in it
+	right away and queues the directories it finds. On POSIX a directory
+	stays open until it is removed and everything below it is opened
+	(O_NOFOLLOW) and unlinked relative to that fd, on windows its handle is
+	held without delete sharing, so a directory swapped for a symlink or
+	junction halfway through never leads outside the tree. A directory keeps a count of the jobs below it that haven't
+	finished, and whoever finishes the last one removes it and reports to
+	its parent, so the tree is taken down bottom-up without any thread
+	waiting on another. The threads come from fs_jobs.hpp.
+
+	Mostly a win where unlink latency dominates (network filesystems,
+	fuse, ext4 with journaling on slow disks). On a local SSD a couple of
+	threads already saturate the filesystem's directory locks.
+
+	Usage:
+		fs::remove_result r;
+		if (!fs::remove_all("build/tmp", r, 8)) {
+			for (size_t i = 0; i < r.errors.size(); i++) ...
+		}
+
+	Table of contents: () - functions [] - classes/structs/other
+		(REMOVE_ALL)
+
+*/
+
+#ifndef FS_REMOVE_HPP
+#define FS_REMOVE_HPP
+
+#include "filesystem.hpp"
+#include "fs_jobs.hpp"
+
+#include <atomic>
+
+namespace fs {
+
+	namespace remove_detail {
+
+		struct node {
+			std::string dirpath;			// for error reports
+			node* parent;
+#if defined(_WIN32)
+			// Held without FILE_SHARE_DELETE while the node lives, so no directory
+			// between the root and a scan can be renamed or swapped for a junction.
+			HANDLE handle;
+#else
+			// Open while the node lives, children are opened and removed relative
+			// to it, so nothing is ever resolved through a path that could change.
+			directory_reader* rd;
+			std::string name;				// relative to the parent's fd, the whole path for the root
+#endif
+			std::atomic<long> pending;		// the scan itself + subdirectories not removed yet
+			std::atomic<bool> failed;		// something below stayed, don't bother with rmdir
+		};
+
+		inline void push_error(remove_result& r, const std::string& p, int err) {
+			remove_error e = { p, err };
+			r.errors.push_back(e);
+		}
+
+		inline node* new_node(node* parent, const std::string& dirpath, const char* name) {
+			node* c = new node();
+			c->dirpath = dirpath;
+			c->parent = parent;
+#if defined(_WIN32)
+			(void)name;
+			c->handle = INVALID_HANDLE_VALUE;
+#else
+			c->rd = NULL;
+			c->name = name;
+#endif
+			c->pending = 1;
+			c->failed = false;
+			return c;
+		}
+
+		// drops one pending count of n, removes it when that was the last
+		// one and walks up as long as parents finish with it
+		inline void finish(node* n, remove_result& r) {
+			while (n && --n->pending == 0) {
+				bool ok = !n->failed;
+				node* parent = n->parent;
+#if defined(_WIN32)
+				bool opened = n->handle != INVALID_HANDLE_VALUE;
+				if (opened) CloseHandle(n->handle);
+				if (ok && opened) {
+					if (RemoveDirectoryA(n->dirpath.c_str())) r.directories++;
+					else if (GetLastError() != ERROR_FILE_NOT_FOUND) { push_error(r, n->dirpath, (int)GetLastError()); ok = false; }
+				}
+#else
+				bool opened = n->rd != NULL;
+				delete n->rd;
+				if (ok && opened) {
+					if (unlinkat(parent ? parent->rd->fd() : AT_FDCWD, n->name.c_str(), AT_REMOVEDIR) == 0) r.directories++;
+					else if (errno != ENOENT) { push_error(r, n->dirpath, errno); ok = false; }
+				}
+#endif
+				if (!ok && parent) parent->failed = true;
+				delete n;
+				n = parent;
+			}
+		}
+
+		// lists n, the subdirectories it finds go to found
+		inline void scan(node* n, remove_result& r, std::vector<node*>& found) {
+#if defined(_WIN32)
+			n->handle = CreateFileA(n->dirpath.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+				OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OPEN_REPARSE_POINT, NULL);
+			if (n->handle == INVALID_HANDLE_VALUE) {
+				DWORD err = GetLastError();
+				if (err != ERROR_FILE_NOT_FOUND && err != ERROR_PATH_NOT_FOUND) {
+					push_error(r, n->dirpath, (int)err);
+					n->failed = true;
+				}
+				finish(n, r);
+				return;
+			}
+			BY_HANDLE_FILE_INFORMATION info;
+			if (!GetFileInformationByHandle(n->handle, &info) || (info.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+				|| !(info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+				// swapped for a junction, link or file since the parent listed it,
+				// it goes without its target
+				CloseHandle(n->handle);
+				n->handle = INVALID_HANDLE_VALUE;
+				std::string tmp = n->dirpath;
+				if (!remove_tree(tmp, (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0, r, false)) n->failed = true;
+				finish(n, r);
+				return;
+			}
+			// the path can't change under the listing, every directory on it is held
+			directory_reader rd(path(n->dirpath));
+			while (rd.next()) {
+				std::string child = n->dirpath + "\\" + rd.name();
+				if (rd.type() == file_type_directory) {
+					found.push_back(new_node(n, child, rd.name()));
+					continue;
+				}
+				// junctions and directory symlinks are removed as links
+				std::string tmp = child;
+				if (!remove_tree(tmp, (rd.find_data().dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0, r, false)) n->failed = true;
+			}
+#else
+			int parent_fd = n->parent ? n->parent->rd->fd() : AT_FDCWD;
+			n->rd = new directory_reader(parent_fd, n->name.c_str());
+			if (!n->rd->is_open()) {
+				int err = errno;
+				delete n->rd;
+				n->rd = NULL;
+				if (err == ENOTDIR || err == ELOOP) {
+					// swapped for a symlink or file since the parent listed it, it
+					// goes like a file and whatever it points to stays
+					if (unlinkat(parent_fd, n->name.c_str(), 0) == 0) r.files++;
+					else if (errno != ENOENT) { push_error(r, n->dirpath, errno); n->failed = true; }
+				}
+				else if (err != ENOENT) {
+					push_error(r, n->dirpath, err);
+					n->failed = true;
+				}
+				finish(n, r);
+				return;
+			}
+			directory_reader& rd = *n->rd;
+			while (rd.next()) {
+				file_type t = rd.type();
+				if (t != file_type_directory) {
+					if (unlinkat(rd.fd(), rd.name(), 0) == 0) { r.files++; continue; }
+					int err = errno;
+					if (err == ENOENT) continue;
+					struct stat st;
+					if ((err != EISDIR && err != EPERM) || fstatat(rd.fd(), rd.name(), &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISDIR(st.st_mode)) {
+						push_error(r, n->dirpath + "/" + rd.name(), err);
+						n->failed = true;
+						continue;
+					}
+				}
+				found.push_back(new_node(n, n->dirpath + "/" + rd.name(), rd.name()));
+			}
+#endif
+			// counted before finish, which would otherwise remove n right away
+			n->pending += (long)found.size();
+			finish(n, r);
+		}
+
+	};
+
+// (REMOVE_ALL)
+	// Same as remove_all(p, result) from filesystem.hpp, spread over threads
+	// (0 = one per core). Counts and errors from all threads end up in result.
+	inline bool remove_all(const path& p, remove_result& result, unsigned threads) {
+		threads = pool_threads(threads);
+		if (threads <= 1 || !is_directory(p)) return remove_all(p, result);
+#if !defined(_WIN32)
+		// is_directory follows symlinks, a link to a directory only loses the link
+		struct stat lst;
+		if (lstat(p.c_str(), &lst) == 0 && !S_ISDIR(lst.st_mode)) return remove_all(p, result);
+#endif
+
+		std::vector<remove_result> results(threads);
+		job_pool<remove_detail::node*> jobs;
+		jobs.push(remove_detail::new_node(NULL, p.string(), p.c_str()));
+		jobs.run(threads, [&](unsigned t, remove_detail::node* n, std::vector<remove_detail::node*>& more) {
+			remove_detail::scan(n, results[t], more);
+		});
+
+		for (size_t i = 0; i < results.size(); i++) {
+			result.files += results[i].files;
+			result.directories += results[i].directories;
+			result.errors.insert(result.errors.end(), results[i].errors.begin(), results[i].errors.end());
+		}
+		return result.ok();
+	}
+
+};
+
+#endif // FS_REMOVE_HPP
@@ -0,0 +1,372 @@
+/*
+
+	Copyright (C) Nico Rajala 2025
+
+	fs_usage.hpp
+	du style disk usage over directory trees, on top of filesystem.hpp.
+
+	Needs C++11 (std::thread).
+
+	One pass collects apparent bytes, allocated bytes and counts for the
+	whole tree, totals per subtree down to a chosen depth, and the N
+	largest files. Each directory is a job for the pool in fs_jobs.hpp,
+	like in fs_remove.hpp. Directories are opened (O_NOFOLLOW) and entries
+	stat'ed relative to the parent's fd with only the fields du needs, and
+	a directory's totals are handed to its parent once everything below it
+	is done, so nothing is walked twice.
+
+	Files with more than one link are counted once per tree, by device and
+	inode, the way du does. Symlinks are counted as themselves and never
+	followed.
+
+	Usage:
+		fs::usage_options opt;
+		opt.depth = 1;
+		opt.largest = 20;
+		fs::usage_result r;
+		fs::disk_usage("build", r, opt);
+		printf("%llu bytes in %llu files\n", r.total.bytes, r.total.files);
+		for (size_t i = 0; i < r.subtrees.size(); i++) ...
+
+	Table of contents: () - functions [] - classes/structs/other
+		[USAGE_RESULT]
+		(DISK_USAGE)
+
+*/
+
+#ifndef FS_USAGE_HPP
+#define FS_USAGE_HPP
+
+#include "filesystem.hpp"
+#include "fs_jobs.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+
+namespace fs {
+
+// [USAGE_RESULT]
+	struct usage_totals {
+		unsigned long long bytes;			// apparent size, what ls -l shows
+		unsigned long long allocated;		// what the filesystem actually uses
+		unsigned long long files;			// regular files
+		unsigned long long directories;		// including the subtree's root
+		unsigned long long others;			// symlinks, devices, sockets, fifos
+
+		usage_totals() : bytes(0), allocated(0), files(0), directories(0), others(0) {}
+
+		void add(const usage_totals& o) {
+			bytes += o.bytes;
+			allocated += o.allocated;
+			files += o.files;
+			directories += o.directories;
+			others += o.others;
+		}
+	};
+
+	struct usage_subtree {
+		std::string path;
+		int depth;				// 0 for the root
+		usage_totals totals;
+	};
+
+	struct usage_file {
+		std::string path;
+		unsigned long long bytes, allocated;
+	};
+
+	struct usage_error {
+		std::string path;
+		int error;				// errno, or GetLastError() on windows
+	};
+
+	struct usage_options {
+		int depth;				// report subtrees down to this depth, -1 for every directory
+		size_t largest;			// keep the N largest files by apparent size
+		bool one_filesystem;	// don't cross into other mounts (du -x)
+		bool count_links;		// count every hardlink again (du -l)
+		unsigned threads;		// 0 = one per core
+
+		usage_options() : depth(0), largest(0), one_filesystem(false), count_links(false), threads(0) {}
+	};
+
+	struct usage_result {
+		usage_totals total;
+		unsigned long long hardlinks_skipped;	// extra links to files already counted
+		std::vector<usage_subtree> subtrees;	// sorted by path
+		std::vector<usage_file> largest;		// biggest first
+		std::vector<usage_error> errors;
+
+		usage_result() : hardlinks_skipped(0) {}
+		bool ok() const { return errors.empty(); }
+	};
+
+// (DISK_USAGE)
+	namespace usage_detail {
+
+		struct node {
+			std::string dirpath;
+			node* parent;
+#if !defined(_WIN32)
+			// open while the node lives, children are opened relative to it
+			directory_reader* rd;
+			std::string name;				// relative to the parent's fd, the whole path for the root
+#endif
+			int depth;
+			std::atomic<long> pending;		// the scan itself + subdirectories not finished yet
+			std::mutex lock;				// guards totals, children add into it from any thread
+			usage_totals totals;
+		};
+
+		struct inode_key {
+			unsigned long long dev, ino;
+			bool operator==(const inode_key& o) const { return dev == o.dev && ino == o.ino; }
+		};
+		struct inode_hash {
+			size_t operator()(const inode_key& k) const {
+				unsigned long long h = k.ino * 0x9E3779B97F4A7C15ULL ^ k.dev;
+				return (size_t)(h ^ (h >> 29));
+			}
+		};
+
+		// Only files with nlink > 1 land here, so on most trees it stays tiny.
+		// Sharded so threads that do hit it rarely meet on the same lock.
+		struct inode_set {
+			enum { shards = 32 };
+			std::mutex locks[shards];
+			std::unordered_set<inode_key, inode_hash> sets[shards];
+
+			// true the first time a key is seen
+			bool insert(const inode_key& k) {
+				size_t s = inode_hash()(k) % shards;
+				std::lock_guard<std::mutex> g(locks[s]);
+				return sets[s].insert(k).second;
+			}
+		};
+
+		// what one thread collects, merged at the end
+		struct tally {
+			std::vector<usage_subtree> subtrees;
+			std::vector<usage_file> largest;	// min-heap on bytes while collecting
+			std::vector<usage_error> errors;
+			unsigned long long hardlinks_skipped;
+
+			tally() : hardlinks_skipped(0) {}
+		};
+
+		struct state {
+			const usage_options* opt;
+			unsigned long long root_dev;
+			inode_set inodes;
+			usage_totals total;				// the root's totals once it finishes
+		};
+
+		inline bool heap_less(const usage_file& a, const usage_file& b) { return a.bytes > b.bytes; }
+
+		inline void push_error(tally& t, const std::string& p, int err) {
+			usage_error e = { p, err };
+			t.errors.push_back(e);
+		}
+
+		inline void consider_largest(state& st, tally& t, const std::string& dir, const char* name, const file_status& fst) {
+			// dir already ends in a separator
+			size_t n = st.opt->largest;
+			if (!n) return;
+			if (t.largest.size() == n && fst.size <= t.largest.front().bytes) return;
+			usage_file f;
+			f.path = dir;
+			f.path += name;
+			f.bytes = fst.size;
+			f.allocated = fst.blocks;
+			if (t.largest.size() == n) {
+				std::pop_heap(t.largest.begin(), t.largest.end(), heap_less);
+				t.largest.back() = f;
+			}
+			else {
+				t.largest.push_back(f);
+			}
+			std::push_heap(t.largest.begin(), t.largest.end(), heap_less);
+		}
+
+		// drops one pending count of n, when that was the last one its totals
+		// are final: report them and fold them into the parent
+		inline void finish(state& st, node* n, tally& t) {
+			while (n && --n->pending == 0) {
+				if (st.opt->depth < 0 || n->depth <= st.opt->depth) {
+					usage_subtree s;
+					s.path = n->dirpath;
+					s.depth = n->depth;
+					s.totals = n->totals;
+					t.subtrees.push_back(s);
+				}
+				node* parent = n->parent;
+				if (parent) {
+					std::lock_guard<std::mutex> g(parent->lock);
+					parent->totals.add(n->totals);
+				}
+				else {
+					st.total = n->totals;
+				}
+#if !defined(_WIN32)
+				delete n->rd;
+#endif
+				delete n;
+				n = parent;
+			}
+		}
+
+		inline node* new_node(node* parent, const std::string& dirpath, const char* name) {
+			node* c = new node();
+			c->dirpath = dirpath;
+			c->parent = parent;
+#if defined(_WIN32)
+			(void)name;
+#else
+			c->rd = NULL;
+			c->name = name;
+#endif
+			c->depth = parent ? parent->depth + 1 : 0;
+			c->pending = 1;
+			return c;
+		}
+
+		// lists n, the subdirectories it finds go to found
+		inline void scan(state& st, node* n, tally& t, std::vector<node*>& found) {
+			const unsigned fields = status_type | status_size | status_blocks | status_ino | status_nlink;
+			usage_totals local;
+			std::string prefix = n->dirpath;
+			if (prefix[prefix.size() - 1] != '/' && prefix[prefix.size() - 1] != PATH_SEP) prefix += PATH_SEP;
+
+#if defined(_WIN32)
+			directory_reader rd(path(n->dirpath));
+			if (!rd.is_open()) push_error(t, n->dirpath, (int)GetLastError());
+#else
+			// the root may be a symlink to a directory, disk_usage followed it
+			if (n->parent) n->rd = new directory_reader(n->parent->rd->fd(), n->name.c_str());
+			else n->rd = new directory_reader(path(n->dirpath));
+			int open_err = errno;
+			directory_reader& rd = *n->rd;
+			// ENOTDIR and ELOOP: swapped for a file or symlink since the
+			// parent listed it, nothing to count below it
+			if (!rd.is_open() && open_err != ENOENT && open_err != ENOTDIR && open_err != ELOOP) push_error(t, n->dirpath, open_err);
+#endif
+			while (rd.next()) {
+				file_status fst;
+#if defined(_WIN32)
+				std::string child = prefix + rd.name();
+				int err = stat_at(cwd_fd, child.c_str(), fst, fields, false);
+#else
+				int err = stat_at(rd.fd(), rd.name(), fst, fields, false);
+#endif
+				if (err) {
+					if (err != ENOENT) push_error(t, prefix + rd.name(), err);
+					continue;
+				}
+
+				if (fst.type == file_type_directory) {
+					if (st.opt->one_filesystem && fst.dev != st.root_dev) continue;
+					node* c = new_node(n, prefix + rd.name(), rd.name());
+					c->totals.bytes = fst.size;
+					c->totals.allocated = fst.blocks;
+					c->totals.directories = 1;
+					found.push_back(c);
+					continue;
+				}
+
+				if (fst.nlink > 1 && !st.opt->count_links) {
+					inode_key k = { fst.dev, fst.ino };
+					if (!st.inodes.insert(k)) {
+						t.hardlinks_skipped++;
+						continue;
+					}
+				}
+				local.bytes += fst.size;
+				local.allocated += fst.blocks;
+				if (fst.type == file_type_regular) {
+					local.files++;
+					consider_largest(st, t, prefix, rd.name(), fst);
+				}
+				else {
+					local.others++;
+				}
+			}
+
+			{
+				std::lock_guard<std::mutex> g(n->lock);
+				n->totals.add(local);
+			}
+			// counted before finish, which would otherwise hand n up right away
+			n->pending += (long)found.size();
+			finish(st, n, t);
+		}
+
+		inline bool by_path(const usage_subtree& a, const usage_subtree& b) { return a.path < b.path; }
+
+	};
+
+	// Walks root and fills result. Returns false if root couldn't be read at
+	// all or anything below it failed, result.errors says what. Totals cover
+	// everything that could be read either way.
+	inline bool disk_usage(const path& root, usage_result& result, const usage_options& opt = usage_options()) {
+		const unsigned fields = status_type | status_size | status_blocks | status_ino | status_nlink;
+		file_status fst;
+		int err = stat_at(cwd_fd, root.c_str(), fst, fields, true);
+		if (err) {
+			usage_error e = { root.string(), err };
+			result.errors.push_back(e);
+			return false;
+		}
+
+		if (fst.type != file_type_directory) {
+			result.total.bytes = fst.size;
+			result.total.allocated = fst.blocks;
+			if (fst.type == file_type_regular) result.total.files = 1;
+			else result.total.others = 1;
+			if (opt.largest && fst.type == file_type_regular) {
+				usage_file f = { root.string(), fst.size, fst.blocks };
+				result.largest.push_back(f);
+			}
+			return true;
+		}
+
+		unsigned threads = pool_threads(opt.threads);
+
+		usage_detail::state st;
+		st.opt = &opt;
+		st.root_dev = fst.dev;
+
+		std::string dirpath = root.string();
+		while (dirpath.size() > 1 && (dirpath[dirpath.size() - 1] == '/' || dirpath[dirpath.size() - 1] == PATH_SEP))
+			dirpath.erase(dirpath.size() - 1);
+		usage_detail::node* n = usage_detail::new_node(NULL, dirpath, dirpath.c_str());
+		n->totals.bytes = fst.size;
+		n->totals.allocated = fst.blocks;
+		n->totals.directories = 1;
+
+		std::vector<usage_detail::tally> tallies(threads);
+		job_pool<usage_detail::node*> jobs;
+		jobs.push(n);
+		jobs.run(threads, [&](unsigned t, usage_detail::node* d, std::vector<usage_detail::node*>& more) {
+			usage_detail::scan(st, d, tallies[t], more);
+		});
+
+		result.total = st.total;
+		std::vector<usage_file> largest;
+		for (size_t i = 0; i < tallies.size(); i++) {
+			usage_detail::tally& t = tallies[i];
+			result.hardlinks_skipped += t.hardlinks_skipped;
+			result.subtrees.insert(result.subtrees.end(), t.subtrees.begin(), t.subtrees.end());
+			result.errors.insert(result.errors.end(), t.errors.begin(), t.errors.end());
+			largest.insert(largest.end(), t.largest.begin(), t.largest.end());
+		}
+		std::sort(result.subtrees.begin(), result.subtrees.end(), usage_detail::by_path);
+		std::sort(largest.begin(), largest.end(), usage_detail::heap_less);
+		if (largest.size() > opt.largest) largest.resize(opt.largest);
+		result.largest.insert(result.largest.end(), largest.begin(), largest.end());
+		return result.ok();
+	}
+
+};
+
+#endif // FS_USAGE_HPP
@@ -0,0 +1,539 @@
+/*
+
+	Copyright (C) Nico Rajala 2025
+
+	fs_watch.hpp
+	File watching on top of filesystem.hpp. Uses inotify on linux and
+	falls back to polling (rescanning the watched directories and diffing
+	them against a snapshot) everywhere else, or when asked to, which is
+	handy for filesystems that don't deliver inotify events (network and
+	fuse mounts, some container overlays).
+
+	Events are collected and coalesced between calls to drain(), so a file
+	that is written a hundred times shows up as a single modified event and
+	a temp file that is created and deleted again doesn't show up at all.
+
+	If the inotify queue overflows the watched directories are rescanned and
+	diffed against their snapshots, so nothing is lost, only the renames in
+	the lost part come out as a delete and a create. The polling backend
+	always reports renames that way.
+
+	Usage:
+		fs::watcher w;
+		w.add("assets");				// recursive by default
+		std::vector<fs::watch_event> events;
+		for (;;) {
+			w.drain(events, 1000);		// waits up to a second for changes
+			for (size_t i = 0; i < events.size(); i++) ...
+			events.clear();
+		}
+
+	Table of contents: () - functions [] - classes/structs/other
+		[WATCH_EVENT]
+		[WATCHER]
+
+*/
+
+#ifndef FS_WATCH_HPP
+#define FS_WATCH_HPP
+
+#include "filesystem.hpp"
+
+#include <map>
+#include <thread>
+#include <chrono>
+
+#if defined(__linux__)
+	#include <sys/inotify.h>
+	#include <poll.h>
+#endif
+
+namespace fs {
+
+// [WATCH_EVENT]
+	enum watch_event_type {
+		watch_created,
+		watch_modified,
+		watch_deleted,
+		watch_renamed		// old_path -> path
+	};
+
+	struct watch_event {
+		watch_event_type type;
+		std::string path;
+		std::string old_path;
+		bool is_directory;
+	};
+
+// [WATCHER]
+	class watcher {
+	public:
+		enum backend {
+			backend_auto,		// inotify where available, polling otherwise
+			backend_inotify,
+			backend_polling
+		};
+
+	private:
+		struct snapshot_entry {
+			file_type type;
+			unsigned long long size;
+			long long mtime;
+		};
+
+		struct watched_dir {
+			int wd;				// inotify watch, -1 if this directory is polled
+			bool recursive;
+			std::map<std::string, snapshot_entry> entries;
+		};
+
+		struct pending_event {
+			watch_event ev;
+			bool dropped;
+			bool applied;		// snapshot already reflects it
+		};
+
+		std::map<std::string, watched_dir> m_dirs;
+		std::map<int, std::string> m_wds;
+		std::vector<pending_event> m_pending;
+		std::map<std::string, size_t> m_pending_index;
+		std::map<unsigned, std::pair<std::string, bool> > m_moves;	// inotify cookie -> moved-from path, is dir
+		int m_fd;
+		int m_poll_interval;
+
+		watcher(const watcher&);
+		watcher& operator=(const watcher&);
+
+		static std::string join(const std::string& dir, const std::string& name) {
+			std::string p = dir;
+			if (!p.empty() && p[p.size() - 1] != '/' && p[p.size() - 1] != '\\') p += PATH_SEP;
+			return p + name;
+		}
+
+		static void split(const std::string& p, std::string& dir, std::string& name) {
+			size_t pos = p.find_last_of("/\\");
+			if (pos == std::string::npos) { dir.clear(); name = p; return; }
+			dir = p.substr(0, pos ? pos : 1);
+			name = p.substr(pos + 1);
+		}
+
+		static void read_listing(const std::string& dir, std::map<std::string, snapshot_entry>& out) {
+			directory_reader r(dir);
+			while (r.next()) {
+				snapshot_entry se;
+				if (!r.stat(se.type, se.size, se.mtime)) continue;
+				out[r.name()] = se;
+			}
+		}
+
+		static bool stat_path(const std::string& p, snapshot_entry& se) {
+			file_status fst;
+			if (stat_at(cwd_fd, p.c_str(), fst, status_type | status_size | status_mtime, false) != 0) return false;
+			se.type = fst.type;
+			se.size = se.type == file_type_directory ? 0 : fst.size;
+			se.mtime = fst.mtime;
+			return true;
+		}
+
+		// Queues a change for the next drain, merging it with what is already
+		// queued for the same path. A rename followed by writes to the new
+		// name is reported as just the rename.
+		void record(watch_event_type type, const std::string& p, bool is_dir, bool applied, const std::string& old_path = std::string()) {
+			if (type == watch_renamed) {
+				std::map<std::string, size_t>::iterator it = m_pending_index.find(old_path);
+				if (it != m_pending_index.end() && !m_pending[it->second].dropped) {
+					pending_event& prev = m_pending[it->second];
+					prev.dropped = true;
+					m_pending_index.erase(it);
+					if (prev.ev.type == watch_created) {
+						record(watch_created, p, is_dir, applied);
+						return;
+					}
+					if (prev.ev.type == watch_renamed) {
+						record(watch_renamed, p, is_dir, applied, prev.ev.old_path);
+						return;
+					}
+				}
+			}
+
+			std::map<std::string, size_t>::iterator it = m_pending_index.find(p);
+			if (it != m_pending_index.end() && !m_pending[it->second].dropped) {
+				pending_event& prev = m_pending[it->second];
+				prev.applied = prev.applied && applied;
+				switch (prev.ev.type) {
+				case watch_created:
+					if (type == watch_deleted) { prev.dropped = true; m_pending_index.erase(it); }
+					return;
+				case watch_modified:
+					if (type == watch_deleted || type == watch_renamed) break;
+					return;
+				case watch_deleted:
+					if (type == watch_created) { prev.ev.type = watch_modified; return; }
+					break;
+				case watch_renamed:
+					if (type == watch_deleted) {
+						// renamed away and then deleted, the original went missing
+						std::string from = prev.ev.old_path;
+						prev.dropped = true;
+						m_pending_index.erase(it);
+						record(watch_deleted, from, is_dir, applied);
+						return;
+					}
+					if (type == watch_modified) return;
+					break;
+				}
+				prev.dropped = true;
+				m_pending_index.erase(it);
+			}
+
+			pending_event pe;
+			pe.ev.type = type;
+			pe.ev.path = p;
+			pe.ev.old_path = old_path;
+			pe.ev.is_directory = is_dir;
+			pe.dropped = false;
+			pe.applied = applied;
+			m_pending_index[p] = m_pending.size();
+			m_pending.push_back(pe);
+		}
+
+		// Registers dir (and everything below it when recursive) and takes the
+		// snapshot. With emit set every entry is reported as created, which is
+		// used for directories that appear after the watch was set up, since
+		// files can land in them before their own watch exists.
+		void add_dir(const std::string& dir, bool recursive, bool emit) {
+			if (m_dirs.count(dir)) return;
+
+			watched_dir& wdir = m_dirs[dir];
+			wdir.recursive = recursive;
+			wdir.wd = -1;
+#if defined(__linux__)
+			if (m_fd >= 0) {
+				wdir.wd = inotify_add_watch(m_fd, dir.c_str(),
+					IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO |
+					IN_DELETE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK);
+				// out of watches (ENOSPC) and friends: this directory is polled instead
+				if (wdir.wd >= 0) m_wds[wdir.wd] = dir;
+			}
+#endif
+			read_listing(dir, wdir.entries);
+
+			std::vector<std::string> subdirs;
+			for (std::map<std::string, snapshot_entry>::iterator it = wdir.entries.begin(); it != wdir.entries.end(); ++it) {
+				bool isdir = it->second.type == file_type_directory;
+				if (emit) record(watch_created, join(dir, it->first), isdir, true);
+				if (isdir && recursive) subdirs.push_back(join(dir, it->first));
+			}
+			for (size_t i = 0; i < subdirs.size(); i++) add_dir(subdirs[i], recursive, emit);
+		}
+
+		// Reports everything the snapshots hold below dir as deleted, children
+		// before their directory, the way inotify reports a removed tree.
+		void record_subtree_deleted(const std::string& dir) {
+			std::map<std::string, watched_dir>::iterator d = m_dirs.find(dir);
+			if (d == m_dirs.end()) return;
+			for (std::map<std::string, snapshot_entry>::iterator it = d->second.entries.begin(); it != d->second.entries.end(); ++it) {
+				std::string p = join(dir, it->first);
+				bool isdir = it->second.type == file_type_directory;
+				if (isdir) record_subtree_deleted(p);
+				record(watch_deleted, p, isdir, true);
+			}
+		}
+
+		// forgets dir and every watched directory below it
+		void remove_dir(const std::string& dir) {
+			std::map<std::string, watched_dir>::iterator it = m_dirs.lower_bound(dir);
+			while (it != m_dirs.end() && it->first.compare(0, dir.size(), dir) == 0) {
+				const std::string& k = it->first;
+				if (k.size() > dir.size() && k[dir.size()] != '/' && k[dir.size()] != '\\') { ++it; continue; }
+#if defined(__linux__)
+				if (it->second.wd >= 0) {
+					inotify_rm_watch(m_fd, it->second.wd);
+					m_wds.erase(it->second.wd);
+				}
+#endif
+				m_dirs.erase(it++);
+			}
+		}
+
+		// moves the watch state of a renamed directory subtree to its new path
+		void rename_dir(const std::string& from, const std::string& to) {
+			std::vector<std::pair<std::string, watched_dir> > moved;
+			std::map<std::string, watched_dir>::iterator it = m_dirs.lower_bound(from);
+			while (it != m_dirs.end() && it->first.compare(0, from.size(), from) == 0) {
+				const std::string& k = it->first;
+				if (k.size() > from.size() && k[from.size()] != '/' && k[from.size()] != '\\') { ++it; continue; }
+				moved.push_back(std::make_pair(to + k.substr(from.size()), it->second));
+				m_dirs.erase(it++);
+			}
+			for (size_t i = 0; i < moved.size(); i++) {
+				m_dirs[moved[i].first] = moved[i].second;
+				if (moved[i].second.wd >= 0) m_wds[moved[i].second.wd] = moved[i].first;
+			}
+		}
+
+		// Lists one directory and diffs it against its snapshot. Only called
+		// for polled directories and after an inotify queue overflow.
+		void rescan_dir(const std::string& dir) {
+			std::map<std::string, watched_dir>::iterator dit = m_dirs.find(dir);
+			if (dit == m_dirs.end()) return;
+
+			if (!is_directory(dir)) return;		// the parent's rescan reports it
+			std::map<std::string, snapshot_entry> now;
+			read_listing(dir, now);
+
+			bool recursive = dit->second.recursive;
+			std::map<std::string, snapshot_entry> old;
+			old.swap(dit->second.entries);
+			dit->second.entries = now;
+
+			std::vector<std::string> added;
+			for (std::map<std::string, snapshot_entry>::iterator it = now.begin(); it != now.end(); ++it) {
+				std::map<std::string, snapshot_entry>::iterator o = old.find(it->first);
+				bool isdir = it->second.type == file_type_directory;
+				std::string p = join(dir, it->first);
+
+				if (o != old.end() && (o->second.type == file_type_directory) != isdir) {
+					if (o->second.type == file_type_directory) {
+						record_subtree_deleted(p);
+						remove_dir(p);
+					}
+					record(watch_deleted, p, !isdir, true);
+					o = old.end();
+				}
+
+				if (o == old.end()) {
+					record(watch_created, p, isdir, true);
+					if (isdir && recursive) added.push_back(p);
+				}
+				else if (!isdir && (o->second.size != it->second.size || o->second.mtime != it->second.mtime)) {
+					record(watch_modified, p, false, true);
+				}
+			}
+			for (std::map<std::string, snapshot_entry>::iterator it = old.begin(); it != old.end(); ++it) {
+				if (now.count(it->first)) continue;
+				std::string p = join(dir, it->first);
+				if (it->second.type == file_type_directory) {
+					record_subtree_deleted(p);
+					remove_dir(p);
+				}
+				record(watch_deleted, p, it->second.type == file_type_directory, true);
+			}
+			for (size_t i = 0; i < added.size(); i++) add_dir(added[i], recursive, true);
+		}
+
+		// brings the snapshots up to date with the inotify events queued so far
+		void apply_pending() {
+			for (size_t i = 0; i < m_pending.size(); i++) {
+				pending_event& pe = m_pending[i];
+				if (pe.dropped || pe.applied) continue;
+				pe.applied = true;
+
+				std::string dir, name;
+				if (pe.ev.type == watch_renamed) {
+					split(pe.ev.old_path, dir, name);
+					std::map<std::string, watched_dir>::iterator d = m_dirs.find(dir);
+					if (d != m_dirs.end()) d->second.entries.erase(name);
+				}
+
+				split(pe.ev.path, dir, name);
+				std::map<std::string, watched_dir>::iterator d = m_dirs.find(dir);
+				if (d == m_dirs.end()) continue;
+				snapshot_entry se;
+				if (pe.ev.type != watch_deleted && stat_path(pe.ev.path, se)) d->second.entries[name] = se;
+				else d->second.entries.erase(name);
+			}
+		}
+
+#if defined(__linux__)
+		// reads everything inotify has queued, returns true if the queue overflowed
+		bool read_inotify() {
+			bool overflow = false;
+			char buf[64 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+			for (;;) {
+				ssize_t n = read(m_fd, buf, sizeof(buf));
+				if (n <= 0) break;
+
+				for (char* at = buf; at < buf + n; ) {
+					const struct inotify_event* ie = (const struct inotify_event*)at;
+					at += sizeof(struct inotify_event) + ie->len;
+
+					if (ie->mask & IN_Q_OVERFLOW) { overflow = true; continue; }
+
+					std::map<int, std::string>::iterator w = m_wds.find(ie->wd);
+					if (w == m_wds.end()) continue;
+					const std::string dir = w->second;
+
+					if (ie->mask & (IN_DELETE_SELF | IN_IGNORED)) {
+						// the parent reports the delete, just drop the watch state
+						if (ie->mask & IN_IGNORED) {
+							m_wds.erase(ie->wd);
+							std::map<std::string, watched_dir>::iterator d = m_dirs.find(dir);
+							if (d != m_dirs.end() && d->second.wd == ie->wd) d->second.wd = -1;
+						}
+						continue;
+					}
+					if (!ie->len) continue;
+
+					std::map<std::string, watched_dir>::iterator d = m_dirs.find(dir);
+					if (d == m_dirs.end()) continue;
+					bool recursive = d->second.recursive;
+					std::string p = join(dir, ie->name);
+					bool isdir = (ie->mask & IN_ISDIR) != 0;
+
+					if (ie->mask & IN_MOVED_FROM) {
+						m_moves[ie->cookie] = std::make_pair(p, isdir);
+					}
+					else if (ie->mask & IN_MOVED_TO) {
+						std::map<unsigned, std::pair<std::string, bool> >::iterator mv = m_moves.find(ie->cookie);
+						if (mv != m_moves.end()) {
+							// paired with its move-from, the two make a rename
+							std::string old_path = mv->second.first;
+							m_moves.erase(mv);
+							if (isdir) rename_dir(old_path, p);
+							record(watch_renamed, p, isdir, false, old_path);
+						}
+						else {
+							record(watch_created, p, isdir, false);
+							if (isdir && recursive) add_dir(p, true, true);
+						}
+					}
+					else if (ie->mask & IN_CREATE) {
+						record(watch_created, p, isdir, false);
+						if (isdir && recursive) add_dir(p, true, true);
+					}
+					else if (ie->mask & IN_DELETE) {
+						record(watch_deleted, p, isdir, false);
+						if (isdir) remove_dir(p);
+					}
+					else if (ie->mask & (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB)) {
+						if (!isdir) record(watch_modified, p, false, false);
+					}
+				}
+			}
+
+			// a move-from without its move-to means the entry left the watched tree
+			for (std::map<unsigned, std::pair<std::string, bool> >::iterator mv = m_moves.begin(); mv != m_moves.end(); ++mv) {
+				record(watch_deleted, mv->second.first, mv->second.second, false);
+				if (mv->second.second) remove_dir(mv->second.first);
+			}
+			m_moves.clear();
+			return overflow;
+		}
+#endif
+
+		// one pass over the event sources
+		void collect(int timeout_ms) {
+#if defined(__linux__)
+			if (m_fd >= 0) {
+				struct pollfd pfd;
+				pfd.fd = m_fd;
+				pfd.events = POLLIN;
+				pfd.revents = 0;
+				if (poll(&pfd, 1, timeout_ms) > 0 && read_inotify()) {
+					// Events were lost. Bring the snapshots up to date with what
+					// did arrive and diff every watched directory against them.
+					apply_pending();
+					std::vector<std::string> dirs;
+					for (std::map<std::string, watched_dir>::iterator it = m_dirs.begin(); it != m_dirs.end(); ++it)
+						dirs.push_back(it->first);
+					for (size_t i = 0; i < dirs.size(); i++) rescan_dir(dirs[i]);
+				}
+			}
+#else
+			(void)timeout_ms;
+#endif
+			apply_pending();
+
+			// directories without an inotify watch are polled
+			std::vector<std::string> polled;
+			for (std::map<std::string, watched_dir>::iterator it = m_dirs.begin(); it != m_dirs.end(); ++it)
+				if (it->second.wd < 0) polled.push_back(it->first);
+			for (size_t i = 0; i < polled.size(); i++) rescan_dir(polled[i]);
+		}
+
+		bool has_pending() const {
+			for (size_t i = 0; i < m_pending.size(); i++)
+				if (!m_pending[i].dropped) return true;
+			return false;
+		}
+
+	public:
+		watcher(backend b = backend_auto) : m_fd(-1), m_poll_interval(250) {
+#if defined(__linux__)
+			if (b != backend_polling) m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#else
+			(void)b;
+#endif
+		}
+
+		~watcher() {
+#if defined(__linux__)
+			if (m_fd >= 0) close(m_fd);
+#endif
+		}
+
+		// false if inotify isn't available and every directory gets polled
+		bool native() const { return m_fd >= 0; }
+
+		// how often drain() rescans polled directories while it waits
+		void set_poll_interval(int ms) { m_poll_interval = ms > 0 ? ms : 1; }
+
+		// starts watching a directory, existing contents are not reported
+		bool add(const path& dir, bool recursive = true) {
+			std::string d = dir.string();
+			while (d.size() > 1 && (d[d.size() - 1] == '/' || d[d.size() - 1] == '\\')) d.erase(d.size() - 1);
+			if (!is_directory(d)) return false;
+			add_dir(d, recursive, false);
+			return true;
+		}
+
+		void remove(const path& dir) {
+			std::string d = dir.string();
+			while (d.size() > 1 && (d[d.size() - 1] == '/' || d[d.size() - 1] == '\\')) d.erase(d.size() - 1);
+			remove_dir(d);
+		}
+
+		// number of directories being watched (or polled)
+		size_t watched_count() const { return m_dirs.size(); }
+
+		// Appends the changes since the last drain to out, waiting up to
+		// timeout_ms for the first one (0 = don't wait, -1 = forever).
+		// Returns the number of events appended.
+		size_t drain(std::vector<watch_event>& out, int timeout_ms = 0) {
+			std::chrono::steady_clock::time_point until = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms < 0 ? 0 : timeout_ms);
+
+			bool any_polled = !native();
+			for (std::map<std::string, watched_dir>::iterator it = m_dirs.begin(); !any_polled && it != m_dirs.end(); ++it)
+				any_polled = it->second.wd < 0;
+
+			for (;;) {
+				int wait = 0;
+				if (timeout_ms != 0) {
+					long long left = std::chrono::duration_cast<std::chrono::milliseconds>(until - std::chrono::steady_clock::now()).count();
+					wait = timeout_ms < 0 ? -1 : (int)(left > 0 ? left : 0);
+					if (any_polled && (wait < 0 || wait > m_poll_interval)) wait = m_poll_interval;
+				}
+
+				// inotify blocks in poll(), the polling backend sleeps between rescans
+				collect(native() ? wait : 0);
+				if (has_pending() || timeout_ms == 0) break;
+				if (timeout_ms > 0 && std::chrono::steady_clock::now() >= until) break;
+				if (!native() && wait > 0) std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+			}
+
+			size_t n = 0;
+			for (size_t i = 0; i < m_pending.size(); i++) {
+				if (m_pending[i].dropped) continue;
+				out.push_back(m_pending[i].ev);
+				n++;
+			}
+			m_pending.clear();
+			m_pending_index.clear();
+			return n;
+		}
+	};
+
+};
+
+#endif
@@ -0,0 +1,215 @@
+/*
+
+	Copyright (C) Nico Rajala 2025
+
+	fs_test.cpp
+	Runs the filesystem headers against a scratch tree in the current
+	directory: XXH64 vectors, an interrupted and resumed chunked copy,
+	glob, the file index on a deep tree, directory_cache going stale,
+	disk usage and the threaded remove_all.
+
+	Exits with 1 and says what failed.
+
+*/
+
+#include "filesystem.hpp"
+#include "fs_hash.hpp"
+#include "fs_copy.hpp"
+#include "fs_glob.hpp"
+#include "fs_index.hpp"
+#include "fs_usage.hpp"
+#include "fs_remove.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+	if (ok) return;
+	printf("FAIL: %s\n", what);
+	failures++;
+}
+
+static const std::string root = "fs_test_tmp";
+
+static bool write_file(const std::string& p, const void* data, size_t n) {
+	FILE* f = fopen(p.c_str(), "wb");
+	if (!f) return false;
+	bool ok = n == 0 || fwrite(data, 1, n, f) == n;
+	return fclose(f) == 0 && ok;
+}
+
+static bool write_file(const std::string& p, const char* text) { return write_file(p, text, strlen(text)); }
+
+static void test_hash() {
+	check(fs::hash_bytes("", 0) == 0xef46db3751d8e999ULL, "XXH64 of \"\"");
+	check(fs::hash_bytes("a", 1) == 0xd24ec4f1a98c6e5bULL, "XXH64 of \"a\"");
+	check(fs::hash_bytes("abc", 3) == 0x44bc2cf5ad770999ULL, "XXH64 of \"abc\"");
+	check(fs::hash_to_hex(0x44bc2cf5ad770999ULL) == "44bc2cf5ad770999", "hash_to_hex");
+
+	// streamed in odd pieces it must match the one shot hash
+	std::vector<unsigned char> v(10007);
+	for (size_t i = 0; i < v.size(); i++) v[i] = (unsigned char)(i * 131 + 7);
+	uint64_t ref = fs::hash_bytes(&v[0], v.size());
+	bool same = true;
+	for (size_t step = 1; step < 80; step += 7) {
+		fs::hasher h;
+		for (size_t o = 0; o < v.size(); o += step) h.update(&v[o], step < v.size() - o ? step : v.size() - o);
+		if (h.digest() != ref) same = false;
+	}
+	check(same, "streamed XXH64 differs from one shot");
+}
+
+static void test_chunked_copy() {
+	std::string src = root + "/copy_src.bin", dst = root + "/copy_dst.bin";
+	std::vector<unsigned char> data(3 << 20);
+	for (size_t i = 0; i < data.size(); i++) data[i] = (unsigned char)(i * 2654435761u >> 13);
+	check(write_file(src, &data[0], data.size()), "writing the copy source");
+	uint64_t ref = fs::hash_bytes(&data[0], data.size());
+
+	fs::chunked_copy_options opt;
+	opt.flags = fs::copy_resume | fs::copy_checksum;
+	opt.chunk_size = 256 << 10;
+	opt.sync_every = 2;
+	opt.progress = [](unsigned long long done, unsigned long long total) { return done < total / 2; };
+	fs::chunked_copy_result r;
+	bool ok = fs::copy_file_chunked(src, dst, opt, &r);
+	check(!ok && r.error == ECANCELED, "a copy stopped by progress didn't report ECANCELED");
+	check(fs::exists(dst + ".part") && fs::exists(dst + ".part.journal"), "a stopped copy left no part file and journal");
+	check(!fs::exists(dst), "a stopped copy created dst");
+
+	opt.flags |= fs::copy_verify;
+	opt.progress = nullptr;
+	fs::chunked_copy_result r2;
+	ok = fs::copy_file_chunked(src, dst, opt, &r2);
+	check(ok, "resuming the copy failed");
+	check(r2.resumed > 0 && r2.resumed + r2.copied == data.size(), "the resumed copy didn't keep the journaled prefix");
+	check(r2.checksum == ref, "the copy's checksum isn't the source's XXH64");
+	uint64_t h = 0;
+	check(fs::hash_file(dst, h) && h == ref, "the copied file differs from the source");
+	check(!fs::exists(dst + ".part") && !fs::exists(dst + ".part.journal"), "a finished copy left its part file or journal");
+}
+
+static void test_glob() {
+	std::string g = root + "/glob";
+	fs::create_directories(g + "/src/a/test");
+	fs::create_directories(g + "/src/b");
+	write_file(g + "/src/a/test/t.cpp", "");
+	write_file(g + "/src/a/test/t.hpp", "");
+	write_file(g + "/src/a/x.cpp", "");
+	write_file(g + "/src/b/y.txt", "");
+	write_file(g + "/src/.hidden.cpp", "");
+
+	std::vector<std::string> out;
+	fs::glob(g + "/src/**/*.cpp", out);
+	check(out.size() == 2 && out[0] == g + "/src/a/test/t.cpp" && out[1] == g + "/src/a/x.cpp", "glob with **");
+
+	std::vector<std::string> threaded;
+	fs::glob(g + "/src/**/*.cpp", threaded, fs::glob_none, 4);
+	check(threaded == out, "threaded glob differs from the single threaded one");
+
+	out.clear();
+	fs::glob(g + "/src/**/*.cpp", out, fs::glob_dotfiles);
+	check(out.size() == 3, "glob_dotfiles doesn't match the dot file");
+
+	out.clear();
+	fs::glob(g + "/src/*/test/*.{cpp,hpp}", out);
+	check(out.size() == 2, "glob with braces after a literal component");
+
+	out.clear();
+	fs::glob(g + "/src/**", out, fs::glob_dirs_only);
+	check(out.size() == 3 && out[0] == g + "/src/a" && out[2] == g + "/src/b", "glob_dirs_only");
+
+	fs::glob_matcher m("src/**/*.cpp");
+	check(m.match("src/a/b.cpp") && m.match("src/b.cpp") && !m.match("src/a/b.hpp") && !m.match("x/b.cpp"), "glob_matcher::match");
+}
+
+// deeper than the old 256 level limit of the sorted lookup, with siblings
+// on every level so deep and shallow entries mix in path order
+static void test_index_deep() {
+	std::string p = root + "/deep";
+	for (int i = 0; i < 300; i++) {
+		fs::create_directories(p + "/a");
+		fs::create_directories(p + "/z");
+		write_file(p + "/m", "");
+		p += i % 2 ? "/a" : "/z";
+	}
+	fs::file_index idx;
+	check(idx.scan(root + "/deep", 4), "scanning the deep tree");
+	check(idx.size() == 901, "deep tree entry count");
+	size_t bad = 0;
+	for (size_t i = 0; i < idx.size(); i++) {
+		std::string q = idx.path_of(i);
+		if (idx.find(q) != i || idx.find_sorted(q) != i) bad++;
+	}
+	check(bad == 0, "lookups in the deep tree missed");
+}
+
+static void test_directory_cache() {
+	std::string d = root + "/dc/a/b/c";
+	fs::directory_cache cache;
+	check(fs::create_directories(fs::path(d), cache), "create_directories with a cache");
+	fs::remove_all(fs::path(root + "/dc/a"));
+	check(fs::create_directories(fs::path(d), cache) && fs::is_directory(fs::path(d)), "a stale cached directory wasn't created again");
+}
+
+static void test_usage_and_remove() {
+	std::string t = root + "/tree";
+	std::string keep = root + "/keep";
+	fs::create_directories(keep);
+	write_file(keep + "/k", "keep");
+	std::string block(1000, 'x');
+	for (int a = 0; a < 4; a++) {
+		for (int b = 0; b < 3; b++) {
+			char dir[64];
+			snprintf(dir, sizeof(dir), "/d%d/e%d", a, b);
+			fs::create_directories(t + dir);
+			for (int f = 0; f < 5; f++) {
+				char name[16];
+				snprintf(name, sizeof(name), "/f%d", f);
+				write_file(t + dir + name, block.data(), block.size());
+			}
+		}
+	}
+#if !defined(_WIN32)
+	// the threaded remove must take the link, not what it points to
+	check(symlink("../../keep", (t + "/d0/link").c_str()) == 0, "creating a symlink");
+#endif
+
+	fs::usage_options opt;
+	opt.threads = 4;
+	opt.largest = 3;
+	fs::usage_result u;
+	check(fs::disk_usage(t, u, opt), "disk_usage failed");
+	check(u.total.files == 60 && u.total.directories == 17, "disk_usage file and directory counts");
+	check(u.largest.size() == 3 && u.largest[0].bytes == 1000, "disk_usage largest files");
+
+	fs::remove_result r;
+	check(fs::remove_all(fs::path(t), r, 4), "threaded remove_all failed");
+	check(r.files >= 60 && r.directories == 17 && r.errors.empty(), "threaded remove_all counts");
+	check(!fs::exists(t), "threaded remove_all left the tree");
+	check(fs::exists(keep + "/k"), "threaded remove_all followed a symlink out of the tree");
+}
+
+int main() {
+	fs::remove_all(fs::path(root));
+	if (!fs::create_directories(root)) {
+		printf("FAIL: creating %s\n", root.c_str());
+		return 1;
+	}
+
+	test_hash();
+	test_chunked_copy();
+	test_glob();
+	test_index_deep();
+	test_directory_cache();
+	test_usage_and_remove();
+
+	fs::remove_all(fs::path(root));
+	if (failures) return 1;
+	printf("ok\n");
+	return 0;
+}
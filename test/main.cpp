@@ -7,6 +7,10 @@
 #include <gl/GL.h>
 #endif
 
+// Define to run the demo in a 3.3 core profile context with the GL3 GUI backend,
+// otherwise it uses a compatibility context and the fixed function backend
+// #define NSIMGUI_GL3
+
 #define NSWINDOW_IMPL_OPENGL
 #include "nswindow.hpp"
 
@@ -14,12 +18,81 @@
 
 using namespace NSWindow;
 
+#ifdef NSIMGUI_GL3
+// The triangle the fixed function path draws with glBegin, as a VAO and a shader
+struct Triangle {
+	GLuint program = 0, vao = 0, vbo = 0;
+	GLint angleLoc = -1;
+
+	void create() {
+		NSImgui::GL3Functions& gl = NSImgui::GetGL3Backend().gl;
+		program = NSImgui::CompileProgramGL3(
+			"#version 330 core\n"
+			"layout(location = 0) in vec2 aPos;\n"
+			"layout(location = 1) in vec3 aCol;\n"
+			"uniform float uAngle;\n"
+			"out vec3 vCol;\n"
+			"void main() {\n"
+			"	float c = cos(uAngle), s = sin(uAngle);\n"
+			"	vCol = aCol;\n"
+			"	gl_Position = vec4(c * aPos.x - s * aPos.y, s * aPos.x + c * aPos.y, 0.0, 1.0);\n"
+			"}\n",
+			"#version 330 core\n"
+			"in vec3 vCol;\n"
+			"out vec4 oCol;\n"
+			"void main() { oCol = vec4(vCol, 1.0); }\n");
+		angleLoc = gl.GetUniformLocation(program, "uAngle");
+		const float verts[] = {
+			0.0f, 0.5f, 1, 0, 0,
+			-0.5f, -0.5f, 0, 1, 0,
+			0.5f, -0.5f, 0, 0, 1
+		};
+		gl.GenVertexArrays(1, &vao);
+		gl.BindVertexArray(vao);
+		gl.GenBuffers(1, &vbo);
+		gl.BindBuffer(GL_ARRAY_BUFFER, vbo);
+		gl.BufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, 0x88E4 /* GL_STATIC_DRAW */);
+		gl.EnableVertexAttribArray(0);
+		gl.EnableVertexAttribArray(1);
+		gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (const void*)0);
+		gl.VertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (const void*)(2 * sizeof(float)));
+		gl.BindVertexArray(0);
+	}
+
+	void draw(float angleDegrees) {
+		NSImgui::GL3Functions& gl = NSImgui::GetGL3Backend().gl;
+		gl.UseProgram(program);
+		gl.Uniform1f(angleLoc, angleDegrees * 3.14159265f / 180.0f);
+		gl.BindVertexArray(vao);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		gl.BindVertexArray(0);
+		gl.UseProgram(0);
+	}
+};
+#endif
+
 int main() {
-	Window window(WindowDesc{ "OpenGL Triangle", 800, 600, true, false });
+	WindowDesc desc{ "OpenGL Triangle", 800, 600, true, false };
+#ifdef NSIMGUI_GL3
+	desc.glMajor = 3;
+	desc.glMinor = 3;
+	desc.glCoreProfile = true;
+#endif
+	Window window(desc);
 
 	window.makeGLCurrent();
 
-	float angle = 0.0f;
+#ifdef NSIMGUI_GL3
+	if (!NSImgui::InitGL3Backend()) {
+		std::cerr << "GL 3.3 backend failed to initialize" << std::endl;
+		return 1;
+	}
+	Triangle triangle;
+	triangle.create();
+#endif
+
+	float angle = 0.0f, drawnAngle = -1.0f;
+	bool resized = true;
 	bool show_demo = false;
 	bool prevMouseDown = false;
 
@@ -27,23 +100,22 @@ int main() {
 	window.getSize(fbw, fbh);
 
 	while (!window.shouldClose()) {
-		window.pollEvents();
+		// Sleeps until there is input or the GUI wants another frame, nothing spins while idle
+		NSImgui::WaitForNextFrame(window);
 
 		NSWindow::Event e;
 		while (window.pollEvent(e)) {
 			if (e.type == EventType::Resize) {
 				glViewport(0, 0, e.size.w, e.size.h);
+				resized = true;
 			}
 		}
 
 		// Rotate with left/right arrow keys
+		bool rotating = window.keyDown(VK_LEFT) || window.keyDown(VK_RIGHT);
 		if (window.keyDown(VK_LEFT))  angle -= 1.0f;
 		if (window.keyDown(VK_RIGHT)) angle += 1.0f;
 
-		// OpenGL rendering
-		glClearColor(0.1f, 0.1f, 0.2f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT);
-
 		int fbw, fbh, mx, my;
 		window.getSize(fbw, fbh);
 		window.getMousePosition(mx, my);
@@ -52,10 +124,13 @@ int main() {
 		bool mouseReleased = !mouseDown && prevMouseDown;
 		prevMouseDown = mouseDown;
 
-		NSImgui::NewFrame(mx, my, mouseDown, mousePressed, mouseReleased);
+		NSImgui::NewFrame(mx, my, mouseDown, mousePressed, mouseReleased, (float)window.getMouseWheel());
 
 		NSImgui::BeginGUI(fbw, fbh);
 
+		// Keep frames coming while a key is held, key repeat alone would be choppy
+		if (rotating) NSImgui::RequestRedraw();
+
 		NSImgui::LayoutGlobalDockedWindows(0, 0, (float)fbw, (float)fbh);
 
 		static bool show_demo = true;
@@ -78,11 +153,25 @@ int main() {
 		}
 
 		NSImgui::EndFrame(0, 0, (float)fbw, (float)fbh);
-		NSImgui::EndGUI();
+		NSImgui::FinishGUI();
+
+		// Nothing to show that isn't on screen already
+		if (!NSImgui::FrameChanged() && angle == drawnAngle && !resized) continue;
+		drawnAngle = angle;
+		resized = false;
+
+		// OpenGL rendering
+		glClearColor(0.1f, 0.1f, 0.2f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		NSImgui::RenderGUI();
 
 		glDisable(GL_BLEND);
 		glEnable(GL_DEPTH_TEST);
 
+#ifdef NSIMGUI_GL3
+		triangle.draw(angle);
+#else
 		glMatrixMode(GL_PROJECTION);
 		glLoadIdentity();
 		glOrtho(-1, 1, -1, 1, -1, 1);
@@ -96,10 +185,14 @@ int main() {
 		glColor3f(0, 1, 0); glVertex2f(-0.5f, -0.5f);
 		glColor3f(0, 0, 1); glVertex2f(0.5f, -0.5f);
 		glEnd();
+#endif
 
 		// Swap buffers
 		window.swapBuffers();
 	}
 
+#ifdef NSIMGUI_GL3
+	NSImgui::ShutdownGL3Backend();
+#endif
 	return 0;
 }
\ No newline at end of file
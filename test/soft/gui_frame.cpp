@@ -0,0 +1,149 @@
+/*
+	gui_frame.cpp
+
+	Copyright (C) 2025 Nico Rajala. All rights reserved.
+
+	Headless check of NSImgui: builds a fixed frame without GL, renders it with SoftRenderer
+	and compares draw list counts and pixels. Exits with 1 and says what differed on failure.
+*/
+
+#include "ns_immediate_gui.hpp"
+#include "ns_imgui_soft.hpp"
+
+#include <cstdio>
+
+using namespace NSImgui;
+
+static int failures = 0;
+
+static void Check(bool ok, const char* what) {
+	if (ok) return;
+	std::printf("FAIL: %s\n", what);
+	failures++;
+}
+
+static const int Width = 640, Height = 480;
+static const DrawColor Background = PackColor(0.1f, 0.1f, 0.2f);
+
+static bool checked = false;
+static float value = 25.f;
+static unsigned version = 1;
+
+// The mouse sits outside every window, so nothing is hot and the cached window may replay
+static void Frame(bool cached, int fbWidth = Width) {
+	NewFrame(Width - 10, Height - 10, false, false, false);
+	BeginGUI(fbWidth, Height);
+	if (BeginWindow("Controls", 40, 40, 240, 200, 1.f)) {
+		Button("Apply");
+		Label("The quick brown fox");
+		Checkbox("Enabled", &checked);
+		SliderFloat("Value", &value, 0.f, 100.f);
+		EndWindow();
+	}
+	bool open = cached ? BeginCachedWindow("Log", 320, 40, 280, 300, 1.f, version) : BeginWindow("Log", 320, 40, 280, 300, 1.f);
+	if (open) {
+		for (int i = 0; i < 12; i++) Label("Line of log output");
+		EndWindow();
+	}
+	EndFrame(0, 0, (float)fbWidth, (float)Height);
+	EndGUI();
+}
+
+static char text[32] = "Edit me";
+
+// a lone InputText, with a click at (mx, my) when pressed
+static void InputFrame(int mx, int my, bool pressed) {
+	NewFrame(mx, my, pressed, pressed, false);
+	BeginGUI(Width, Height);
+	if (BeginWindow("Input", 40, 300, 240, 100, 1.f)) {
+		InputText("Name", text, sizeof(text));
+		EndWindow();
+	}
+	EndFrame(0, 0, (float)Width, (float)Height);
+	EndGUI();
+}
+
+// pixels that differ inside the rect, for changes that shouldn't count elsewhere
+static size_t DiffRect(const SoftRenderer& a, const SoftRenderer& b, int x0, int y0, int x1, int y1) {
+	size_t n = 0;
+	for (int y = y0; y < y1; y++)
+		for (int x = x0; x < x1; x++) n += a.Pixel(x, y) != b.Pixel(x, y);
+	return n;
+}
+
+static void Render(SoftRenderer& sr, unsigned threads = 1) {
+	sr.Clear(Background);
+	sr.Render(GetDrawList(), threads);
+}
+
+int main() {
+	SoftRenderer a(Width, Height), b(Width, Height);
+	a.UploadFontAtlas(GetFontAtlas());
+	b.UploadFontAtlas(GetFontAtlas());
+
+	// the first frames settle window placement and retained state
+	Frame(false);
+	Frame(false);
+
+	// --- Draw list ---
+	const DrawList& dl = GetDrawList();
+	size_t vtx = dl.VertexCount(), idx = dl.IndexCount(), cmds = dl.cmds.size();
+	std::printf("draw list: %zu vertices, %zu indices, %zu commands\n", vtx, idx, cmds);
+	Check(vtx == 1000 && idx == 1500 && cmds == 4, "draw list counts of the reference frame changed");
+	Check(idx % 3 == 0, "index count is not a multiple of 3");
+
+	// --- Pixels ---
+	Render(a, 1);
+	Render(b, 4);
+	Check(SoftRenderer::DiffPixels(a, b) == 0, "1 and 4 render threads differ");
+	Check(a.Pixel(10, 10) == Background, "pixel outside the windows is not the background");
+	Check(a.Pixel(150, 200) != Background, "pixel inside a window is the background");
+
+	Frame(false);
+	Render(b);
+	Check(SoftRenderer::DiffPixels(a, b) == 0, "the same frame twice renders differently");
+
+	checked = true;
+	Frame(false);
+	Render(b);
+	Check(SoftRenderer::DiffPixels(a, b) > 0, "toggling the checkbox changed no pixels");
+	checked = false;
+
+	// --- Cached window ---
+	Frame(true);
+	Frame(true);
+	Check(FindWindow("Log")->cache.replayed > 0, "idle cached window was not replayed");
+	Render(b);
+	Check(SoftRenderer::DiffPixels(a, b) == 0, "replayed window differs from the full draw");
+
+	// a window captured past the framebuffer edge is drawn again once the framebuffer grows
+	version++;
+	Frame(true, 400);
+	Frame(true, 400);
+	Frame(true);
+	Render(b);
+	Check(SoftRenderer::DiffPixels(a, b) == 0, "window cut off by a smaller framebuffer was replayed");
+
+	// --- Input focus ---
+	SoftRenderer idle(Width, Height), focused(Width, Height);
+	idle.UploadFontAtlas(GetFontAtlas());
+	focused.UploadFontAtlas(GetFontAtlas());
+	InputFrame(Width - 10, Height - 10, false);
+	InputFrame(Width - 10, Height - 10, false);
+	Render(idle);
+	// the window body, the click also selects the window and that recolors its title bar
+	WindowState* input = FindWindow("Input");
+	int x0 = (int)input->x, y0 = (int)(input->y + TitleBarHeight), x1 = (int)(input->x + input->w), y1 = (int)(input->y + input->h);
+	InputFrame(x0 + 60, y0 + 16, true);
+	InputFrame(Width - 10, Height - 10, false);
+	Render(focused);
+	Check(DiffRect(idle, focused, x0, y0, x1, y1) > 0, "a focused InputText looks like an unfocused one");
+	InputFrame(Width - 10, Height - 10, true);
+	InputFrame(Width - 10, Height - 10, false);
+	Render(focused);
+	Check(DiffRect(idle, focused, x0, y0, x1, y1) == 0, "a press outside didn't unfocus the InputText");
+
+	if (failures) return 1;
+	std::printf("ok\n");
+	return 0;
+}
@@ -0,0 +1,92 @@
+/*
+
+	Copyright (C) Nico Rajala 2025
+
+	nsdu.cpp
+	Command line front end for fs_usage.hpp, a du with a largest files list.
+
+	nsdu [-d depth] [-n largest] [-j threads] [-a] [-h] [-x] [-l] <dir>...
+
+		-d	print subtrees down to depth (default 0, -1 for all)
+		-n	list the n largest files
+		-j	worker threads (default one per core)
+		-a	apparent sizes instead of allocated
+		-h	human readable sizes
+		-x	stay on one filesystem
+		-l	count hardlinks every time they appear
+
+*/
+
+#include "fs_usage.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static int usage() {
+	fprintf(stderr, "usage: nsdu [-d depth] [-n largest] [-j threads] [-a] [-h] [-x] [-l] <dir>...\n");
+	return 2;
+}
+
+static const char* format_size(unsigned long long n, bool human, char* buf, size_t size) {
+	if (!human) {
+		snprintf(buf, size, "%llu", n);
+		return buf;
+	}
+	static const char units[] = "BKMGTPE";
+	double v = (double)n;
+	int u = 0;
+	while (v >= 1024.0 && u < 6) {
+		v /= 1024.0;
+		u++;
+	}
+	if (u == 0) snprintf(buf, size, "%llu", n);
+	else snprintf(buf, size, v < 10.0 ? "%.1f%c" : "%.0f%c", v, units[u]);
+	return buf;
+}
+
+int main(int argc, char** argv) {
+	fs::usage_options opt;
+	bool apparent = false, human = false;
+	std::vector<const char*> dirs;
+
+	for (int i = 1; i < argc; i++) {
+		const char* a = argv[i];
+		if (strcmp(a, "-d") == 0 && i + 1 < argc) opt.depth = atoi(argv[++i]);
+		else if (strcmp(a, "-n") == 0 && i + 1 < argc) opt.largest = strtoul(argv[++i], NULL, 10);
+		else if (strcmp(a, "-j") == 0 && i + 1 < argc) opt.threads = (unsigned)strtoul(argv[++i], NULL, 10);
+		else if (strcmp(a, "-a") == 0) apparent = true;
+		else if (strcmp(a, "-h") == 0) human = true;
+		else if (strcmp(a, "-x") == 0) opt.one_filesystem = true;
+		else if (strcmp(a, "-l") == 0) opt.count_links = true;
+		else if (a[0] == '-' && a[1]) return usage();
+		else dirs.push_back(a);
+	}
+	if (dirs.empty()) dirs.push_back(".");
+
+	int status = 0;
+	char buf[32];
+	for (size_t d = 0; d < dirs.size(); d++) {
+		fs::usage_result r;
+		if (!fs::disk_usage(fs::path(dirs[d]), r, opt)) status = 1;
+		for (size_t i = 0; i < r.errors.size(); i++)
+			fprintf(stderr, "nsdu: %s: %s\n", r.errors[i].path.c_str(), strerror(r.errors[i].error));
+
+		// reverse path order puts every directory after what it contains, like du
+		for (size_t i = r.subtrees.size(); i-- > 0; ) {
+			const fs::usage_subtree& s = r.subtrees[i];
+			printf("%s\t%s\n", format_size(apparent ? s.totals.bytes : s.totals.allocated, human, buf, sizeof(buf)), s.path.c_str());
+		}
+		if (r.subtrees.empty()) printf("%s\t%s\n", format_size(apparent ? r.total.bytes : r.total.allocated, human, buf, sizeof(buf)), dirs[d]);
+
+		printf("%llu files, %llu directories, %llu other", r.total.files, r.total.directories, r.total.others);
+		if (r.hardlinks_skipped) printf(", %llu hardlinks counted once", r.hardlinks_skipped);
+		printf("\n");
+
+		for (size_t i = 0; i < r.largest.size(); i++) {
+			const fs::usage_file& f = r.largest[i];
+			printf("%s\t%s\n", format_size(apparent ? f.bytes : f.allocated, human, buf, sizeof(buf)), f.path.c_str());
+		}
+	}
+	return status;
+}
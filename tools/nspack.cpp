@@ -0,0 +1,104 @@
+/*
+
+	Copyright (C) Nico Rajala 2025
+
+	nspack.cpp
+	Command line front end for fs_pack.hpp.
+
+	nspack pack <dir> <archive> [-c] [-a alignment]
+	nspack unpack <archive> <dir>
+	nspack list <archive>
+	nspack verify <archive>
+
+*/
+
+#include "fs_pack.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static int usage() {
+	fprintf(stderr,
+		"usage: nspack pack <dir> <archive> [-c] [-a alignment]\n"
+		"       nspack unpack <archive> <dir>\n"
+		"       nspack list <archive>\n"
+		"       nspack verify <archive>\n");
+	return 2;
+}
+
+static bool open_archive(fs::pack_reader& pak, const char* file) {
+	if (pak.open(fs::path(file))) return true;
+	fprintf(stderr, "nspack: %s is not a readable pack\n", file);
+	return false;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3) return usage();
+	const char* cmd = argv[1];
+
+	if (strcmp(cmd, "pack") == 0) {
+		if (argc < 4) return usage();
+		int flags = fs::pack_none;
+		unsigned long alignment = 64;
+		for (int i = 4; i < argc; i++) {
+			if (strcmp(argv[i], "-c") == 0) flags |= fs::pack_compress;
+			else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) alignment = strtoul(argv[++i], NULL, 10);
+			else return usage();
+		}
+		fs::pack_writer w;
+		if (!w.add_directory(fs::path(argv[2]))) {
+			fprintf(stderr, "nspack: can't read %s\n", argv[2]);
+			return 1;
+		}
+		if (!w.write(fs::path(argv[3]), flags, (uint32_t)alignment)) {
+			fprintf(stderr, "nspack: writing %s failed\n", argv[3]);
+			return 1;
+		}
+		printf("%zu files\n", w.size());
+		return 0;
+	}
+
+	if (strcmp(cmd, "unpack") == 0) {
+		if (argc < 4) return usage();
+		fs::pack_reader pak;
+		if (!open_archive(pak, argv[2])) return 1;
+		if (!fs::unpack(pak, fs::path(argv[3]))) {
+			fprintf(stderr, "nspack: extracting to %s failed\n", argv[3]);
+			return 1;
+		}
+		return 0;
+	}
+
+	if (strcmp(cmd, "list") == 0) {
+		fs::pack_reader pak;
+		if (!open_archive(pak, argv[2])) return 1;
+		unsigned long long total = 0, stored = 0;
+		for (size_t i = 0; i < pak.size(); i++) {
+			const fs::pack_entry& e = pak.entry(i);
+			fs::path_view name = pak.name(i);
+			printf("%12llu %12llu %s %.*s\n", (unsigned long long)e.size, (unsigned long long)e.stored_size,
+				pak.is_compressed(i) ? "lz4" : "   ", (int)name.size(), name.data());
+			total += e.size;
+			stored += e.stored_size;
+		}
+		printf("%zu files, %llu bytes, %llu stored\n", pak.size(), total, stored);
+		return 0;
+	}
+
+	if (strcmp(cmd, "verify") == 0) {
+		fs::pack_reader pak;
+		if (!open_archive(pak, argv[2])) return 1;
+		size_t bad = 0;
+		for (size_t i = 0; i < pak.size(); i++) {
+			if (pak.verify(i)) continue;
+			fs::path_view name = pak.name(i);
+			printf("bad: %.*s\n", (int)name.size(), name.data());
+			bad++;
+		}
+		printf("%zu files, %zu bad\n", pak.size(), bad);
+		return bad ? 1 : 0;
+	}
+
+	return usage();
+}
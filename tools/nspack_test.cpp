@@ -0,0 +1,111 @@
+/*
+
+	Copyright (C) Nico Rajala 2025
+
+	nspack_test.cpp
+	Checks that pack_reader refuses truncated and corrupt archives instead
+	of reading outside the mapping. Writes a small archive into the current
+	directory, then opens cut off and patched copies of it.
+
+	Exits with 1 and says what got through on failure.
+
+*/
+
+#include "fs_pack.hpp"
+
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+	if (ok) return;
+	printf("FAIL: %s\n", what);
+	failures++;
+}
+
+static bool load(const char* file, std::vector<unsigned char>& out) {
+	FILE* f = fopen(file, "rb");
+	if (!f) return false;
+	unsigned char buf[4096];
+	size_t n;
+	out.clear();
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+	fclose(f);
+	return true;
+}
+
+static bool save(const char* file, const unsigned char* data, size_t n) {
+	FILE* f = fopen(file, "wb");
+	if (!f) return false;
+	bool ok = fwrite(data, 1, n, f) == n;
+	return fclose(f) == 0 && ok;
+}
+
+// opens data as an archive and reads every entry, which must not crash either way
+static bool opens(const unsigned char* data, size_t n) {
+	const char* file = "nspack_test_bad.pak";
+	if (!save(file, data, n)) return false;
+	fs::pack_reader r(file);
+	bool ok = r.is_open();
+	std::vector<unsigned char> out;
+	for (size_t i = 0; ok && i < r.size(); i++) r.read(i, out);
+	r.close();
+	::remove(file);
+	return ok;
+}
+
+// a copy of good with a header field overwritten
+static bool opens_patched(const std::vector<unsigned char>& good, size_t field, uint64_t value, size_t width) {
+	std::vector<unsigned char> bad(good);
+	if (width == 8) memcpy(&bad[field], &value, 8);
+	else { uint32_t v = (uint32_t)value; memcpy(&bad[field], &v, 4); }
+	return opens(&bad[0], bad.size());
+}
+
+int main() {
+	const char* file = "nspack_test.pak";
+	std::string big(5000, 'x');
+	fs::pack_writer w;
+	w.add_data("a.txt", "hello", 5);
+	w.add_data("dir/b.bin", big.data(), big.size());
+	w.add_data("dir/sub/c", "", 0);
+	if (!w.write(file, fs::pack_compress)) {
+		printf("FAIL: writing %s\n", file);
+		return 1;
+	}
+
+	std::vector<unsigned char> good;
+	check(load(file, good) && good.size() >= 256, "reading the archive back");
+	if (failures) return 1;
+	check(opens(&good[0], good.size()), "the intact archive doesn't open");
+
+	// every cut short enough to lose part of a table or an entry's data
+	size_t truncated = 0;
+	for (size_t n = 0; n < good.size(); n++)
+		if (opens(&good[0], n)) truncated++;
+	check(truncated == 0, "a truncated archive opened");
+
+	// offsets that wrap around when the table size is added
+	const uint64_t wrap = 0xFFFFFFFFFFFFFFF8ULL;
+	check(!opens_patched(good, offsetof(fs::pack_header, toc_offset), wrap, 8), "toc_offset near 2^64 opened");
+	check(!opens_patched(good, offsetof(fs::pack_header, slots_offset), wrap, 8), "slots_offset near 2^64 opened");
+	check(!opens_patched(good, offsetof(fs::pack_header, names_offset), wrap, 8), "names_offset near 2^64 opened");
+	check(!opens_patched(good, offsetof(fs::pack_header, names_size), wrap, 8), "names_size near 2^64 opened");
+	check(!opens_patched(good, offsetof(fs::pack_header, count), 0xFFFFFFFF, 4), "count of 2^32-1 opened");
+	check(!opens_patched(good, offsetof(fs::pack_header, slot_count), 0x80000000, 4), "slot_count of 2^31 opened");
+
+	// the reported case: a 256 byte file with the toc offset near 2^64
+	std::vector<unsigned char> small(good.begin(), good.begin() + 256);
+	uint64_t toc = wrap;
+	memcpy(&small[offsetof(fs::pack_header, toc_offset)], &toc, 8);
+	check(!opens(&small[0], small.size()), "256 byte archive with a wrapping toc_offset opened");
+
+	::remove(file);
+	if (failures) return 1;
+	printf("ok\n");
+	return 0;
+}
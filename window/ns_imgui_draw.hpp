@@ -0,0 +1,354 @@
+/*
+	ns_imgui_draw.hpp
+
+	Copyright (C) 2025 Nico Rajala. All rights reserved.
+
+	Per-frame draw list for NSImgui.
+
+	Use at your own risk. No warranties are provided.
+
+	---
+
+	Widgets don't talk to the graphics API directly. Every rectangle, outline and glyph is
+	appended as two triangles to one vertex buffer and one index buffer, and consecutive
+	primitives that share a clip rect and texture are merged into a single DrawCmd. A backend
+	then submits the whole frame with one draw call per command, usually a handful per frame.
+
+	Text is drawn from a FontAtlas, one textured quad per glyph. The atlas also holds a white
+	block that rectangles sample, so text and rectangles share a texture and a draw command.
+
+	This header has no platform or GL dependencies, so draw lists can be built and inspected
+	on machines without a display.
+*/
+
+#ifndef NS_IMGUI_DRAW_HPP
+#define NS_IMGUI_DRAW_HPP
+
+#include <vector>
+#include <cstring>
+
+namespace NSImgui {
+
+	// --- Draw data ---
+
+	// Colors are stored as RGBA bytes in memory order, the layout GL_UNSIGNED_BYTE color arrays expect
+	typedef unsigned int DrawColor;
+	typedef unsigned int DrawIdx;
+
+	inline DrawColor PackColor(float r, float g, float b, float a = 1.0f) {
+		auto to8 = [](float v) -> unsigned int {
+			if (v <= 0.0f) return 0;
+			if (v >= 1.0f) return 255;
+			return (unsigned int)(v * 255.0f + 0.5f);
+		};
+		unsigned char bytes[4] = { (unsigned char)to8(r), (unsigned char)to8(g), (unsigned char)to8(b), (unsigned char)to8(a) };
+		DrawColor c;
+		std::memcpy(&c, bytes, 4);
+		return c;
+	}
+
+	struct DrawVert {
+		float x, y;
+		float u, v;
+		DrawColor col;
+	};
+
+	struct ClipRect {
+		float x0, y0, x1, y1;
+	};
+
+	// One draw call: elemCount indices starting at idxOffset, drawn with texture (0 = untextured)
+	// and scissored to clip
+	struct DrawCmd {
+		ClipRect clip;
+		unsigned int texture;
+		unsigned int idxOffset;
+		unsigned int elemCount;
+	};
+
+	// --- Font atlas ---
+
+	// The 8x8 font baked into one RGBA texture, white with the glyph coverage in alpha, so the
+	// vertex color tints it. A solid white block in the corner lets untextured rectangles use the
+	// same texture, which keeps text and rectangles in the same draw command.
+	struct FontAtlas {
+		static const int GlyphSize = 8;
+		static const int Columns = 16;
+		static const int FirstChar = 32, CharCount = 96;
+		static const int Width = 128, Height = 64;		// 16x6 glyphs, white block in the free bottom row
+
+		std::vector<unsigned char> pixels;	// Width * Height * 4, RGBA
+		unsigned int texture = 0;			// set by whichever backend uploaded the pixels
+		float whiteU = 0, whiteV = 0;		// center of the white block
+		float glyphU[CharCount], glyphV[CharCount];	// top left of each glyph
+		bool glyphEmpty[CharCount];			// nothing to draw (space, del)
+
+		// bitmap[i][row], bit n is column n, as in font8x8_basic
+		void Build(const unsigned char (*bitmap)[8]) {
+			pixels.assign(Width * Height * 4, 0);
+			for (int i = 0; i < CharCount; i++) {
+				int gx = (i % Columns) * GlyphSize, gy = (i / Columns) * GlyphSize;
+				glyphU[i] = (float)gx / Width;
+				glyphV[i] = (float)gy / Height;
+				glyphEmpty[i] = true;
+				for (int row = 0; row < 8; row++) {
+					for (int col = 0; col < 8; col++) {
+						if (!(bitmap[i][row] & (1 << col))) continue;
+						unsigned char* p = &pixels[((gy + row) * Width + gx + col) * 4];
+						p[0] = p[1] = p[2] = p[3] = 255;
+						glyphEmpty[i] = false;
+					}
+				}
+			}
+			// 4x4 white block, sampled at its center so filtering never reaches a glyph
+			int wx = Width - 4, wy = Height - 4;
+			for (int y = wy; y < wy + 4; y++)
+				for (int x = wx; x < wx + 4; x++)
+					std::memset(&pixels[(y * Width + x) * 4], 255, 4);
+			whiteU = (wx + 2.0f) / Width;
+			whiteV = (wy + 2.0f) / Height;
+		}
+	};
+
+	// Draw output copied out of a DrawList, indices relative to the first vertex and command
+	// offsets relative to the first index
+	struct DrawCapture {
+		std::vector<DrawVert> vtx;
+		std::vector<DrawIdx> idx;
+		std::vector<DrawCmd> cmds;
+	};
+
+	class DrawList {
+	public:
+		std::vector<DrawVert> vtx;
+		std::vector<DrawIdx> idx;
+		std::vector<DrawCmd> cmds;
+
+		// Keeps the allocations, so after the first few frames building a frame doesn't allocate
+		void Clear() {
+			vtx.clear();
+			idx.clear();
+			cmds.clear();
+			clipStack.clear();
+			texture = 0;
+			SetFont(nullptr);
+		}
+
+		// --- State ---
+
+		void PushClipRect(float x, float y, float w, float h, bool intersectWithCurrent = true) {
+			ClipRect r = { x, y, x + w, y + h };
+			if (intersectWithCurrent && !clipStack.empty()) {
+				const ClipRect& cur = clipStack.back();
+				if (r.x0 < cur.x0) r.x0 = cur.x0;
+				if (r.y0 < cur.y0) r.y0 = cur.y0;
+				if (r.x1 > cur.x1) r.x1 = cur.x1;
+				if (r.y1 > cur.y1) r.y1 = cur.y1;
+				if (r.x1 < r.x0) r.x1 = r.x0;
+				if (r.y1 < r.y0) r.y1 = r.y0;
+			}
+			clipStack.push_back(r);
+		}
+
+		void PopClipRect() {
+			if (!clipStack.empty()) clipStack.pop_back();
+		}
+
+		ClipRect CurrentClipRect() const {
+			if (clipStack.empty()) {
+				ClipRect none = { -1e9f, -1e9f, 1e9f, 1e9f };
+				return none;
+			}
+			return clipStack.back();
+		}
+
+		void SetTexture(unsigned int tex) { texture = tex; }
+		unsigned int CurrentTexture() const { return texture; }
+
+		// Text and rectangles sample this atlas, bind its texture with SetTexture
+		void SetFont(const FontAtlas* atlas) {
+			font = atlas;
+			whiteU = atlas ? atlas->whiteU : 0;
+			whiteV = atlas ? atlas->whiteV : 0;
+		}
+		const FontAtlas* CurrentFont() const { return font; }
+
+		// --- Primitives ---
+
+		void AddRectFilled(float x, float y, float w, float h, DrawColor col) {
+			AddQuad(x, y, x + w, y + h, whiteU, whiteV, whiteU, whiteV, col);
+		}
+
+		// Outline drawn as four thin quads, so it batches with everything else (no GL_LINE_LOOP)
+		void AddRect(float x, float y, float w, float h, DrawColor col, float thickness = 1.0f) {
+			AddRectFilled(x, y, w, thickness, col);
+			AddRectFilled(x, y + h - thickness, w, thickness, col);
+			AddRectFilled(x, y + thickness, thickness, h - 2 * thickness, col);
+			AddRectFilled(x + w - thickness, y + thickness, thickness, h - 2 * thickness, col);
+		}
+
+		// Textured quad, (u0, v0) maps to the top left corner
+		void AddImage(float x, float y, float w, float h, float u0, float v0, float u1, float v1, DrawColor col) {
+			AddQuad(x, y, x + w, y + h, u0, v0, u1, v1, col);
+		}
+
+		void AddQuad(float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, DrawColor col) {
+			DrawCmd& cmd = CurrentCmd();
+			DrawIdx base = (DrawIdx)vtx.size();
+			DrawVert q[4] = {
+				{ x0, y0, u0, v0, col },
+				{ x1, y0, u1, v0, col },
+				{ x1, y1, u1, v1, col },
+				{ x0, y1, u0, v1, col }
+			};
+			vtx.insert(vtx.end(), q, q + 4);
+			DrawIdx i[6] = { base, base + 1, base + 2, base, base + 2, base + 3 };
+			idx.insert(idx.end(), i, i + 6);
+			cmd.elemCount += 6;
+		}
+
+		// One textured quad per glyph, scale is an integer pixel multiplier (2 for 200% DPI)
+		void AddText(float x, float y, const char* text, DrawColor col, int scale = 1) {
+			if (!font) return;
+			float size = (float)(FontAtlas::GlyphSize * scale);
+			const float du = (float)FontAtlas::GlyphSize / FontAtlas::Width, dv = (float)FontAtlas::GlyphSize / FontAtlas::Height;
+			for (const char* c = text; *c; ++c, x += size) {
+				int i = (unsigned char)*c - FontAtlas::FirstChar;
+				if (i < 0 || i >= FontAtlas::CharCount || font->glyphEmpty[i]) continue;
+				AddQuad(x, y, x + size, y + size, font->glyphU[i], font->glyphV[i], font->glyphU[i] + du, font->glyphV[i] + dv, col);
+			}
+		}
+
+		// Appends prebuilt vertices (quads, 4 per quad, positions relative to 0,0) moved to x, y
+		// and recolored. Used to replay cached text runs.
+		void AddQuads(const DrawVert* quads, size_t vertexCount, float x, float y, DrawColor col) {
+			if (!vertexCount) return;
+			DrawCmd& cmd = CurrentCmd();
+			size_t vn = vtx.size(), in = idx.size();
+			vtx.resize(vn + vertexCount);
+			idx.resize(in + vertexCount / 4 * 6);
+			DrawVert* v = &vtx[vn];
+			for (size_t k = 0; k < vertexCount; k++) {
+				v[k] = quads[k];
+				v[k].x += x;
+				v[k].y += y;
+				v[k].col = col;
+			}
+			DrawIdx* i = &idx[in];
+			for (DrawIdx base = (DrawIdx)vn, end = (DrawIdx)(vn + vertexCount); base < end; base += 4, i += 6) {
+				i[0] = base; i[1] = base + 1; i[2] = base + 2;
+				i[3] = base; i[4] = base + 2; i[5] = base + 3;
+			}
+			cmd.elemCount += (unsigned int)(vertexCount / 4 * 6);
+		}
+
+		// --- Capture and replay ---
+
+		// Hash of everything appended since vtxStart, idxStart: vertices, indices relative to
+		// vtxStart, and the clip rect and texture of each command they were drawn with.
+		unsigned long long HashSince(size_t vtxStart, size_t idxStart) const {
+			// FNV style, but over 8 byte words in four independent lanes, the multiplies don't
+			// wait on each other. This runs over the whole list every frame.
+			unsigned long long lane[4] = { 14695981039346656037ull, 1469598103934665603ull, 4695981039346656037ull, 695981039346656037ull };
+			const unsigned long long prime = 1099511628211ull;
+			auto mix = [&lane, prime](const void* data, size_t bytes) {
+				const unsigned char* p = (const unsigned char*)data;
+				unsigned long long w[4];
+				for (; bytes >= 32; bytes -= 32, p += 32) {
+					std::memcpy(w, p, 32);
+					lane[0] = (lane[0] ^ w[0]) * prime;
+					lane[1] = (lane[1] ^ w[1]) * prime;
+					lane[2] = (lane[2] ^ w[2]) * prime;
+					lane[3] = (lane[3] ^ w[3]) * prime;
+				}
+				for (; bytes; bytes--, p++) lane[0] = (lane[0] ^ *p) * prime;
+			};
+			if (vtx.size() > vtxStart) mix(&vtx[vtxStart], (vtx.size() - vtxStart) * sizeof(DrawVert));
+			if (vtxStart == 0) {
+				if (idx.size() > idxStart) mix(&idx[idxStart], (idx.size() - idxStart) * sizeof(DrawIdx));
+			}
+			else {
+				for (size_t i = idxStart; i < idx.size(); i++) {
+					DrawIdx rel = idx[i] - (DrawIdx)vtxStart;
+					mix(&rel, sizeof(rel));
+				}
+			}
+			for (const DrawCmd& cmd : cmds) {
+				if (cmd.idxOffset + cmd.elemCount <= idxStart || cmd.elemCount == 0) continue;
+				mix(&cmd.clip, sizeof(cmd.clip));
+				mix(&cmd.texture, sizeof(cmd.texture));
+			}
+			return ((lane[0] * 31 ^ lane[1]) * 31 ^ lane[2]) * 31 ^ lane[3];
+		}
+
+		// Copies everything appended since vtxStart, idxStart, so Replay can put it back in a later
+		// frame. Commands are cut at idxStart, the first primitives may have merged into an
+		// earlier command.
+		void Capture(size_t vtxStart, size_t idxStart, DrawCapture& out) const {
+			out.vtx.assign(vtx.begin() + vtxStart, vtx.end());
+			out.idx.resize(idx.size() - idxStart);
+			for (size_t i = idxStart; i < idx.size(); i++) out.idx[i - idxStart] = idx[i] - (DrawIdx)vtxStart;
+			out.cmds.clear();
+			for (const DrawCmd& cmd : cmds) {
+				size_t begin = cmd.idxOffset, end = cmd.idxOffset + cmd.elemCount;
+				if (end <= idxStart) continue;
+				if (begin < idxStart) begin = idxStart;
+				DrawCmd c = { cmd.clip, cmd.texture, (unsigned int)(begin - idxStart), (unsigned int)(end - begin) };
+				out.cmds.push_back(c);
+			}
+		}
+
+		void Replay(const DrawCapture& c) {
+			DrawIdx base = (DrawIdx)vtx.size();
+			vtx.insert(vtx.end(), c.vtx.begin(), c.vtx.end());
+			unsigned int savedTexture = texture;
+			for (const DrawCmd& seg : c.cmds) {
+				clipStack.push_back(seg.clip);
+				texture = seg.texture;
+				DrawCmd& cmd = CurrentCmd();
+				size_t in = idx.size();
+				idx.resize(in + seg.elemCount);
+				for (unsigned int k = 0; k < seg.elemCount; k++) idx[in + k] = c.idx[seg.idxOffset + k] + base;
+				cmd.elemCount += seg.elemCount;
+				clipStack.pop_back();
+			}
+			texture = savedTexture;
+		}
+
+		// --- Stats ---
+
+		size_t VertexCount() const { return vtx.size(); }
+		size_t IndexCount() const { return idx.size(); }
+		size_t CommandCount() const { return cmds.size(); }
+
+	private:
+		std::vector<ClipRect> clipStack;
+		unsigned int texture = 0;
+		const FontAtlas* font = nullptr;
+		float whiteU = 0, whiteV = 0;
+
+		static bool SameClip(const ClipRect& a, const ClipRect& b) {
+			return a.x0 == b.x0 && a.y0 == b.y0 && a.x1 == b.x1 && a.y1 == b.y1;
+		}
+
+		// The command the next primitive goes into, a new one only when the clip rect or texture changed
+		DrawCmd& CurrentCmd() {
+			ClipRect clip = CurrentClipRect();
+			if (!cmds.empty()) {
+				DrawCmd& last = cmds.back();
+				if (last.texture == texture && SameClip(last.clip, clip)) return last;
+				if (last.elemCount == 0) {
+					last.clip = clip;
+					last.texture = texture;
+					return last;
+				}
+			}
+			DrawCmd cmd = { clip, texture, (unsigned int)idx.size(), 0 };
+			cmds.push_back(cmd);
+			return cmds.back();
+		}
+	};
+
+}
+
+#endif
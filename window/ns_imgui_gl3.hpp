@@ -0,0 +1,517 @@
+/*
+	ns_imgui_gl3.hpp
+
+	Copyright (C) 2025 Nico Rajala. All rights reserved.
+
+	OpenGL 3.3 core profile backend for NSImgui draw lists.
+
+	Use at your own risk. No warranties are provided.
+
+	---
+
+	Draws a DrawList with one shader program, one vertex array object and one streaming vertex
+	and index buffer, scissoring each DrawCmd to its clip rect. Works in core profile contexts,
+	where the fixed function backend in ns_immediate_gui.hpp can't.
+
+	Vertex data is streamed one of two ways:
+		- persistent mapping (GL 4.4 or ARB_buffer_storage): the buffers are split into three
+		  segments that are written in turn, each guarded by a fence, so the CPU never waits on
+		  a frame the GPU is still reading unless it gets three frames ahead
+		- orphaning (plain 3.3): glBufferData(NULL) then glBufferSubData every frame
+
+	Only GL 1.1 is declared by gl.h on every platform, so the newer entry points are loaded at
+	init. On Windows wglGetProcAddress is used by default, elsewhere pass your platform's
+	loader (eglGetProcAddress, glXGetProcAddress, SDL_GL_GetProcAddress...).
+
+	Usage:
+		#define NSIMGUI_GL3
+		#include "ns_immediate_gui.hpp"
+		...create a 3.3 core context, make it current...
+		NSImgui::InitGL3Backend();		// or InitGL3Backend(loader)
+		...frames: BeginGUI / widgets / EndGUI, EndGUI renders through this backend...
+		NSImgui::ShutdownGL3Backend();
+
+	The backend can also be driven by hand with RenderDrawListGL3(GetDrawList(), w, h).
+*/
+
+#ifndef NS_IMGUI_GL3_HPP
+#define NS_IMGUI_GL3_HPP
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+
+#include "ns_imgui_draw.hpp"
+
+#if defined(_WIN32)
+#define NSIMGUI_GLAPI __stdcall
+#else
+#define NSIMGUI_GLAPI
+#endif
+
+// Enums past GL 1.1, guarded in case glext.h or a loader already defined them
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_ARRAY_BUFFER_BINDING 0x8894
+#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_VERTEX_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_INFO_LOG_LENGTH 0x8B84
+#define GL_CURRENT_PROGRAM 0x8B8D
+#endif
+#ifndef GL_TEXTURE0
+#define GL_TEXTURE0 0x84C0
+#define GL_ACTIVE_TEXTURE 0x84E0
+#endif
+#ifndef GL_BLEND_DST_RGB
+#define GL_BLEND_DST_RGB 0x80C8
+#define GL_BLEND_SRC_RGB 0x80C9
+#endif
+#ifndef GL_VERTEX_ARRAY_BINDING
+#define GL_VERTEX_ARRAY_BINDING 0x85B5
+#endif
+#ifndef GL_MAJOR_VERSION
+#define GL_MAJOR_VERSION 0x821B
+#define GL_MINOR_VERSION 0x821C
+#define GL_NUM_EXTENSIONS 0x821D
+#endif
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT 0x0002
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_WAIT_FAILED 0x911D
+#endif
+
+namespace NSImgui {
+
+	typedef void* (*GL3LoadProc)(const char* name);
+
+	// --- GL 3.3 entry points ---
+
+	struct GL3Functions {
+		typedef struct GL3Sync_* Sync;
+
+		GLuint(NSIMGUI_GLAPI* CreateShader)(GLenum type) = nullptr;
+		void (NSIMGUI_GLAPI* ShaderSource)(GLuint shader, GLsizei count, const char* const* src, const GLint* len) = nullptr;
+		void (NSIMGUI_GLAPI* CompileShader)(GLuint shader) = nullptr;
+		void (NSIMGUI_GLAPI* GetShaderiv)(GLuint shader, GLenum pname, GLint* v) = nullptr;
+		void (NSIMGUI_GLAPI* GetShaderInfoLog)(GLuint shader, GLsizei size, GLsizei* len, char* log) = nullptr;
+		void (NSIMGUI_GLAPI* DeleteShader)(GLuint shader) = nullptr;
+		GLuint(NSIMGUI_GLAPI* CreateProgram)() = nullptr;
+		void (NSIMGUI_GLAPI* AttachShader)(GLuint program, GLuint shader) = nullptr;
+		void (NSIMGUI_GLAPI* LinkProgram)(GLuint program) = nullptr;
+		void (NSIMGUI_GLAPI* GetProgramiv)(GLuint program, GLenum pname, GLint* v) = nullptr;
+		void (NSIMGUI_GLAPI* GetProgramInfoLog)(GLuint program, GLsizei size, GLsizei* len, char* log) = nullptr;
+		void (NSIMGUI_GLAPI* DeleteProgram)(GLuint program) = nullptr;
+		void (NSIMGUI_GLAPI* UseProgram)(GLuint program) = nullptr;
+		GLint(NSIMGUI_GLAPI* GetUniformLocation)(GLuint program, const char* name) = nullptr;
+		void (NSIMGUI_GLAPI* Uniform1i)(GLint loc, GLint v) = nullptr;
+		void (NSIMGUI_GLAPI* Uniform1f)(GLint loc, GLfloat v) = nullptr;
+		void (NSIMGUI_GLAPI* UniformMatrix4fv)(GLint loc, GLsizei count, GLboolean transpose, const GLfloat* v) = nullptr;
+		void (NSIMGUI_GLAPI* GenVertexArrays)(GLsizei n, GLuint* arrays) = nullptr;
+		void (NSIMGUI_GLAPI* DeleteVertexArrays)(GLsizei n, const GLuint* arrays) = nullptr;
+		void (NSIMGUI_GLAPI* BindVertexArray)(GLuint array) = nullptr;
+		void (NSIMGUI_GLAPI* EnableVertexAttribArray)(GLuint index) = nullptr;
+		void (NSIMGUI_GLAPI* VertexAttribPointer)(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* ptr) = nullptr;
+		void (NSIMGUI_GLAPI* GenBuffers)(GLsizei n, GLuint* buffers) = nullptr;
+		void (NSIMGUI_GLAPI* DeleteBuffers)(GLsizei n, const GLuint* buffers) = nullptr;
+		void (NSIMGUI_GLAPI* BindBuffer)(GLenum target, GLuint buffer) = nullptr;
+		void (NSIMGUI_GLAPI* BufferData)(GLenum target, std::ptrdiff_t size, const void* data, GLenum usage) = nullptr;
+		void (NSIMGUI_GLAPI* BufferSubData)(GLenum target, std::ptrdiff_t offset, std::ptrdiff_t size, const void* data) = nullptr;
+		void (NSIMGUI_GLAPI* ActiveTexture)(GLenum texture) = nullptr;
+		void (NSIMGUI_GLAPI* DrawElementsBaseVertex)(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint baseVertex) = nullptr;
+		const GLubyte* (NSIMGUI_GLAPI* GetStringi)(GLenum name, GLuint index) = nullptr;
+		// persistent mapping, optional
+		void (NSIMGUI_GLAPI* BufferStorage)(GLenum target, std::ptrdiff_t size, const void* data, GLbitfield flags) = nullptr;
+		void* (NSIMGUI_GLAPI* MapBufferRange)(GLenum target, std::ptrdiff_t offset, std::ptrdiff_t length, GLbitfield access) = nullptr;
+		GLboolean(NSIMGUI_GLAPI* UnmapBuffer)(GLenum target) = nullptr;
+		Sync(NSIMGUI_GLAPI* FenceSync)(GLenum condition, GLbitfield flags) = nullptr;
+		GLenum(NSIMGUI_GLAPI* ClientWaitSync)(Sync sync, GLbitfield flags, unsigned long long timeout) = nullptr;
+		void (NSIMGUI_GLAPI* DeleteSync)(Sync sync) = nullptr;
+
+		// false if anything GL 3.3 guarantees is missing
+		bool Load(GL3LoadProc load) {
+			bool ok = true;
+			auto get = [&](void* fn, const char* name, bool required) {
+				void* p = load(name);
+				std::memcpy(fn, &p, sizeof(p));
+				if (!p && required) ok = false;
+			};
+			get(&CreateShader, "glCreateShader", true);
+			get(&ShaderSource, "glShaderSource", true);
+			get(&CompileShader, "glCompileShader", true);
+			get(&GetShaderiv, "glGetShaderiv", true);
+			get(&GetShaderInfoLog, "glGetShaderInfoLog", true);
+			get(&DeleteShader, "glDeleteShader", true);
+			get(&CreateProgram, "glCreateProgram", true);
+			get(&AttachShader, "glAttachShader", true);
+			get(&LinkProgram, "glLinkProgram", true);
+			get(&GetProgramiv, "glGetProgramiv", true);
+			get(&GetProgramInfoLog, "glGetProgramInfoLog", true);
+			get(&DeleteProgram, "glDeleteProgram", true);
+			get(&UseProgram, "glUseProgram", true);
+			get(&GetUniformLocation, "glGetUniformLocation", true);
+			get(&Uniform1i, "glUniform1i", true);
+			get(&Uniform1f, "glUniform1f", true);
+			get(&UniformMatrix4fv, "glUniformMatrix4fv", true);
+			get(&GenVertexArrays, "glGenVertexArrays", true);
+			get(&DeleteVertexArrays, "glDeleteVertexArrays", true);
+			get(&BindVertexArray, "glBindVertexArray", true);
+			get(&EnableVertexAttribArray, "glEnableVertexAttribArray", true);
+			get(&VertexAttribPointer, "glVertexAttribPointer", true);
+			get(&GenBuffers, "glGenBuffers", true);
+			get(&DeleteBuffers, "glDeleteBuffers", true);
+			get(&BindBuffer, "glBindBuffer", true);
+			get(&BufferData, "glBufferData", true);
+			get(&BufferSubData, "glBufferSubData", true);
+			get(&ActiveTexture, "glActiveTexture", true);
+			get(&DrawElementsBaseVertex, "glDrawElementsBaseVertex", true);
+			get(&GetStringi, "glGetStringi", true);
+			get(&MapBufferRange, "glMapBufferRange", true);
+			get(&UnmapBuffer, "glUnmapBuffer", true);
+			get(&FenceSync, "glFenceSync", true);
+			get(&ClientWaitSync, "glClientWaitSync", true);
+			get(&DeleteSync, "glDeleteSync", true);
+			get(&BufferStorage, "glBufferStorage", false);
+			return ok;
+		}
+	};
+
+	// --- Backend state ---
+
+	struct GL3Backend {
+		static const int Segments = 3;		// frames in flight with persistent mapping
+
+		GL3Functions gl;
+		bool initialized = false;
+		bool persistent = false;
+		GLuint program = 0, vao = 0, vbo = 0, ebo = 0, whiteTexture = 0;
+		GLint projLoc = -1, texLoc = -1;
+
+		// capacity of one segment (persistent) or of the buffers (orphaning), in elements
+		size_t vtxCapacity = 0, idxCapacity = 0;
+		DrawVert* vtxMapped = nullptr;
+		DrawIdx* idxMapped = nullptr;
+		GL3Functions::Sync fences[Segments] = {};
+		int segment = 0;
+	};
+
+	inline GL3Backend& GetGL3Backend() {
+		static GL3Backend backend;
+		return backend;
+	}
+
+#if defined(_WIN32)
+	// wglGetProcAddress returns null (or 1, 2, 3, -1) for GL 1.1 functions, those come from opengl32
+	inline void* DefaultGL3Loader(const char* name) {
+		PROC p = wglGetProcAddress(name);
+		if (p == nullptr || p == (PROC)1 || p == (PROC)2 || p == (PROC)3 || p == (PROC)-1)
+			p = GetProcAddress(GetModuleHandleA("opengl32.dll"), name);
+		return (void*)p;
+	}
+#endif
+
+	// Compiles and links a vertex/fragment pair, 0 on failure (log printed to stderr)
+	inline GLuint CompileProgramGL3(const char* vertexSrc, const char* fragmentSrc) {
+		GL3Functions& gl = GetGL3Backend().gl;
+		char log[1024];
+		GLuint shaders[2] = { gl.CreateShader(GL_VERTEX_SHADER), gl.CreateShader(GL_FRAGMENT_SHADER) };
+		const char* src[2] = { vertexSrc, fragmentSrc };
+		GLint ok = 0;
+		for (int i = 0; i < 2; i++) {
+			gl.ShaderSource(shaders[i], 1, &src[i], nullptr);
+			gl.CompileShader(shaders[i]);
+			gl.GetShaderiv(shaders[i], GL_COMPILE_STATUS, &ok);
+			if (!ok) {
+				gl.GetShaderInfoLog(shaders[i], sizeof(log), nullptr, log);
+				fprintf(stderr, "NSImgui: %s shader: %s\n", i ? "fragment" : "vertex", log);
+				gl.DeleteShader(shaders[0]);
+				gl.DeleteShader(shaders[1]);
+				return 0;
+			}
+		}
+		GLuint program = gl.CreateProgram();
+		gl.AttachShader(program, shaders[0]);
+		gl.AttachShader(program, shaders[1]);
+		gl.LinkProgram(program);
+		gl.DeleteShader(shaders[0]);
+		gl.DeleteShader(shaders[1]);
+		gl.GetProgramiv(program, GL_LINK_STATUS, &ok);
+		if (!ok) {
+			gl.GetProgramInfoLog(program, sizeof(log), nullptr, log);
+			fprintf(stderr, "NSImgui: link: %s\n", log);
+			gl.DeleteProgram(program);
+			return 0;
+		}
+		return program;
+	}
+
+	inline bool HasBufferStorageGL3() {
+		GL3Backend& b = GetGL3Backend();
+		if (!b.gl.BufferStorage) return false;
+		GLint major = 0, minor = 0, count = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		if (major > 4 || (major == 4 && minor >= 4)) return true;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; i++) {
+			const char* ext = (const char*)b.gl.GetStringi(GL_EXTENSIONS, (GLuint)i);
+			if (ext && std::strcmp(ext, "GL_ARB_buffer_storage") == 0) return true;
+		}
+		return false;
+	}
+
+	// (Re)creates the vertex and index buffers for at least the given element counts. Expects the
+	// backend's VAO to be bound, the element buffer binding is part of its state.
+	inline void CreateBuffersGL3(size_t vtxCount, size_t idxCount) {
+		GL3Backend& b = GetGL3Backend();
+		GL3Functions& gl = b.gl;
+		if (b.vbo) {
+			// buffers still in use by queued frames stay alive until the GPU is done with them
+			for (auto& f : b.fences) {
+				if (f) gl.DeleteSync(f);
+				f = nullptr;
+			}
+			if (b.persistent) {
+				gl.BindBuffer(GL_ARRAY_BUFFER, b.vbo);
+				gl.UnmapBuffer(GL_ARRAY_BUFFER);
+				gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, b.ebo);
+				gl.UnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+			}
+			GLuint buffers[2] = { b.vbo, b.ebo };
+			gl.DeleteBuffers(2, buffers);
+		}
+		b.vtxCapacity = b.vtxCapacity ? b.vtxCapacity : 4096;
+		b.idxCapacity = b.idxCapacity ? b.idxCapacity : 6144;
+		while (b.vtxCapacity < vtxCount) b.vtxCapacity *= 2;
+		while (b.idxCapacity < idxCount) b.idxCapacity *= 2;
+
+		GLuint buffers[2];
+		gl.GenBuffers(2, buffers);
+		b.vbo = buffers[0];
+		b.ebo = buffers[1];
+		gl.BindBuffer(GL_ARRAY_BUFFER, b.vbo);
+		gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, b.ebo);
+		if (b.persistent) {
+			const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			std::ptrdiff_t vtxBytes = (std::ptrdiff_t)(b.vtxCapacity * sizeof(DrawVert) * GL3Backend::Segments);
+			std::ptrdiff_t idxBytes = (std::ptrdiff_t)(b.idxCapacity * sizeof(DrawIdx) * GL3Backend::Segments);
+			gl.BufferStorage(GL_ARRAY_BUFFER, vtxBytes, nullptr, flags);
+			gl.BufferStorage(GL_ELEMENT_ARRAY_BUFFER, idxBytes, nullptr, flags);
+			b.vtxMapped = (DrawVert*)gl.MapBufferRange(GL_ARRAY_BUFFER, 0, vtxBytes, flags);
+			b.idxMapped = (DrawIdx*)gl.MapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, idxBytes, flags);
+		}
+		else {
+			gl.BufferData(GL_ARRAY_BUFFER, (std::ptrdiff_t)(b.vtxCapacity * sizeof(DrawVert)), nullptr, GL_STREAM_DRAW);
+			gl.BufferData(GL_ELEMENT_ARRAY_BUFFER, (std::ptrdiff_t)(b.idxCapacity * sizeof(DrawIdx)), nullptr, GL_STREAM_DRAW);
+		}
+
+		gl.EnableVertexAttribArray(0);
+		gl.EnableVertexAttribArray(1);
+		gl.EnableVertexAttribArray(2);
+		gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(DrawVert), (const void*)offsetof(DrawVert, x));
+		gl.VertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(DrawVert), (const void*)offsetof(DrawVert, u));
+		gl.VertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DrawVert), (const void*)offsetof(DrawVert, col));
+		// the VAO keeps the vertex buffer, leaving it bound would hand out a name that may get deleted
+		gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+		b.segment = 0;
+	}
+
+	// Call with the core profile context current. load = nullptr uses wglGetProcAddress on Windows.
+	// allowPersistent = false forces the orphaning path even where buffer storage exists.
+	inline bool InitGL3Backend(GL3LoadProc load = nullptr, bool allowPersistent = true) {
+		GL3Backend& b = GetGL3Backend();
+		if (b.initialized) return true;
+#if defined(_WIN32)
+		if (!load) load = DefaultGL3Loader;
+#endif
+		if (!load || !b.gl.Load(load)) return false;
+
+		b.program = CompileProgramGL3(
+			"#version 330 core\n"
+			"layout(location = 0) in vec2 aPos;\n"
+			"layout(location = 1) in vec2 aUV;\n"
+			"layout(location = 2) in vec4 aCol;\n"
+			"uniform mat4 uProj;\n"
+			"out vec2 vUV;\n"
+			"out vec4 vCol;\n"
+			"void main() {\n"
+			"	vUV = aUV;\n"
+			"	vCol = aCol;\n"
+			"	gl_Position = uProj * vec4(aPos, 0.0, 1.0);\n"
+			"}\n",
+			"#version 330 core\n"
+			"uniform sampler2D uTex;\n"
+			"in vec2 vUV;\n"
+			"in vec4 vCol;\n"
+			"out vec4 oCol;\n"
+			"void main() {\n"
+			"	oCol = vCol * texture(uTex, vUV);\n"
+			"}\n");
+		if (!b.program) return false;
+		b.projLoc = b.gl.GetUniformLocation(b.program, "uProj");
+		b.texLoc = b.gl.GetUniformLocation(b.program, "uTex");
+
+		// commands without a texture sample this, so one shader covers both
+		const unsigned char white[4] = { 255, 255, 255, 255 };
+		glGenTextures(1, &b.whiteTexture);
+		glBindTexture(GL_TEXTURE_2D, b.whiteTexture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		b.persistent = allowPersistent && HasBufferStorageGL3();
+		b.gl.GenVertexArrays(1, &b.vao);
+		b.gl.BindVertexArray(b.vao);
+		CreateBuffersGL3(0, 0);
+		b.gl.BindVertexArray(0);
+		b.initialized = true;
+		return true;
+	}
+
+	inline void ShutdownGL3Backend() {
+		GL3Backend& b = GetGL3Backend();
+		if (!b.initialized) return;
+		GL3Functions& gl = b.gl;
+		for (auto& f : b.fences) {
+			if (f) gl.DeleteSync(f);
+			f = nullptr;
+		}
+		if (b.persistent) {
+			gl.BindVertexArray(b.vao);
+			gl.BindBuffer(GL_ARRAY_BUFFER, b.vbo);
+			gl.UnmapBuffer(GL_ARRAY_BUFFER);
+			gl.UnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+			gl.BindVertexArray(0);
+		}
+		GLuint buffers[2] = { b.vbo, b.ebo };
+		gl.DeleteBuffers(2, buffers);
+		gl.DeleteVertexArrays(1, &b.vao);
+		gl.DeleteProgram(b.program);
+		glDeleteTextures(1, &b.whiteTexture);
+		GL3Functions keep = b.gl;
+		b = GL3Backend();
+		b.gl = keep;
+	}
+
+	// --- Rendering ---
+
+	// Draws the list in pixel coordinates over a fbWidth x fbHeight framebuffer. Sets the blend,
+	// scissor and depth state it needs and restores it, along with the program, VAO and texture.
+	inline void RenderDrawListGL3(const DrawList& dl, int fbWidth, int fbHeight) {
+		GL3Backend& b = GetGL3Backend();
+		if (!b.initialized || dl.idx.empty() || fbWidth <= 0 || fbHeight <= 0) return;
+		GL3Functions& gl = b.gl;
+
+		GLint lastProgram = 0, lastVao = 0, lastTexture = 0, lastActiveTexture = 0, lastArrayBuffer = 0;
+		GLint lastBlendSrc = 0, lastBlendDst = 0;
+		glGetIntegerv(GL_CURRENT_PROGRAM, &lastProgram);
+		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &lastVao);
+		glGetIntegerv(GL_ACTIVE_TEXTURE, &lastActiveTexture);
+		gl.ActiveTexture(GL_TEXTURE0);
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &lastTexture);
+		glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &lastArrayBuffer);
+		glGetIntegerv(GL_BLEND_SRC_RGB, &lastBlendSrc);
+		glGetIntegerv(GL_BLEND_DST_RGB, &lastBlendDst);
+		GLboolean lastBlend = glIsEnabled(GL_BLEND), lastDepth = glIsEnabled(GL_DEPTH_TEST);
+		GLboolean lastCull = glIsEnabled(GL_CULL_FACE), lastScissor = glIsEnabled(GL_SCISSOR_TEST);
+
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_CULL_FACE);
+		glEnable(GL_SCISSOR_TEST);
+
+		const float proj[16] = {
+			2.0f / fbWidth, 0, 0, 0,
+			0, -2.0f / fbHeight, 0, 0,
+			0, 0, -1, 0,
+			-1, 1, 0, 1
+		};
+		gl.UseProgram(b.program);
+		gl.UniformMatrix4fv(b.projLoc, 1, GL_FALSE, proj);
+		gl.Uniform1i(b.texLoc, 0);
+		gl.BindVertexArray(b.vao);
+
+		// upload, growing the buffers when the frame doesn't fit
+		size_t vtxCount = dl.vtx.size(), idxCount = dl.idx.size();
+		if (vtxCount > b.vtxCapacity || idxCount > b.idxCapacity) CreateBuffersGL3(vtxCount, idxCount);
+		GLint baseVertex = 0;
+		size_t idxBase = 0;
+		if (b.persistent) {
+			GL3Functions::Sync& fence = b.fences[b.segment];
+			if (fence) {
+				// only blocks when the GPU is Segments frames behind
+				while (gl.ClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL) == GL_TIMEOUT_EXPIRED) {}
+				gl.DeleteSync(fence);
+				fence = nullptr;
+			}
+			size_t vtxOffset = b.vtxCapacity * b.segment;
+			idxBase = b.idxCapacity * b.segment;
+			std::memcpy(b.vtxMapped + vtxOffset, &dl.vtx[0], vtxCount * sizeof(DrawVert));
+			std::memcpy(b.idxMapped + idxBase, &dl.idx[0], idxCount * sizeof(DrawIdx));
+			baseVertex = (GLint)vtxOffset;
+		}
+		else {
+			gl.BindBuffer(GL_ARRAY_BUFFER, b.vbo);
+			gl.BufferData(GL_ARRAY_BUFFER, (std::ptrdiff_t)(b.vtxCapacity * sizeof(DrawVert)), nullptr, GL_STREAM_DRAW);
+			gl.BufferSubData(GL_ARRAY_BUFFER, 0, (std::ptrdiff_t)(vtxCount * sizeof(DrawVert)), &dl.vtx[0]);
+			gl.BufferData(GL_ELEMENT_ARRAY_BUFFER, (std::ptrdiff_t)(b.idxCapacity * sizeof(DrawIdx)), nullptr, GL_STREAM_DRAW);
+			gl.BufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, (std::ptrdiff_t)(idxCount * sizeof(DrawIdx)), &dl.idx[0]);
+		}
+
+		GLuint boundTexture = (GLuint)-1;
+		for (const DrawCmd& cmd : dl.cmds) {
+			if (!cmd.elemCount) continue;
+			float x0 = cmd.clip.x0 > 0.0f ? cmd.clip.x0 : 0.0f, y0 = cmd.clip.y0 > 0.0f ? cmd.clip.y0 : 0.0f;
+			float x1 = cmd.clip.x1 < (float)fbWidth ? cmd.clip.x1 : (float)fbWidth;
+			float y1 = cmd.clip.y1 < (float)fbHeight ? cmd.clip.y1 : (float)fbHeight;
+			if (x1 <= x0 || y1 <= y0) continue;
+			glScissor((int)x0, fbHeight - (int)y1, (int)(x1 - x0), (int)(y1 - y0));
+
+			GLuint tex = cmd.texture ? cmd.texture : b.whiteTexture;
+			if (tex != boundTexture) {
+				glBindTexture(GL_TEXTURE_2D, tex);
+				boundTexture = tex;
+			}
+			gl.DrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)cmd.elemCount, GL_UNSIGNED_INT,
+				(const void*)((idxBase + cmd.idxOffset) * sizeof(DrawIdx)), baseVertex);
+		}
+
+		if (b.persistent) {
+			b.fences[b.segment] = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			b.segment = (b.segment + 1) % GL3Backend::Segments;
+		}
+
+		gl.UseProgram((GLuint)lastProgram);
+		gl.BindVertexArray((GLuint)lastVao);
+		gl.BindBuffer(GL_ARRAY_BUFFER, (GLuint)lastArrayBuffer);
+		glBindTexture(GL_TEXTURE_2D, (GLuint)lastTexture);
+		gl.ActiveTexture((GLenum)lastActiveTexture);
+		glBlendFunc((GLenum)lastBlendSrc, (GLenum)lastBlendDst);
+		if (!lastBlend) glDisable(GL_BLEND);
+		if (lastDepth) glEnable(GL_DEPTH_TEST);
+		if (lastCull) glEnable(GL_CULL_FACE);
+		if (!lastScissor) glDisable(GL_SCISSOR_TEST);
+	}
+
+}
+
+#endif
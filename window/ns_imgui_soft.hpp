@@ -0,0 +1,406 @@
+/*
+	ns_imgui_soft.hpp
+
+	Copyright (C) 2025 Nico Rajala. All rights reserved.
+
+	CPU rasterizer backend for NSImgui draw lists.
+
+	Use at your own risk. No warranties are provided.
+
+	---
+
+	Renders a DrawList into an RGBA8 framebuffer in memory, no GL or display needed. Meant for
+	pixel comparison tests and for measuring frame cost on build machines.
+
+	Almost everything NSImgui draws is an axis aligned quad, so quads are recognized and filled
+	span by span (solid spans with SSE2 blending where available), anything else goes through a
+	plain edge function triangle rasterizer. The framebuffer is cut into tiles, primitives are
+	binned per tile in submission order, and tiles are shaded in parallel, so threads never
+	touch the same pixels. SIMD and scalar paths produce identical bytes.
+
+	Needs C++11 (std::thread).
+
+	Usage:
+		NSImgui::SoftRenderer sr(800, 600);
+		sr.UploadFontAtlas(NSImgui::GetFontAtlas());
+		NSImgui::NewFrame(...); NSImgui::BeginGUI(800, 600); ...widgets...; NSImgui::EndGUI();
+		sr.Clear(NSImgui::PackColor(0.1f, 0.1f, 0.2f));
+		sr.Render(NSImgui::GetDrawList(), 4);
+		sr.SavePPM("frame.ppm");
+*/
+
+#ifndef NS_IMGUI_SOFT_HPP
+#define NS_IMGUI_SOFT_HPP
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NSIMGUI_SOFT_SSE2
+#endif
+
+#include "ns_imgui_draw.hpp"
+
+namespace NSImgui {
+
+	class SoftRenderer {
+	public:
+		static const int TileSize = 64;
+
+		SoftRenderer() {}
+		SoftRenderer(int w, int h) { Resize(w, h); }
+
+		void Resize(int w, int h) {
+			width = w < 0 ? 0 : w;
+			height = h < 0 ? 0 : h;
+			pixels.assign((size_t)width * height, 0);
+			tilesX = (width + TileSize - 1) / TileSize;
+			tilesY = (height + TileSize - 1) / TileSize;
+		}
+
+		void Clear(DrawColor c) { std::fill(pixels.begin(), pixels.end(), c); }
+
+		// --- Textures ---
+
+		// Copies w*h RGBA8 pixels, returns the id to put in DrawCmd::texture (never 0)
+		unsigned int CreateTexture(const unsigned char* rgba, int w, int h) {
+			Texture t;
+			t.w = w;
+			t.h = h;
+			t.texels.resize((size_t)w * h);
+			std::memcpy(&t.texels[0], rgba, (size_t)w * h * 4);
+			textures.push_back(t);
+			return (unsigned int)textures.size();
+		}
+
+		// Ids are per renderer, so this always uploads; call it once per renderer, before BeginGUI
+		void UploadFontAtlas(FontAtlas& atlas) {
+			atlas.texture = CreateTexture(&atlas.pixels[0], FontAtlas::Width, FontAtlas::Height);
+		}
+
+		// --- Rendering ---
+
+		// Draws the list over what is already in the framebuffer. threads = 0 uses one per core.
+		void Render(const DrawList& dl, unsigned threads = 1) {
+			if (!width || !height) return;
+			BuildPrimitives(dl);
+			BinPrimitives();
+
+			if (!threads) threads = std::thread::hardware_concurrency();
+			if (threads < 1) threads = 1;
+			unsigned tileCount = (unsigned)(tilesX * tilesY);
+			if (threads > tileCount) threads = tileCount;
+
+			std::atomic<unsigned> next(0);
+			auto work = [this, &next, tileCount]() {
+				for (unsigned t; (t = next++) < tileCount; )
+					ShadeTile((int)(t % tilesX), (int)(t / tilesX));
+			};
+			std::vector<std::thread> pool;
+			for (unsigned i = 1; i < threads; i++) pool.push_back(std::thread(work));
+			work();
+			for (auto& th : pool) th.join();
+		}
+
+		// --- Output ---
+
+		int Width() const { return width; }
+		int Height() const { return height; }
+		const DrawColor* Pixels() const { return pixels.empty() ? nullptr : &pixels[0]; }
+		DrawColor Pixel(int x, int y) const { return pixels[(size_t)y * width + x]; }
+
+		// Binary PPM (RGB, alpha dropped), readable by about every image tool
+		bool SavePPM(const char* path) const {
+			FILE* f = std::fopen(path, "wb");
+			if (!f) return false;
+			std::fprintf(f, "P6\n%d %d\n255\n", width, height);
+			std::vector<unsigned char> row((size_t)width * 3);
+			for (int y = 0; y < height; y++) {
+				for (int x = 0; x < width; x++) {
+					const unsigned char* p = reinterpret_cast<const unsigned char*>(&pixels[(size_t)y * width + x]);
+					row[x * 3] = p[0]; row[x * 3 + 1] = p[1]; row[x * 3 + 2] = p[2];
+				}
+				std::fwrite(&row[0], 1, row.size(), f);
+			}
+			return std::fclose(f) == 0;
+		}
+
+		// Pixels where any channel differs by more than tolerance, for image comparison tests
+		static size_t DiffPixels(const SoftRenderer& a, const SoftRenderer& b, int tolerance = 0) {
+			if (a.width != b.width || a.height != b.height) return (size_t)-1;
+			size_t n = 0;
+			for (size_t i = 0; i < a.pixels.size(); i++) {
+				const unsigned char* p = reinterpret_cast<const unsigned char*>(&a.pixels[i]);
+				const unsigned char* q = reinterpret_cast<const unsigned char*>(&b.pixels[i]);
+				for (int c = 0; c < 4; c++) {
+					int d = (int)p[c] - (int)q[c];
+					if (d > tolerance || -d > tolerance) { n++; break; }
+				}
+			}
+			return n;
+		}
+
+	private:
+		struct Texture {
+			int w = 0, h = 0;
+			std::vector<DrawColor> texels;
+		};
+
+		// Pixel bounds are half open, [x0, x1) x [y0, y1), already clipped to the scissor rect
+		struct Primitive {
+			int x0, y0, x1, y1;
+			bool isRect;
+			// rect
+			float fx0, fy0, fx1, fy1, u0, v0, u1, v1;
+			DrawColor col;
+			// triangle
+			DrawVert tri[3];
+			const Texture* tex;
+		};
+
+		int width = 0, height = 0;
+		int tilesX = 0, tilesY = 0;
+		std::vector<DrawColor> pixels;
+		std::vector<Texture> textures;
+		std::vector<Primitive> prims;
+		std::vector<std::vector<unsigned int>> bins;
+
+		// --- Pixel math ---
+
+		// round(x / 255) for x in [0, 255*255], the same formula in the SIMD path
+		static inline unsigned int Div255(unsigned int x) {
+			x += 128;
+			return (x + (x >> 8)) >> 8;
+		}
+
+		static inline DrawColor Blend(DrawColor dst, DrawColor src) {
+			unsigned int a = src >> 24;
+			if (a == 255) return src;
+			if (a == 0) return dst;
+			unsigned int ia = 255 - a;
+			DrawColor out = 0;
+			for (int shift = 0; shift < 24; shift += 8) {
+				unsigned int s = (src >> shift) & 255, d = (dst >> shift) & 255;
+				out |= Div255(s * a + d * ia) << shift;
+			}
+			unsigned int da = dst >> 24;
+			out |= (a + Div255(da * ia)) << 24;
+			return out;
+		}
+
+		// color * texel, per channel
+		static inline DrawColor Modulate(DrawColor c, DrawColor t) {
+			if (t == 0xFFFFFFFFu) return c;
+			DrawColor out = 0;
+			for (int shift = 0; shift < 32; shift += 8)
+				out |= Div255(((c >> shift) & 255) * ((t >> shift) & 255)) << shift;
+			return out;
+		}
+
+		// Blends one color over n pixels
+		static void BlendSpan(DrawColor* dst, int n, DrawColor src) {
+			unsigned int a = src >> 24;
+			if (a == 0) return;
+			if (a == 255) {
+				std::fill(dst, dst + n, src);
+				return;
+			}
+			int i = 0;
+#ifdef NSIMGUI_SOFT_SSE2
+			// src * a (and the alpha channel's a * 255) and 255 - a are the same for every pixel
+			unsigned int ia = 255 - a;
+			const __m128i zero = _mm_setzero_si128();
+			unsigned short sa[8], fa[8];
+			for (int c = 0; c < 4; c++) {
+				unsigned int s = c == 3 ? 255 : (src >> (c * 8)) & 255;
+				sa[c] = sa[c + 4] = (unsigned short)(s * a + 128);
+				fa[c] = fa[c + 4] = (unsigned short)ia;
+			}
+			__m128i srcTerm = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sa));
+			__m128i factor = _mm_loadu_si128(reinterpret_cast<const __m128i*>(fa));
+			for (; i + 4 <= n; i += 4) {
+				__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+				__m128i lo = _mm_unpacklo_epi8(d, zero), hi = _mm_unpackhi_epi8(d, zero);
+				lo = _mm_add_epi16(_mm_mullo_epi16(lo, factor), srcTerm);
+				hi = _mm_add_epi16(_mm_mullo_epi16(hi, factor), srcTerm);
+				lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+				hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+			}
+#endif
+			for (; i < n; i++) dst[i] = Blend(dst[i], src);
+		}
+
+		// --- Setup ---
+
+		static bool IsRectQuad(const DrawVert* v) {
+			return v[0].y == v[1].y && v[1].x == v[2].x && v[2].y == v[3].y && v[3].x == v[0].x &&
+				v[0].v == v[1].v && v[1].u == v[2].u && v[2].v == v[3].v && v[3].u == v[0].u &&
+				v[0].col == v[1].col && v[0].col == v[2].col && v[0].col == v[3].col &&
+				v[0].x < v[1].x && v[0].y < v[3].y;
+		}
+
+		// first pixel whose center is at or right of edge, GL's sampling rule
+		static inline int PixelEdge(float e) { return (int)std::ceil(e - 0.5f); }
+
+		void ClipBounds(Primitive& p, const ClipRect& clip, float bx0, float by0, float bx1, float by1) {
+			int cx0 = (int)NMaxf(clip.x0, 0.0f), cy0 = (int)NMaxf(clip.y0, 0.0f);
+			int cx1 = clip.x1 < (float)width ? (int)clip.x1 : width;
+			int cy1 = clip.y1 < (float)height ? (int)clip.y1 : height;
+			p.x0 = PixelEdge(bx0); p.y0 = PixelEdge(by0);
+			p.x1 = PixelEdge(bx1); p.y1 = PixelEdge(by1);
+			if (p.x0 < cx0) p.x0 = cx0;
+			if (p.y0 < cy0) p.y0 = cy0;
+			if (p.x1 > cx1) p.x1 = cx1;
+			if (p.y1 > cy1) p.y1 = cy1;
+		}
+
+		static inline float NMaxf(float a, float b) { return a > b ? a : b; }
+
+		void BuildPrimitives(const DrawList& dl) {
+			prims.clear();
+			for (const DrawCmd& cmd : dl.cmds) {
+				const Texture* tex = cmd.texture && cmd.texture <= textures.size() ? &textures[cmd.texture - 1] : nullptr;
+				const DrawIdx* idx = dl.idx.empty() ? nullptr : &dl.idx[cmd.idxOffset];
+				for (unsigned int i = 0; i + 3 <= cmd.elemCount; ) {
+					Primitive p;
+					p.tex = tex;
+					// quads as emitted by DrawList::AddQuad: b, b+1, b+2, b, b+2, b+3
+					if (i + 6 <= cmd.elemCount) {
+						DrawIdx b = idx[i];
+						if (idx[i + 1] == b + 1 && idx[i + 2] == b + 2 && idx[i + 3] == b && idx[i + 4] == b + 2 && idx[i + 5] == b + 3 &&
+							b + 3 < dl.vtx.size() && IsRectQuad(&dl.vtx[b])) {
+							const DrawVert* v = &dl.vtx[b];
+							p.isRect = true;
+							p.fx0 = v[0].x; p.fy0 = v[0].y; p.fx1 = v[2].x; p.fy1 = v[2].y;
+							p.u0 = v[0].u; p.v0 = v[0].v; p.u1 = v[2].u; p.v1 = v[2].v;
+							p.col = v[0].col;
+							ClipBounds(p, cmd.clip, p.fx0, p.fy0, p.fx1, p.fy1);
+							// solid: untextured, or the whole quad samples one texel (the atlas white block)
+							if (tex && p.u0 == p.u1 && p.v0 == p.v1) {
+								p.col = Modulate(p.col, Sample(*tex, p.u0, p.v0));
+								p.tex = nullptr;
+							}
+							if (p.x0 < p.x1 && p.y0 < p.y1) prims.push_back(p);
+							i += 6;
+							continue;
+						}
+					}
+					p.isRect = false;
+					bool ok = true;
+					for (int k = 0; k < 3; k++) {
+						if (idx[i + k] >= dl.vtx.size()) ok = false;
+						else p.tri[k] = dl.vtx[idx[i + k]];
+					}
+					i += 3;
+					if (!ok) continue;
+					float bx0 = std::fmin(p.tri[0].x, std::fmin(p.tri[1].x, p.tri[2].x));
+					float by0 = std::fmin(p.tri[0].y, std::fmin(p.tri[1].y, p.tri[2].y));
+					float bx1 = std::fmax(p.tri[0].x, std::fmax(p.tri[1].x, p.tri[2].x));
+					float by1 = std::fmax(p.tri[0].y, std::fmax(p.tri[1].y, p.tri[2].y));
+					ClipBounds(p, cmd.clip, bx0, by0, bx1 + 1, by1 + 1);
+					if (p.x0 < p.x1 && p.y0 < p.y1) prims.push_back(p);
+				}
+			}
+		}
+
+		void BinPrimitives() {
+			bins.resize((size_t)tilesX * tilesY);
+			for (auto& b : bins) b.clear();
+			for (unsigned int i = 0; i < prims.size(); i++) {
+				const Primitive& p = prims[i];
+				int tx0 = p.x0 / TileSize, ty0 = p.y0 / TileSize;
+				int tx1 = (p.x1 - 1) / TileSize, ty1 = (p.y1 - 1) / TileSize;
+				for (int ty = ty0; ty <= ty1; ty++)
+					for (int tx = tx0; tx <= tx1; tx++)
+						bins[(size_t)ty * tilesX + tx].push_back(i);
+			}
+		}
+
+		// --- Shading ---
+
+		static inline DrawColor Sample(const Texture& t, float u, float v) {
+			int x = (int)std::floor(u * t.w), y = (int)std::floor(v * t.h);
+			if (x < 0) x = 0; else if (x >= t.w) x = t.w - 1;
+			if (y < 0) y = 0; else if (y >= t.h) y = t.h - 1;
+			return t.texels[(size_t)y * t.w + x];
+		}
+
+		void ShadeTile(int tx, int ty) {
+			int tx0 = tx * TileSize, ty0 = ty * TileSize;
+			int tx1 = tx0 + TileSize < width ? tx0 + TileSize : width;
+			int ty1 = ty0 + TileSize < height ? ty0 + TileSize : height;
+			for (unsigned int pi : bins[(size_t)ty * tilesX + tx]) {
+				const Primitive& p = prims[pi];
+				int x0 = p.x0 > tx0 ? p.x0 : tx0, x1 = p.x1 < tx1 ? p.x1 : tx1;
+				int y0 = p.y0 > ty0 ? p.y0 : ty0, y1 = p.y1 < ty1 ? p.y1 : ty1;
+				if (x0 >= x1 || y0 >= y1) continue;
+				if (p.isRect) ShadeRect(p, x0, y0, x1, y1);
+				else ShadeTriangle(p, x0, y0, x1, y1);
+			}
+		}
+
+		void ShadeRect(const Primitive& p, int x0, int y0, int x1, int y1) {
+			if (!p.tex) {
+				for (int y = y0; y < y1; y++) BlendSpan(&pixels[(size_t)y * width + x0], x1 - x0, p.col);
+				return;
+			}
+			// texel coordinates at pixel centers
+			const Texture& t = *p.tex;
+			float du = (p.u1 - p.u0) / (p.fx1 - p.fx0), dv = (p.v1 - p.v0) / (p.fy1 - p.fy0);
+			int n = x1 - x0;
+			int cols[TileSize];
+			for (int i = 0; i < n; i++) {
+				int c = (int)std::floor((p.u0 + (x0 + i + 0.5f - p.fx0) * du) * t.w);
+				cols[i] = c < 0 ? 0 : (c >= t.w ? t.w - 1 : c);
+			}
+			for (int y = y0; y < y1; y++) {
+				int r = (int)std::floor((p.v0 + (y + 0.5f - p.fy0) * dv) * t.h);
+				r = r < 0 ? 0 : (r >= t.h ? t.h - 1 : r);
+				const DrawColor* texRow = &t.texels[(size_t)r * t.w];
+				DrawColor* dst = &pixels[(size_t)y * width + x0];
+				for (int i = 0; i < n; i++) {
+					DrawColor texel = texRow[cols[i]];
+					if (!(texel >> 24)) continue;	// glyph background
+					dst[i] = Blend(dst[i], Modulate(p.col, texel));
+				}
+			}
+		}
+
+		void ShadeTriangle(const Primitive& p, int x0, int y0, int x1, int y1) {
+			const DrawVert& a = p.tri[0];
+			const DrawVert& b = p.tri[1];
+			const DrawVert& c = p.tri[2];
+			float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+			if (area == 0) return;
+			float inv = 1.0f / area;
+			auto channel = [](DrawColor col, int k) { return (float)((col >> (k * 8)) & 255); };
+			for (int y = y0; y < y1; y++) {
+				float py = y + 0.5f;
+				for (int x = x0; x < x1; x++) {
+					float px = x + 0.5f;
+					float w0 = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) * inv;
+					float w1 = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) * inv;
+					float w2 = 1.0f - w0 - w1;
+					if (w0 < 0 || w1 < 0 || w2 < 0) continue;
+					DrawColor col = 0;
+					for (int k = 0; k < 4; k++) {
+						float v = w0 * channel(a.col, k) + w1 * channel(b.col, k) + w2 * channel(c.col, k);
+						col |= (DrawColor)(v + 0.5f) << (k * 8);
+					}
+					if (p.tex) col = Modulate(col, Sample(*p.tex, w0 * a.u + w1 * b.u + w2 * c.u, w0 * a.v + w1 * b.v + w2 * c.v));
+					DrawColor& dst = pixels[(size_t)y * width + x];
+					dst = Blend(dst, col);
+				}
+			}
+		}
+	};
+
+}
+
+#endif
@@ -17,11 +17,28 @@
 #ifndef NS_IMMEDIATE_GUI_HPP
 #define NS_IMMEDIATE_GUI_HPP
 
+#if defined(_WIN32)
 #include <windows.h>
+#endif
+// Define NSIMGUI_NO_GL to build the GUI without any GL backend (headless draw list use).
+// Define NSIMGUI_GL3 to render through the OpenGL 3.3 core profile backend (ns_imgui_gl3.hpp)
+// instead of the fixed function one, call InitGL3Backend once the context is current.
+#ifndef NSIMGUI_NO_GL
 #include <GL/gl.h>
+#ifdef NSIMGUI_GL3
+#include "ns_imgui_gl3.hpp"
+#endif
+#endif
 #include <cstring>
+#include <cstdio>
+#include <string>
 #include <vector>
 #include <algorithm>
+#include <unordered_map>
+#include <deque>
+#include <chrono>
+
+#include "ns_imgui_draw.hpp"
 
 #include "math/math.hpp"
 using namespace NMATH;
@@ -130,13 +147,28 @@ namespace NSImgui {
 
 	// --- Core types and state and stuff ---
 	struct WindowState;
+	typedef unsigned int WidgetId; // 0 = none
+
 	struct State {
 		int mouseX, mouseY;
 		bool mouseDown, mousePressed, mouseReleased;
-		int hotItem, activeItem, lastWidget;
-		int selectedWindow;
+		WidgetId hotItem, activeItem;
+		std::vector<WidgetId> idStack; // see PushID, BeginWindow pushes the window's id
+		int selectedWindow; // slot of the selected window, see WindowPool
+		int hoveredWindow = -1; // slot of the topmost window under the mouse, set by BeginGUI
+		float mouseWheel = 0; // notches this frame, positive away from the user
 		WindowState* draggingWindow = nullptr;
 		int dockHoverTarget = -1; // 0=left,1=right,2=top,3=bottom,4=center,-1=none
+		int fbWidth = 0, fbHeight = 0; // set by BeginGUI
+		int fontScale = 1; // integer glyph scale, 2 for 200% DPI
+		unsigned int frameCount = 0;
+
+		// Change tracking, see FrameChanged and IdleTimeout
+		bool frameChanged = true;          // set by FinishGUI
+		unsigned long long frameHash = 0;  // of the last finished frame's draw list
+		WidgetId prevHotItem = 0, prevActiveItem = 0;
+		float redrawIn = -1;               // seconds, RequestRedraw this frame, -1 = none
+		double redrawAt = -1;              // GetTime() a requested redraw is due, -1 = none
 	};
 
 	enum ResizeDir {
@@ -148,7 +180,29 @@ namespace NSImgui {
 		BottomRight = Right | Bottom
 	};
 
+	typedef unsigned int WindowId;
+
+	// What BeginCachedWindow keeps of a window to replay it, captured from a frame in which
+	// nothing was interacting with the window, and valid while nothing below changes
+	struct WindowCache {
+		bool enabled = false;       // drawn with BeginCachedWindow
+		bool valid = false;
+		unsigned int version = 0;   // the application's content version it was drawn with
+		float x = 0, y = 0, w = 0, h = 0, alpha = 0;
+		bool selected = false;
+		int fontScale = 0;
+		unsigned int texture = 0;   // font atlas, a new GL context uploads it again
+		int fbWidth = 0, fbHeight = 0; // the root clip, a window past the old edge was cut there
+		unsigned long long hash = 0; // of draw
+		DrawCapture draw;
+		std::vector<WidgetId> retained; // states the widgets keep, kept alive while replayed
+		unsigned int replayed = 0;  // frames replayed in a row
+	};
+
 	struct WindowState {
+		WindowId id = 0;   // hash of the title
+		int slot = -1;     // position in WindowPool::slots, never changes
+		int zIndex = -1;   // position in WindowPool::zOrder
 		char title[64];
 		float x, y, w, h;
 		bool open;
@@ -158,6 +212,12 @@ namespace NSImgui {
 		float resizeStartW = 0, resizeStartH = 0;
 		float resizeStartX = 0, resizeStartY = 0;
 
+		unsigned int lastFrame = 0; // last frame BeginWindow ran for it
+		float scrollY = 0;          // content scroll offset
+		float contentH = 0;         // height the widgets took last frame, measured in EndWindow
+		size_t drawVtxStart = 0, drawIdxStart = 0; // where the window's output starts this frame
+		WindowCache cache;
+
 		float userWidth = 0, userHeight = 0;
 		bool userSized = false;
 
@@ -184,6 +244,10 @@ namespace NSImgui {
 	}
 
 	constexpr float WidgetMargin = 4.0f;
+	constexpr float TitleBarHeight = 24.0f;
+	constexpr float ContentPadding = 32.0f; // window top to the first widget
+	constexpr float ScrollbarWidth = 8.0f;
+	constexpr float ScrollStep = 40.0f; // pixels per wheel notch
 
 	// --- State management, windowing and layout stuff --- 
 
@@ -192,35 +256,167 @@ namespace NSImgui {
 		return state;
 	}
 
-	inline void NewFrame(int mouseX, int mouseY, bool mouseDown, bool mousePressed, bool mouseReleased) {
+	inline void NewFrame(int mouseX, int mouseY, bool mouseDown, bool mousePressed, bool mouseReleased, float mouseWheel = 0) {
 		State& s = GetState();
 		s.mouseX = mouseX;
 		s.mouseY = mouseY;
 		s.mouseDown = mouseDown;
 		s.mousePressed = mousePressed;
 		s.mouseReleased = mouseReleased;
+		s.mouseWheel = mouseWheel;
+		s.redrawIn = -1;
 		s.hotItem = 0;
-		s.lastWidget = 0;
+		s.idStack.clear();
+		s.frameCount++;
+	}
+
+	// Seconds on a monotonic clock
+	inline double GetTime() {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Asks for another frame within seconds even without input, for animations, timers and
+	// anything else the GUI can't see changing. 0 means right after this one. Call it every
+	// frame the animation runs.
+	inline void RequestRedraw(float seconds = 0) {
+		State& s = GetState();
+		if (seconds < 0) seconds = 0;
+		if (s.redrawIn < 0 || seconds < s.redrawIn) s.redrawIn = seconds;
+	}
+
+	// --- Widget IDs ---
+
+	// Widgets are identified by a hash of their label chained onto the ID on top of the ID
+	// stack, so an ID doesn't depend on how many widgets came before it. Skipping a widget for
+	// a frame doesn't change anyone else's identity. Identical labels in one window need
+	// PushID/PopID around them (loop index, object pointer) to tell them apart.
+
+	// FNV-1a, seeded with the parent ID so the same label under different parents differs
+	inline WidgetId HashId(const void* data, size_t size, WidgetId seed = 2166136261u) {
+		const unsigned char* p = static_cast<const unsigned char*>(data);
+		WidgetId h = seed;
+		for (size_t i = 0; i < size; i++) {
+			h ^= p[i];
+			h *= 16777619u;
+		}
+		return h ? h : 1;
 	}
 
-	inline std::vector<WindowState>& GetWindows() {
-		static std::vector<WindowState> windows;
-		return windows;
+	inline WidgetId GetIDSeed() {
+		State& s = GetState();
+		return s.idStack.empty() ? 2166136261u : s.idStack.back();
+	}
+
+	inline WidgetId GetID(const char* label) { return HashId(label, std::strlen(label), GetIDSeed()); }
+	inline WidgetId GetID(const void* ptr) { return HashId(&ptr, sizeof(ptr), GetIDSeed()); }
+	inline WidgetId GetID(int n) { return HashId(&n, sizeof(n), GetIDSeed()); }
+
+	inline void PushID(WidgetId id) { GetState().idStack.push_back(id); }
+	inline void PushID(const char* label) { PushID(GetID(label)); }
+	inline void PushID(const void* ptr) { PushID(GetID(ptr)); }
+	inline void PushID(int n) { PushID(GetID(n)); }
+	inline void PopID() {
+		State& s = GetState();
+		if (!s.idStack.empty()) s.idStack.pop_back();
+	}
+
+	// --- Retained widget state ---
+
+	// What a widget has to remember between frames, keyed by its ID. Entries not touched for
+	// WidgetStateMaxAge frames are dropped in EndGUI.
+	struct WidgetState {
+		unsigned int lastFrame = 0;	// last frame the widget was submitted
+		bool dragging = false;		// SliderFloat: grabbed and not released yet
+		bool focused = false;		// InputText: takes keyboard input
+	};
+
+	constexpr unsigned int WidgetStateMaxAge = 120; // frames
+
+	inline std::unordered_map<WidgetId, WidgetState>& GetWidgetStates() {
+		static std::unordered_map<WidgetId, WidgetState> states;
+		return states;
+	}
+
+	// Remembers id as state the current window's widgets keep, so it isn't trimmed while the
+	// window is replayed from its cache instead of submitted
+	inline void RetainInWindowCache(WidgetId id) {
+		Layout* l = GetLayout();
+		if (l && l->win->cache.enabled) l->win->cache.retained.push_back(id);
+	}
+
+	// The state for id, marked as used this frame. A widget that was skipped last frame (clipped,
+	// collapsed, not submitted) loses its transient flags instead of resuming a stale drag.
+	inline WidgetState& GetWidgetState(WidgetId id) {
+		RetainInWindowCache(id);
+		State& s = GetState();
+		WidgetState& st = GetWidgetStates()[id];
+		if (st.lastFrame + 1 != s.frameCount && st.lastFrame != s.frameCount) {
+			st.dragging = false;
+			st.focused = false;
+		}
+		st.lastFrame = s.frameCount;
+		return st;
+	}
+
+	inline void TrimWidgetStates() {
+		State& s = GetState();
+		auto& states = GetWidgetStates();
+		for (auto it = states.begin(); it != states.end(); ) {
+			if (s.frameCount - it->second.lastFrame > WidgetStateMaxAge) it = states.erase(it);
+			else ++it;
+		}
+	}
+
+	// Windows live in slots that are never moved or freed, so WindowState pointers (dock
+	// parents and children, the dragged window) stay valid for the whole run. Lookup by title
+	// goes through a hash of it, and stacking order is a separate array of slots, so bringing a
+	// window to front doesn't touch the windows themselves.
+	struct WindowPool {
+		std::deque<WindowState> slots;				// stable addresses, grows at the back only
+		std::unordered_map<WindowId, int> lookup;	// title hash -> slot
+		std::vector<int> zOrder;					// slots, back to front
+
+		WindowState& operator[](int slot) { return slots[slot]; }
+		size_t size() const { return slots.size(); }
+	};
+
+	inline WindowPool& GetWindowPool() {
+		static WindowPool pool;
+		return pool;
+	}
+
+	// Over the part of the title that gets stored, never 0. Doubles as the window's ID seed.
+	inline WindowId HashWindowTitle(const char* title) {
+		size_t len = 0;
+		while (len < 63 && title[len]) len++;
+		return HashId(title, len);
 	}
 
 	inline WindowState* FindWindow(const char* title) {
-		auto& ws = GetWindows();
-		for (auto& w : ws)
-			if (std::strcmp(w.title, title) == 0)
-				return &w;
-		return nullptr;
+		WindowPool& pool = GetWindowPool();
+		// colliding titles take the next free id, so a lookup walks that same chain
+		for (WindowId id = HashWindowTitle(title); ; id = id + 1 ? id + 1 : 1) {
+			auto it = pool.lookup.find(id);
+			if (it == pool.lookup.end()) return nullptr;
+			WindowState& w = pool[it->second];
+			if (std::strncmp(w.title, title, 63) == 0) return &w;
+		}
 	}
 
 	inline WindowState* CreateOrGetWindow(const char* title, float x, float y, float w, float h) {
 		WindowState* win = FindWindow(title);
 		if (!win) {
-			GetWindows().push_back(WindowState{});
-			win = &GetWindows().back();
+			WindowPool& pool = GetWindowPool();
+			WindowId id = HashWindowTitle(title);
+			while (pool.lookup.count(id)) id = id + 1 ? id + 1 : 1;
+			int slot = (int)pool.slots.size();
+			pool.slots.push_back(WindowState{});
+			pool.lookup[id] = slot;
+			win = &pool.slots.back();
+			win->id = id;
+			win->slot = slot;
+			win->zIndex = (int)pool.zOrder.size();
+			pool.zOrder.push_back(slot);
 			std::strncpy(win->title, title, 63);
 			win->title[63] = 0;
 			win->x = x; win->y = y; win->w = w; win->h = h; win->open = true;
@@ -231,17 +427,25 @@ namespace NSImgui {
 		return win;
 	}
 
-	inline int GetWindowIndex(WindowState* win) {
-		auto& ws = GetWindows();
-		for (size_t i = 0; i < ws.size(); i++) {
-			if (&ws[i] == win) return (int)i;
+	inline bool IsFrontWindow(const WindowState* win) {
+		return win->zIndex == (int)GetWindowPool().zOrder.size() - 1;
+	}
+
+	// Moves the window to the top of the stacking order, only the zOrder entries above it shift
+	inline void BringWindowToFront(WindowState* win) {
+		WindowPool& pool = GetWindowPool();
+		if (IsFrontWindow(win)) return;
+		for (size_t i = (size_t)win->zIndex + 1; i < pool.zOrder.size(); i++) {
+			pool.zOrder[i - 1] = pool.zOrder[i];
+			pool[pool.zOrder[i - 1]].zIndex = (int)i - 1;
 		}
-		return -1;
+		pool.zOrder.back() = win->slot;
+		win->zIndex = (int)pool.zOrder.size() - 1;
 	}
 
-	void handleResize(State& s, WindowState* win) {
+	inline void handleResize(State& s, WindowState* win) {
 		float mx = (float)s.mouseX, my = (float)s.mouseY;
-		int winIdx = GetWindowIndex(win);
+		int winIdx = win->slot;
 
 		const float edge = 6.0f;
 
@@ -342,7 +546,7 @@ namespace NSImgui {
 		}
 
 		// Cursor
-		if (!win->resizing && s.selectedWindow == GetWindowIndex(win)) {
+		if (!win->resizing && s.selectedWindow == winIdx) {
 			const float edge = 6.0f;
 			float mx = (float)s.mouseX, my = (float)s.mouseY;
 			bool overLeft = mx >= win->x - edge && mx <= win->x + edge && my > win->y + 24 && my < win->y + win->h - edge;
@@ -351,6 +555,7 @@ namespace NSImgui {
 			bool overBL = mx >= win->x - edge && mx <= win->x + edge && my >= win->y + win->h - edge && my <= win->y + win->h + edge;
 			bool overBR = mx >= win->x + win->w - edge && mx <= win->x + win->w + edge && my >= win->y + win->h - edge && my <= win->y + win->h + edge;
 
+#if defined(_WIN32)
 			if (overBL)
 				SetCursor(LoadCursor(NULL, IDC_SIZENESW));
 			else if (overBR)
@@ -363,72 +568,202 @@ namespace NSImgui {
 				SetCursor(LoadCursor(NULL, IDC_SIZENS));
 			else
 				SetCursor(LoadCursor(NULL, IDC_ARROW));
+#else
+			(void)overBL; (void)overBR; (void)overLeft; (void)overRight; (void)overBottom;
+#endif
 		}
 	}
 
-	inline void EndWindow() {
-		GetLayout() = nullptr;
-	}
-
 	// --- Drawing ---
 
+	// Everything drawn during a frame lands here, BeginGUI clears it and EndGUI submits it
+	inline DrawList& GetDrawList() {
+		static DrawList list;
+		return list;
+	}
+
 	inline void DrawRect(float x, float y, float w, float h, float r, float g, float b, float a = 1.0f) {
-		glColor4f(r, g, b, a);
-		glBegin(GL_QUADS);
-		glVertex2f(x, y);
-		glVertex2f(x + w, y);
-		glVertex2f(x + w, y + h);
-		glVertex2f(x, y + h);
-		glEnd();
+		GetDrawList().AddRectFilled(x, y, w, h, PackColor(r, g, b, a));
 	}
 
 	inline void DrawRectOutline(float x, float y, float w, float h, float r, float g, float b) {
-		glColor3f(r, g, b);
-		glBegin(GL_LINE_LOOP);
-		glVertex2f(x, y);
-		glVertex2f(x + w, y);
-		glVertex2f(x + w, y + h);
-		glVertex2f(x, y + h);
-		glEnd();
+		GetDrawList().AddRect(x, y, w, h, PackColor(r, g, b));
+	}
+
+	// --- Clipping ---
+
+	// False when the rect is entirely outside the current clip rect (the window's content area
+	// inside BeginWindow). Widgets that fail it only advance the layout: no ID, no text, no geometry.
+	inline bool IsRectVisible(float x, float y, float w, float h) {
+		ClipRect c = GetDrawList().CurrentClipRect();
+		return x < c.x1 && x + w > c.x0 && y < c.y1 && y + h > c.y0;
+	}
+
+	// Mouse inside the rect and the visible part of it, so scrolled out or clipped widgets can't be hovered
+	inline bool IsMouseOver(float x, float y, float w, float h) {
+		State& s = GetState();
+		float mx = (float)s.mouseX, my = (float)s.mouseY;
+		ClipRect c = GetDrawList().CurrentClipRect();
+		return mx >= x && mx <= x + w && my >= y && my <= y + h && mx >= c.x0 && mx <= c.x1 && my >= c.y0 && my <= c.y1;
+	}
+
+	// Built once, the first time anything asks for it
+	inline FontAtlas& GetFontAtlas() {
+		static FontAtlas atlas;
+		static bool built = false;
+		if (!built) {
+			atlas.Build(font8x8_basic);
+			built = true;
+		}
+		return atlas;
 	}
 
+	inline void SetFontScale(int scale) { GetState().fontScale = scale < 1 ? 1 : scale; }
+	inline float CharWidth() { return 8.0f * GetState().fontScale; }
+	inline float TextWidth(const char* text) { return (float)std::strlen(text) * CharWidth(); }
+
 	inline void DrawChar(float x, float y, char c, float r, float g, float b) {
-		if (c < 32 || c > 127) return;
-		const unsigned char* bitmap = font8x8_basic[c - 32];
-		glColor3f(r, g, b);
-		for (int row = 0; row < 8; ++row) {
-			for (int col = 0; col < 8; ++col) {
-				if (bitmap[row] & (1 << col)) {
-					float px = x + col;
-					float py = y + row;
-					glBegin(GL_QUADS);
-					glVertex2f(px, py);
-					glVertex2f(px + 1, py);
-					glVertex2f(px + 1, py + 1);
-					glVertex2f(px, py + 1);
-					glEnd();
+		char text[2] = { c, 0 };
+		GetDrawList().AddText(x, y, text, PackColor(r, g, b), GetState().fontScale);
+	}
+
+	// For text that changes from frame to frame (values, edit buffers)
+	inline void DrawText(float x, float y, const char* text, float r = 0, float g = 0, float b = 0) {
+		GetDrawList().AddText(x, y, text, PackColor(r, g, b), GetState().fontScale);
+	}
+
+	// --- Text run cache ---
+
+	// Glyph quads of static strings (labels, button captions, titles), built once and replayed
+	// with a copy. Runs not drawn for a while are dropped in EndGUI.
+	struct TextRun {
+		std::string text;
+		int scale;
+		unsigned int lastFrame;
+		std::vector<DrawVert> quads;
+	};
+
+	inline std::unordered_map<unsigned long long, TextRun>& GetTextRunCache() {
+		static std::unordered_map<unsigned long long, TextRun> cache;
+		return cache;
+	}
+
+	constexpr unsigned int TextRunMaxAge = 120; // frames
+
+	inline void DrawTextCached(float x, float y, const char* text, float r = 0, float g = 0, float b = 0) {
+		State& s = GetState();
+		DrawList& dl = GetDrawList();
+		if (!dl.CurrentFont()) return;
+
+		// FNV-1a over the text and scale
+		unsigned long long h = 14695981039346656037ULL;
+		size_t len = 0;
+		for (const char* c = text; *c; ++c, ++len) {
+			h ^= (unsigned char)*c;
+			h *= 1099511628211ULL;
+		}
+		h ^= (unsigned long long)s.fontScale;
+		h *= 1099511628211ULL;
+
+		TextRun& run = GetTextRunCache()[h];
+		if (run.text.size() != len || run.scale != s.fontScale || run.text.compare(0, len, text, len) != 0) {
+			// new, or a hash collision taking the slot over
+			DrawList tmp;
+			tmp.SetFont(dl.CurrentFont());
+			tmp.AddText(0, 0, text, 0, s.fontScale);
+			run.text.assign(text, len);
+			run.scale = s.fontScale;
+			run.quads.swap(tmp.vtx);
+		}
+		run.lastFrame = s.frameCount;
+		if (!run.quads.empty()) dl.AddQuads(&run.quads[0], run.quads.size(), x, y, PackColor(r, g, b));
+	}
+
+	inline void TrimTextRunCache() {
+		State& s = GetState();
+		auto& cache = GetTextRunCache();
+		for (auto it = cache.begin(); it != cache.end(); ) {
+			if (s.frameCount - it->second.lastFrame > TextRunMaxAge) it = cache.erase(it);
+			else ++it;
+		}
+	}
+
+#ifndef NSIMGUI_NO_GL
+	// Uploads the font atlas, once per GL context. Only uses calls core profiles keep, so both backends share it.
+	inline void CreateFontTexture() {
+		FontAtlas& atlas = GetFontAtlas();
+		if (atlas.texture) return;
+		GLuint tex = 0;
+		glGenTextures(1, &tex);
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, FontAtlas::Width, FontAtlas::Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, &atlas.pixels[0]);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		atlas.texture = tex;
+	}
+
+	// Legacy (GL 1.1) backend: client side vertex arrays, one glDrawElements per DrawCmd
+	inline void RenderDrawList(const DrawList& dl, int fbWidth, int fbHeight) {
+		if (dl.idx.empty()) return;
+		const DrawVert* v = &dl.vtx[0];
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_COLOR_ARRAY);
+		glVertexPointer(2, GL_FLOAT, sizeof(DrawVert), &v->x);
+		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(DrawVert), &v->col);
+		glTexCoordPointer(2, GL_FLOAT, sizeof(DrawVert), &v->u);
+		glEnable(GL_SCISSOR_TEST);
+
+		unsigned int boundTexture = 0;
+		for (const DrawCmd& cmd : dl.cmds) {
+			if (!cmd.elemCount) continue;
+			float x0 = NMATH::maxf(cmd.clip.x0, 0.0f), y0 = NMATH::maxf(cmd.clip.y0, 0.0f);
+			float x1 = cmd.clip.x1 < (float)fbWidth ? cmd.clip.x1 : (float)fbWidth;
+			float y1 = cmd.clip.y1 < (float)fbHeight ? cmd.clip.y1 : (float)fbHeight;
+			if (x1 <= x0 || y1 <= y0) continue;
+			glScissor((int)x0, fbHeight - (int)y1, (int)(x1 - x0), (int)(y1 - y0));
+
+			if (cmd.texture != boundTexture) {
+				if (cmd.texture) {
+					glEnable(GL_TEXTURE_2D);
+					glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+					glBindTexture(GL_TEXTURE_2D, cmd.texture);
+				}
+				else {
+					glDisable(GL_TEXTURE_2D);
+					glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 				}
+				boundTexture = cmd.texture;
 			}
+			glDrawElements(GL_TRIANGLES, (GLsizei)cmd.elemCount, GL_UNSIGNED_INT, &dl.idx[cmd.idxOffset]);
 		}
-	}
 
-	inline void DrawText(float x, float y, const char* text, float r = 0, float g = 0, float b = 0) {
-		float cx = x;
-		for (const char* c = text; *c; ++c, cx += 8.0f)
-			DrawChar(cx, y, *c, r, g, b);
+		if (boundTexture) {
+			glDisable(GL_TEXTURE_2D);
+			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		}
+		glDisable(GL_SCISSOR_TEST);
+		glDisableClientState(GL_COLOR_ARRAY);
+		glDisableClientState(GL_VERTEX_ARRAY);
 	}
+#endif
 
 	// --- Widgets ---
 
 	inline bool Button(const char* label, float x, float y, float w, float h) {
+		if (!IsRectVisible(x, y, w, h)) return false;
 		State& s = GetState();
-		int id = ++s.lastWidget;
-		bool hovered = s.mouseX >= x && s.mouseX <= x + w && s.mouseY >= y && s.mouseY <= y + h;
+		WidgetId id = GetID(label);
+		bool hovered = IsMouseOver(x, y, w, h);
 		if (hovered) s.hotItem = id;
 		bool pressed = false;
 
 		if (hovered && s.mousePressed) s.activeItem = id;
-		if (hovered && s.activeItem == id && s.mouseReleased) pressed = true;
+		if (hovered && s.activeItem == id && s.mouseReleased) {
+			pressed = true;
+			RequestRedraw(); // the application reacts next frame
+		}
 
 		// Draw button
 		if (s.activeItem == id && hovered)
@@ -441,17 +776,18 @@ namespace NSImgui {
 		DrawRectOutline(x, y, w, h, 0.2f, 0.2f, 0.3f);
 
 		// Center text
-		float textWidth = (float)std::strlen(label) * 8.0f;
-		DrawText(x + (w - textWidth) / 2, y + h / 2 - 4, label, 0, 0, 0);
+		float textWidth = TextWidth(label);
+		DrawTextCached(x + (w - textWidth) / 2, y + (h - CharWidth()) / 2, label, 0, 0, 0);
 
 		return pressed;
 	}
 
 	inline bool Checkbox(const char* label, bool* value, float x, float y) {
-		State& s = GetState();
-		int id = ++s.lastWidget;
 		float boxSize = 16;
-		bool hovered = s.mouseX >= x && s.mouseX <= x + boxSize && s.mouseY >= y && s.mouseY <= y + boxSize;
+		if (!IsRectVisible(x, y, boxSize + 6 + TextWidth(label), boxSize)) return false;
+		State& s = GetState();
+		WidgetId id = GetID(label);
+		bool hovered = IsMouseOver(x, y, boxSize, boxSize);
 		if (hovered) s.hotItem = id;
 		bool changed = false;
 
@@ -459,6 +795,7 @@ namespace NSImgui {
 		if (hovered && s.activeItem == id && s.mouseReleased) {
 			*value = !*value;
 			changed = true;
+			RequestRedraw();
 		}
 
 		// Draw box
@@ -467,7 +804,7 @@ namespace NSImgui {
 		if (*value) {
 			DrawRect(x + 3, y + 3, boxSize - 6, boxSize - 6, 0.2f, 0.8f, 0.2f);
 		}
-		DrawText(x + boxSize + 6, y + boxSize - 4, label, 0, 0, 0);
+		DrawTextCached(x + boxSize + 6, y + boxSize - 4, label, 0, 0, 0);
 		return changed;
 	}
 
@@ -476,7 +813,7 @@ namespace NSImgui {
 		if (!l) return;
 		float x = l->cursorX + WidgetMargin;
 		float y = l->cursorY;
-		DrawText(x, y + 4, text, 1, 1, 1);
+		if (IsRectVisible(x, y, l->availW, 20)) DrawTextCached(x, y + 4, text, 1, 1, 1);
 		l->cursorY += 20 + l->spacingY;
 	}
 
@@ -488,6 +825,8 @@ namespace NSImgui {
 		float w = l->availW - WidgetMargin;
 		float h = 20.0f;
 		bool changed = false;
+		l->cursorY += h + l->spacingY;
+		if (!IsRectVisible(x, y, w, h)) return false;
 
 		// Draw background
 		DrawRect(x, y, w, h, 0.85f, 0.85f, 0.90f);
@@ -500,23 +839,20 @@ namespace NSImgui {
 
 		// Handle mouse
 		State& s = GetState();
-		int id = ++s.lastWidget;
-		bool hovered = s.mouseX >= x && s.mouseX <= x + w && s.mouseY >= y && s.mouseY <= y + h;
+		WidgetId id = GetID(label);
+		WidgetState& st = GetWidgetState(id);
+		bool hovered = IsMouseOver(x, y, w, h);
 		if (hovered) s.hotItem = id;
-		static bool dragging = false;
-		static int dragId = 0;
-		if (hovered && s.mousePressed) {
-			dragging = true;
-			dragId = id;
-		}
-		if (!s.mouseDown) dragging = false;
-		if (dragging && dragId == id) {
+		if (s.mousePressed) st.dragging = hovered;
+		if (!s.mouseDown) st.dragging = false;
+		if (st.dragging) {
 			float rel = (s.mouseX - x) / (w - 16);
 			rel = NMATH::clamp(rel, 0.0f, 1.0f);
 			float newValue = min + rel * (max - min);
 			if (newValue != *value) {
 				*value = newValue;
 				changed = true;
+				RequestRedraw(); // the handle was drawn at the old value
 			}
 		}
 
@@ -528,7 +864,6 @@ namespace NSImgui {
 		snprintf(buf, sizeof(buf), "%s: %.2f", label, *value);
 		DrawText(x + 8, y + 4, buf, 0, 0, 0);
 
-		l->cursorY += h + l->spacingY;
 		return changed;
 	}
 
@@ -540,29 +875,33 @@ namespace NSImgui {
 		float w = l->availW - WidgetMargin;
 		float h = 20.0f;
 		bool changed = false;
-
-		// Draw background
-		DrawRect(x, y, w, h, 1, 1, 1);
-		DrawRectOutline(x, y, w, h, 0.2f, 0.2f, 0.3f);
+		l->cursorY += h + l->spacingY;
+		if (!IsRectVisible(x, y, w, h)) return false;
 
 		// Handle mouse and keyboard
 		State& s = GetState();
-		int id = ++s.lastWidget;
-		bool hovered = s.mouseX >= x && s.mouseX <= x + w && s.mouseY >= y && s.mouseY <= y + h;
-		static int activeInput = 0;
-		if (hovered && s.mousePressed) activeInput = id;
-		bool active = (activeInput == id);
+		WidgetState& st = GetWidgetState(GetID(label));
+		bool hovered = IsMouseOver(x, y, w, h);
+		if (s.mousePressed) st.focused = hovered;
+		bool active = st.focused;
 
-		// Draw text
+		// Draw background, highlighted while focused
+		DrawRect(x, y, w, h, 1, 1, 1);
+		if (active) DrawRectOutline(x, y, w, h, 0.4f, 0.5f, 0.8f);
+		else DrawRectOutline(x, y, w, h, 0.2f, 0.2f, 0.3f);
+
+		// Draw text, with a caret at its end while focused. It doesn't blink, a
+		// blinking caret would make every frame differ and keep the GUI from idling.
 		DrawText(x + 8, y + 4, buffer, 0, 0, 0);
+		if (active) DrawRect(x + 8 + TextWidth(buffer), y + 3, 1, h - 6, 0, 0, 0);
 
 		// Draw label
-		DrawText(x + w - 8 - 8 * strlen(label), y + 4, label, 0.4f, 0.4f, 0.4f);
+		DrawTextCached(x + w - 8 - TextWidth(label), y + 4, label, 0.4f, 0.4f, 0.4f);
 
 		// (You need to call this from your app's key input handler)
 		// Example: if (active) { ... handle key input, update buffer, set changed = true; }
+		(void)bufsize;
 
-		l->cursorY += h + l->spacingY;
 		return changed;
 	}
 
@@ -583,12 +922,411 @@ namespace NSImgui {
 		return Checkbox(label, value, x, y);
 	}
 
+	// --- Lists and tables ---
+
+	// Row heights of a variable height list, measured as rows get drawn. Rows not drawn yet count
+	// as the estimate. Kept in a Fenwick tree, so the offset of a row and the row at an offset are
+	// O(log n) however long the list is. Doubles, floats run out of precision past a few 100k rows.
+	struct RowHeightCache {
+		unsigned int lastFrame = 0;
+		std::vector<float> heights;
+		std::vector<double> tree; // 1 based
+
+		void Reset(int count, float estimate) {
+			heights.assign(count, estimate);
+			tree.assign(count + 1, 0.0);
+			for (int i = 1; i <= count; i++) {
+				tree[i] += estimate;
+				int parent = i + (i & -i);
+				if (parent <= count) tree[parent] += tree[i];
+			}
+		}
+
+		void Set(int row, float h) {
+			double delta = (double)h - heights[row];
+			if (delta == 0) return;
+			heights[row] = h;
+			for (int i = row + 1; i < (int)tree.size(); i += i & -i) tree[i] += delta;
+		}
+
+		// Sum of the heights of rows before row
+		double Offset(int row) const {
+			double sum = 0;
+			for (int i = row; i > 0; i -= i & -i) sum += tree[i];
+			return sum;
+		}
+
+		// The row containing offset y (clamped to the list)
+		int Find(double y) const {
+			int n = (int)tree.size() - 1, pos = 0;
+			int step = 1;
+			while (step * 2 <= n) step *= 2;
+			for (; step; step >>= 1) {
+				if (pos + step <= n && tree[pos + step] <= y) {
+					pos += step;
+					y -= tree[pos];
+				}
+			}
+			return pos < n ? pos : (n > 0 ? n - 1 : 0);
+		}
+
+		double Total() const { return Offset((int)tree.size() - 1); }
+	};
+
+	inline std::unordered_map<WidgetId, RowHeightCache>& GetRowHeightCaches() {
+		static std::unordered_map<WidgetId, RowHeightCache> caches;
+		return caches;
+	}
+
+	// Submits only the rows of a long list that intersect the visible region and moves the layout
+	// cursor past the whole list, so the window scrolls over all of it. The rows are expected to
+	// advance the layout by itemHeight each (fixed), or are measured (cached heights).
+	//
+	//	NSImgui::ListClipper clip((int)lines.size());		// Label rows
+	//	for (int i; clip.Next(i); )
+	//		NSImgui::Label(lines[i]);
+	class ListClipper {
+	public:
+		int displayStart = 0, displayEnd = 0; // rows submitted this frame, valid once Next returned false
+
+		// Rows of a fixed height, -1 for the height of a Label
+		ListClipper(int itemCount, float itemHeight = -1) : count(itemCount), height(itemHeight) {}
+
+		// Rows of differing heights, cached per id and measured as they are drawn
+		ListClipper(const char* id, int itemCount, float estimatedHeight = -1) : count(itemCount), height(estimatedHeight) {
+			State& s = GetState();
+			WidgetId key = GetID(id);
+			RetainInWindowCache(key);
+			cache = &GetRowHeightCaches()[key];
+			cache->lastFrame = s.frameCount;
+		}
+
+		// Gives the next row to submit, false once the visible ones are done
+		bool Next(int& row) {
+			Layout* l = GetLayout();
+			if (!l || done) return false;
+			if (current < 0) {
+				Start(l);
+			}
+			else if (cache) {
+				cache->Set(current, l->cursorY - rowTop);
+				current++;
+				rowTop = l->cursorY;
+			}
+			else {
+				current++;
+				l->cursorY = startY + current * height;
+			}
+			bool more = current < count && (cache ? rowTop < clipY1 : current < displayEnd);
+			if (!more) {
+				displayEnd = current > displayStart ? current : displayStart;
+				l->cursorY = startY + (float)(cache ? cache->Total() : (double)count * height);
+				done = true;
+				return false;
+			}
+			row = current;
+			return true;
+		}
+
+	private:
+		int count;
+		float height;
+		RowHeightCache* cache = nullptr;
+		int current = -1;
+		bool done = false;
+		float startY = 0, rowTop = 0, clipY1 = 0;
+
+		void Start(Layout* l) {
+			if (height <= 0) height = 20 + l->spacingY;
+			startY = l->cursorY;
+			ClipRect clip = GetDrawList().CurrentClipRect();
+			clipY1 = clip.y1;
+			float top = clip.y0 - startY, bottom = clip.y1 - startY;
+			if (cache) {
+				if ((int)cache->heights.size() != count) cache->Reset(count, height);
+				displayStart = count > 0 && top > 0 ? cache->Find(top) : 0;
+				rowTop = startY + (float)cache->Offset(displayStart);
+				l->cursorY = rowTop;
+			}
+			else {
+				displayStart = top > 0 ? (int)(top / height) : 0;
+				displayEnd = bottom > 0 ? (int)(bottom / height) + 1 : 0;
+				if (displayStart > count) displayStart = count;
+				if (displayEnd > count) displayEnd = count;
+				l->cursorY = startY + displayStart * height;
+			}
+			current = displayStart;
+		}
+	};
+
+	// Text of one cell, buf is scratch space the callback may format into
+	typedef const char* (*TableCellFn)(void* user, int row, int column, char* buf, size_t size);
+	// Orders two rows (data indices) by a column, negative, zero or positive like strcmp
+	typedef int (*TableCompareFn)(void* user, int a, int b, int column);
+
+	struct TableColumn {
+		const char* name;
+		float width = 0; // pixels, 0 shares what's left equally
+		bool sortable = true;
+
+		TableColumn(const char* n, float w = 0, bool canSort = true) : name(n), width(w), sortable(canSort) {}
+	};
+
+	constexpr float TableRowHeight = 18.0f;
+
+	// Display order of a table's rows as indices into the caller's data, which is never copied
+	struct TableState {
+		unsigned int lastFrame = 0;
+		int sortColumn = -1;
+		bool ascending = true;
+		int selected = -1; // data index
+		std::vector<int> order;
+	};
+
+	inline std::unordered_map<WidgetId, TableState>& GetTableStates() {
+		static std::unordered_map<WidgetId, TableState> states;
+		return states;
+	}
+
+	// Brings order up to rowCount rows, sorted by the current column. Rows appended since last
+	// frame (a growing log) are sorted on their own and merged in, the rest isn't resorted.
+	inline void UpdateTableOrder(TableState& t, int rowCount, TableCompareFn compare, void* user, bool resort) {
+		int old = (int)t.order.size();
+		if (rowCount < old) {
+			t.order.clear();
+			old = 0;
+			resort = true;
+		}
+		for (int i = old; i < rowCount; i++) t.order.push_back(i);
+		if (t.sortColumn < 0 || !compare) {
+			if (resort) for (int i = 0; i < rowCount; i++) t.order[i] = i;
+			return;
+		}
+		int col = t.sortColumn;
+		bool asc = t.ascending;
+		auto less = [=](int a, int b) {
+			int c = compare(user, a, b, col);
+			if (c == 0) return a < b; // stable, equal keys keep data order
+			return asc ? c < 0 : c > 0;
+		};
+		if (resort) {
+			std::sort(t.order.begin(), t.order.end(), less);
+		}
+		else if (rowCount > old) {
+			std::sort(t.order.begin() + old, t.order.end(), less);
+			std::inplace_merge(t.order.begin(), t.order.begin() + old, t.order.end(), less);
+		}
+	}
+
+	// A table with a header row, clicking a sortable header sorts by it (again to flip). Only the
+	// visible rows are asked for their cells, so it stays cheap with hundreds of thousands of rows.
+	// Cells are cut to their column width. Returns the data index of the row clicked this frame,
+	// or -1.
+	inline int Table(const char* label, const TableColumn* columns, int columnCount, int rowCount,
+		TableCellFn cell, TableCompareFn compare = nullptr, void* user = nullptr) {
+		Layout* l = GetLayout();
+		if (!l || columnCount <= 0) return -1;
+		State& s = GetState();
+		WidgetId id = GetID(label);
+		RetainInWindowCache(id);
+		TableState& t = GetTableStates()[id];
+		t.lastFrame = s.frameCount;
+
+		float x = l->cursorX + WidgetMargin;
+		float w = l->availW - WidgetMargin;
+		float colX[64], colW[64];
+		if (columnCount > 64) columnCount = 64;
+		float fixed = 0;
+		int flexible = 0;
+		for (int c = 0; c < columnCount; c++) {
+			if (columns[c].width > 0) fixed += columns[c].width;
+			else flexible++;
+		}
+		float share = flexible ? NMATH::maxf(0.0f, w - fixed) / flexible : 0;
+		for (int c = 0, cx = 0; c < columnCount; c++) {
+			colX[c] = x + cx;
+			colW[c] = columns[c].width > 0 ? columns[c].width : share;
+			cx += (int)colW[c];
+		}
+
+		// Header, stuck to the top of the visible region while the rows scroll under it
+		float headerY = l->cursorY;
+		float headerH = TableRowHeight + 4;
+		ClipRect clip = GetDrawList().CurrentClipRect();
+		float tableBottom = headerY + headerH + rowCount * TableRowHeight;
+		float stickyY = NMATH::clamp(clip.y0, headerY, tableBottom - headerH);
+		bool resort = false;
+		for (int c = 0; c < columnCount; c++) {
+			if (columns[c].sortable && compare && s.mousePressed && IsMouseOver(colX[c], stickyY, colW[c], headerH)) {
+				if (t.sortColumn == c) t.ascending = !t.ascending;
+				else {
+					t.sortColumn = c;
+					t.ascending = true;
+				}
+				resort = true;
+			}
+		}
+		UpdateTableOrder(t, rowCount, compare, user, resort);
+
+		// Rows
+		l->cursorY = headerY + headerH;
+		int clicked = -1;
+		char buf[256], text[256];
+		ListClipper clipper(rowCount, TableRowHeight);
+		for (int i; clipper.Next(i); ) {
+			float y = l->cursorY;
+			int row = t.order[i];
+			bool hovered = IsMouseOver(x, y, w, TableRowHeight) && !IsMouseOver(x, stickyY, w, headerH);
+			if (hovered && s.mousePressed) {
+				t.selected = row;
+				clicked = row;
+				RequestRedraw();
+			}
+			if (row == t.selected) DrawRect(x, y, w, TableRowHeight, 0.35f, 0.42f, 0.6f);
+			else if (hovered) DrawRect(x, y, w, TableRowHeight, 0.36f, 0.36f, 0.38f);
+			else if (i & 1) DrawRect(x, y, w, TableRowHeight, 0.33f, 0.33f, 0.33f);
+			for (int c = 0; c < columnCount; c++) {
+				const char* str = cell(user, row, c, buf, sizeof(buf));
+				if (!str) continue;
+				size_t maxChars = (size_t)NMATH::maxf(0.0f, (colW[c] - 8) / CharWidth());
+				if (maxChars >= sizeof(text)) maxChars = sizeof(text) - 1;
+				size_t n = 0;
+				while (n < maxChars && str[n]) n++;
+				std::memcpy(text, str, n);
+				text[n] = 0;
+				DrawText(colX[c] + 4, y + (TableRowHeight - CharWidth()) / 2, text, 1, 1, 1);
+			}
+		}
+
+		if (IsRectVisible(x, stickyY, w, headerH)) {
+			DrawRect(x, stickyY, w, headerH, 0.2f, 0.2f, 0.24f);
+			for (int c = 0; c < columnCount; c++) {
+				DrawTextCached(colX[c] + 4, stickyY + (headerH - CharWidth()) / 2, columns[c].name, 1, 1, 1);
+				if (c == t.sortColumn)
+					DrawText(colX[c] + colW[c] - 4 - CharWidth(), stickyY + (headerH - CharWidth()) / 2, t.ascending ? "^" : "v", 0.7f, 0.8f, 1.0f);
+				if (c > 0) DrawRect(colX[c], stickyY, 1, headerH, 0.35f, 0.35f, 0.4f);
+			}
+		}
+
+		l->cursorY = tableBottom + l->spacingY;
+		return clicked;
+	}
+
+	inline void TrimListStates() {
+		State& s = GetState();
+		auto& caches = GetRowHeightCaches();
+		for (auto it = caches.begin(); it != caches.end(); ) {
+			if (s.frameCount - it->second.lastFrame > WidgetStateMaxAge) it = caches.erase(it);
+			else ++it;
+		}
+		auto& tables = GetTableStates();
+		for (auto it = tables.begin(); it != tables.end(); ) {
+			if (s.frameCount - it->second.lastFrame > WidgetStateMaxAge) it = tables.erase(it);
+			else ++it;
+		}
+	}
+
 	// --- GUI frame management ---
 
 	// Call before drawing GUI widgets
 	inline void BeginGUI(int fbWidth, int fbHeight) {
+#ifndef NSIMGUI_NO_GL
+		CreateFontTexture();
+#endif
+		DrawList& dl = GetDrawList();
+		dl.Clear();
+		dl.PushClipRect(0, 0, (float)fbWidth, (float)fbHeight, false);
+		dl.SetFont(&GetFontAtlas());
+		dl.SetTexture(GetFontAtlas().texture);
+		State& s = GetState();
+		s.fbWidth = fbWidth;
+		s.fbHeight = fbHeight;
+
+		// Topmost window under the mouse among those shown last frame, it gets the wheel
+		WindowPool& pool = GetWindowPool();
+		s.hoveredWindow = -1;
+		for (size_t i = pool.zOrder.size(); i-- > 0; ) {
+			WindowState& w = pool[pool.zOrder[i]];
+			if (!w.open || w.lastFrame + 1 != s.frameCount) continue;
+			if (s.mouseX >= w.x && s.mouseX <= w.x + w.w && s.mouseY >= w.y && s.mouseY <= w.y + w.h) {
+				s.hoveredWindow = w.slot;
+				break;
+			}
+		}
+	}
+
+	// --- Idle frames ---
+
+	// Whether the frame just finished differs from the one before: anything drawn differently
+	// (hover highlights, moved windows, edited values, scrolling), a new hot or active item, or
+	// RequestRedraw(0). An unchanged frame doesn't need to be rendered or swapped.
+	inline bool FrameChanged() { return GetState().frameChanged; }
+
+	// Seconds the application can block waiting for input before the next frame is due,
+	// 0 when it is due now (the last frame changed, things may still be settling), -1 when only
+	// input can change anything.
+	inline double IdleTimeout() {
+		State& s = GetState();
+		if (s.frameChanged) return 0;
+		if (s.redrawAt < 0) return -1;
+		double left = s.redrawAt - GetTime();
+		return left > 0 ? left : 0;
+	}
+
+	// Loop head for applications that shouldn't spin while idle. Blocks on the window's events
+	// until input arrives or the GUI wants a frame, at most maxIdleSeconds (-1 for no limit),
+	// and returns whether input arrived. When a frame is already due it only polls, and the
+	// result says whether there was input queued. Window is anything with
+	// waitEvents(seconds) that dispatches pending input and returns false on timeout, 0 only
+	// polling, such as NSWindow::Window.
+	//
+	//	while (!window.shouldClose()) {
+	//		NSImgui::WaitForNextFrame(window);
+	//		...NewFrame, BeginGUI, widgets, EndFrame...
+	//		NSImgui::FinishGUI();
+	//		if (NSImgui::FrameChanged() || sceneChanged) { ...clear, NSImgui::RenderGUI(), swap... }
+	//	}
+	template <class Window>
+	inline bool WaitForNextFrame(Window& window, double maxIdleSeconds = -1) {
+		double timeout = IdleTimeout();
+		if (maxIdleSeconds >= 0 && (timeout < 0 || timeout > maxIdleSeconds)) timeout = maxIdleSeconds;
+		return window.waitEvents(timeout);
+	}
+
+	// Ends the frame without rendering it: drops stale retained state and works out FrameChanged.
+	// Follow with RenderGUI when the frame is to be shown.
+	inline void FinishGUI() {
+		State& s = GetState();
+		TrimTextRunCache();
+		TrimWidgetStates();
+		TrimListStates();
+
+		// What was drawn, and window state changed after drawing (moves and resizes land in EndFrame)
+		unsigned long long hash = GetDrawList().HashSince(0, 0);
+		WindowPool& pool = GetWindowPool();
+		for (const WindowState& w : pool.slots) {
+			float rect[5] = { w.x, w.y, w.w, w.h, w.scrollY };
+			hash ^= HashId(rect, sizeof(rect), HashId(&w.open, sizeof(w.open), w.id));
+			hash *= 1099511628211ull;
+		}
+		hash ^= HashId(pool.zOrder.data(), pool.zOrder.size() * sizeof(int), (WidgetId)s.selectedWindow);
+		hash *= 1099511628211ull;
+		s.frameChanged = hash != s.frameHash || s.hotItem != s.prevHotItem || s.activeItem != s.prevActiveItem || s.redrawIn == 0;
+		s.frameHash = hash;
+		s.prevHotItem = s.hotItem;
+		s.prevActiveItem = s.activeItem;
+		s.redrawAt = s.redrawIn < 0 ? -1 : GetTime() + s.redrawIn;
+	}
+
+	// Submits the frame's draw list through the backend compiled in
+	inline void RenderGUI() {
+#if defined(NSIMGUI_GL3) && !defined(NSIMGUI_NO_GL)
+		RenderDrawListGL3(GetDrawList(), GetState().fbWidth, GetState().fbHeight);
+#elif !defined(NSIMGUI_NO_GL)
+		int fbWidth = GetState().fbWidth, fbHeight = GetState().fbHeight;
 		glEnable(GL_BLEND);
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDisable(GL_DEPTH_TEST);
 		glMatrixMode(GL_PROJECTION);
 		glPushMatrix();
 		glLoadIdentity();
@@ -596,17 +1334,22 @@ namespace NSImgui {
 		glMatrixMode(GL_MODELVIEW);
 		glPushMatrix();
 		glLoadIdentity();
-		glDisable(GL_DEPTH_TEST);
-	}
 
-	// Call after drawing GUI widgets
-	inline void EndGUI() {
+		RenderDrawList(GetDrawList(), fbWidth, fbHeight);
+
 		glDisable(GL_BLEND);
 		glEnable(GL_DEPTH_TEST);
 		glMatrixMode(GL_MODELVIEW);
 		glPopMatrix();
 		glMatrixMode(GL_PROJECTION);
 		glPopMatrix();
+#endif
+	}
+
+	// Call after drawing GUI widgets, submits the frame's draw list
+	inline void EndGUI() {
+		FinishGUI();
+		RenderGUI();
 	}
 
 	// --- Docking system ---
@@ -775,8 +1518,7 @@ namespace NSImgui {
 
 	// Layout all top-level windows (global area)
 	inline void LayoutGlobalDockedWindows(float gx, float gy, float gw, float gh) {
-		auto& windows = GetWindows();
-		for (auto& win : windows) {
+		for (auto& win : GetWindowPool().slots) {
 			if (!win.open) continue;
 			if (!win.dockParent && win.dockedTo != -1) {
 				// Layout based on dockedTo
@@ -832,9 +1574,10 @@ namespace NSImgui {
 			drag.hoveredGlobal = false;
 			drag.dockHoverTarget = -1;
 
-			// Check all windows for dock targets
-			auto& windows = GetWindows();
-			for (auto& win : windows) {
+			// Check all windows for dock targets, back to front so the topmost hovered one wins
+			WindowPool& pool = GetWindowPool();
+			for (int slot : pool.zOrder) {
+				WindowState& win = pool[slot];
 				if (!win.open || &win == drag.draggingWindow) continue;
 				int hovered = DrawDockTargets(&win, mx, my, cubes);
 				if (hovered != -1) {
@@ -896,28 +1639,22 @@ namespace NSImgui {
 	inline bool BeginWindow(const char* title, float x, float y, float w, float h, float alpha, bool* pOpen = nullptr) {
 		State& s = GetState();
 		DockDragState& drag = GetDockDragState();
-		auto& windows = GetWindows();
 		WindowState* win = CreateOrGetWindow(title, x, y, w, h);
 		if (!win->open) return false;
 		if (pOpen) *pOpen = win->open;
+		win->drawVtxStart = GetDrawList().VertexCount();
+		win->drawIdxStart = GetDrawList().IndexCount();
 
 		float mx = (float)s.mouseX, my = (float)s.mouseY;
 		bool titleHovered = mx >= win->x && mx <= win->x + win->w && my >= win->y && my <= win->y + 24;
 		bool resizeHovered = mx >= win->x + win->w - 12 && mx <= win->x + win->w && my >= win->y + win->h - 12 && my <= win->y + win->h;
 		bool closeHovered = mx >= win->x + win->w - 24 && mx <= win->x + win->w - 8 && my >= win->y + 4 && my <= win->y + 20;
 
-		int winIdx = GetWindowIndex(win);
+		int winIdx = win->slot;
 
 		bool insideWindow = mx >= win->x && mx <= win->x + win->w && my >= win->y && my <= win->y + win->h;
 		if (insideWindow && s.mousePressed && !closeHovered && !resizeHovered) {
-			// Bring to front and select
-			if (winIdx != (int)windows.size() - 1) {
-				WindowState temp = *win;
-				windows.erase(windows.begin() + winIdx);
-				windows.push_back(temp);
-				win = &windows.back();
-				winIdx = (int)windows.size() - 1;
-			}
+			BringWindowToFront(win);
 			s.selectedWindow = winIdx;
 		}
 
@@ -926,8 +1663,8 @@ namespace NSImgui {
 			drag.active = true;
 			drag.dragOffsetX = mx - win->x;
 			drag.dragOffsetY = my - win->y;
-			for (size_t i = 0; i < windows.size(); ++i)
-				windows[i].moving = false;
+			for (auto& other : GetWindowPool().slots)
+				other.moving = false;
 			win->moving = true;
 			win->moveOffsetX = mx - win->x;
 			win->moveOffsetY = my - win->y;
@@ -961,23 +1698,146 @@ namespace NSImgui {
 		float barShade = (s.selectedWindow == winIdx) ? 0.07f : 0.13f;
 		DrawRect(win->x, win->y, win->w, 24, barShade, barShade, barShade);
 		DrawRectOutline(win->x, win->y, win->w, 24, 0.2f, 0.2f, 0.3f);
-		DrawText(win->x + 8, win->y + 8, title, 1, 1, 1);
+		DrawTextCached(win->x + 8, win->y + 8, title, 1, 1, 1);
 
 		// Draw close button
 		DrawRect(win->x + win->w - 24, win->y + 4, 16, 16, closeHovered ? 0.8f : 0.7f, 0.3f, 0.3f);
 		DrawRectOutline(win->x + win->w - 24, win->y + 4, 16, 16, 0.2f, 0.2f, 0.3f);
-		DrawText(win->x + win->w - 20, win->y + 8, "X", 1, 1, 1);
+		DrawTextCached(win->x + win->w - 20, win->y + 8, "X", 1, 1, 1);
+
+		// Scrolling, against the content height measured last frame
+		win->lastFrame = s.frameCount;
+		float viewY = win->y + TitleBarHeight, viewH = win->h - TitleBarHeight;
+		float maxScroll = NMATH::maxf(0.0f, ContentPadding + win->contentH - win->h);
+		if (s.mouseWheel != 0 && s.hoveredWindow == win->slot) win->scrollY -= s.mouseWheel * ScrollStep;
+		if (maxScroll > 0) {
+			// Scrollbar, the thumb follows the mouse while dragged
+			float trackX = win->x + win->w - ScrollbarWidth - 6, trackH = viewH - 4;
+			float thumbH = NMATH::maxf(16.0f, trackH * viewH / (viewH + maxScroll));
+			WidgetState& st = GetWidgetState(HashId("#scroll", 7, win->id));
+			if (s.mousePressed) st.dragging = mx >= trackX && mx <= trackX + ScrollbarWidth && my >= viewY && my <= viewY + trackH;
+			if (!s.mouseDown) st.dragging = false;
+			if (st.dragging) win->scrollY = (my - viewY - thumbH / 2) / (trackH - thumbH) * maxScroll;
+			win->scrollY = NMATH::clamp(win->scrollY, 0.0f, maxScroll);
+			float thumbY = viewY + 2 + (trackH - thumbH) * win->scrollY / maxScroll;
+			DrawRect(trackX, viewY + 2, ScrollbarWidth, trackH, 0.22f, 0.22f, 0.22f, alpha);
+			DrawRect(trackX, thumbY, ScrollbarWidth, thumbH, st.dragging ? 0.6f : 0.5f, st.dragging ? 0.6f : 0.5f, st.dragging ? 0.7f : 0.55f);
+		}
+		else {
+			win->scrollY = 0;
+		}
 
 		static Layout layout;
 		layout.win = win;
 		layout.startX = win->x + 8;
-		layout.startY = win->y + 32;
+		layout.startY = win->y + ContentPadding - win->scrollY;
 		layout.cursorX = layout.startX;
 		layout.cursorY = layout.startY;
-		layout.availW = win->w - 16;
+		layout.availW = win->w - 16 - (maxScroll > 0 ? ScrollbarWidth + 6 : 0);
 		layout.spacingY = 8;
 		GetLayout() = &layout;
+		// Widgets are clipped to the content area, and culled when entirely outside it
+		GetDrawList().PushClipRect(win->x, viewY, win->w, viewH);
+		PushID(win->id);
+
+		return true;
+	}
+
+	inline void EndWindow() {
+		Layout* l = GetLayout();
+		GetLayout() = nullptr;
+		GetDrawList().PopClipRect();
+		PopID();
+		if (!l) return;
+		WindowState* win = l->win;
+		win->contentH = l->cursorY - l->startY;
+
+		// A cached window drawn while nothing interacted with it becomes replayable. Most frames
+		// produce what the cache already has, then the hash saves copying it again.
+		WindowCache& c = win->cache;
+		if (c.enabled && c.valid) {
+			DrawList& dl = GetDrawList();
+			unsigned long long hash = dl.HashSince(win->drawVtxStart, win->drawIdxStart);
+			if (hash != c.hash) {
+				dl.Capture(win->drawVtxStart, win->drawIdxStart, c.draw);
+				c.hash = hash;
+			}
+		}
+	}
 
+	inline void TouchRetainedStates(const std::vector<WidgetId>& ids) {
+		unsigned int frame = GetState().frameCount;
+		auto& widgets = GetWidgetStates();
+		auto& caches = GetRowHeightCaches();
+		auto& tables = GetTableStates();
+		for (WidgetId id : ids) {
+			auto w = widgets.find(id);
+			if (w != widgets.end()) w->second.lastFrame = frame;
+			auto c = caches.find(id);
+			if (c != caches.end()) c->second.lastFrame = frame;
+			auto t = tables.find(id);
+			if (t != tables.end()) t->second.lastFrame = frame;
+		}
+	}
+
+	// BeginWindow for panels that are mostly idle. While the mouse is elsewhere, the window isn't
+	// moving or being resized, and version is what it was last frame, the window's draw output
+	// from an earlier frame is replayed and this returns false, so the caller skips its widgets
+	// like for a closed window (pOpen tells the two apart). Otherwise the window is drawn as
+	// usual, pair it with EndWindow.
+	//
+	// version is any number the application changes when what the window shows changes, a
+	// counter bumped on edits or a hash of the data. Output that changes by itself (timers,
+	// animations) needs a new version every frame, or BeginWindow.
+	inline bool BeginCachedWindow(const char* title, float x, float y, float w, float h, float alpha, unsigned int version, bool* pOpen = nullptr) {
+		State& s = GetState();
+		WindowState* win = CreateOrGetWindow(title, x, y, w, h);
+		WindowCache& c = win->cache;
+		c.enabled = true;
+		if (!win->open) return BeginWindow(title, x, y, w, h, alpha, pOpen);
+
+		DockDragState& drag = GetDockDragState();
+		bool selected = s.selectedWindow == win->slot;
+		float mx = (float)s.mouseX, my = (float)s.mouseY;
+		bool mouseInside = mx >= win->x && mx <= win->x + win->w && my >= win->y && my <= win->y + win->h;
+		bool quiet = !mouseInside && !win->moving && !win->resizing && !(drag.active && drag.draggingWindow == win) &&
+			!(s.mouseDown && selected);
+		bool same = c.valid && c.version == version && c.alpha == alpha && c.selected == selected && c.fontScale == s.fontScale &&
+			c.texture == GetDrawList().CurrentTexture() && c.fbWidth == s.fbWidth && c.fbHeight == s.fbHeight &&
+			c.x == win->x && c.y == win->y && c.w == win->w && c.h == win->h;
+
+		if (quiet && same) {
+			if (pOpen) *pOpen = true;
+			win->lastFrame = s.frameCount;
+			win->drawVtxStart = GetDrawList().VertexCount();
+			win->drawIdxStart = GetDrawList().IndexCount();
+			GetDrawList().Replay(c.draw);
+			TouchRetainedStates(c.retained);
+			c.replayed++;
+			return false;
+		}
+
+		c.replayed = 0;
+		c.retained.clear();
+		if (!BeginWindow(title, x, y, w, h, alpha, pOpen)) {
+			c.valid = false;
+			return false;
+		}
+		// Keyed by the rect as drawn, BeginWindow may have just moved or resized it
+		c.valid = quiet;
+		if (quiet) {
+			c.version = version;
+			c.alpha = alpha;
+			c.selected = s.selectedWindow == win->slot;
+			c.fontScale = s.fontScale;
+			c.texture = GetDrawList().CurrentTexture();
+			c.fbWidth = s.fbWidth;
+			c.fbHeight = s.fbHeight;
+			c.x = win->x;
+			c.y = win->y;
+			c.w = win->w;
+			c.h = win->h;
+		}
 		return true;
 	}
 
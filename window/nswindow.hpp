@@ -56,13 +56,26 @@ namespace NSWindow {
 		bool resizable = true;
 		bool fullscreen = false;
 		bool borderless = false;
+
+		// OpenGL context version, 0 takes whatever wglCreateContext gives (a compatibility context).
+		// Anything else is requested through WGL_ARB_create_context, glCoreProfile drops the
+		// fixed function pipeline.
+		int glMajor = 0;
+		int glMinor = 0;
+		bool glCoreProfile = false;
 	};
 
 	class Window {
 	public:
 		Window(const WindowDesc& desc) {
 			impl = new Impl(desc);
-			impl->createGLContext();
+			try {
+				impl->createGLContext(desc);
+			}
+			catch (...) {
+				delete impl;
+				throw;
+			}
 		}
 
 		~Window() {
@@ -70,6 +83,9 @@ namespace NSWindow {
 		}
 		
 		void pollEvents() { impl->pollEvents(); }
+		// Blocks until input arrives or timeoutSeconds pass (negative waits forever, 0 only
+		// polls), then dispatches it like pollEvents. Returns false on timeout.
+		bool waitEvents(double timeoutSeconds = -1) { return impl->waitEvents(timeoutSeconds); }
 
 		bool shouldClose() const { return impl->shouldClose; }
 
@@ -90,6 +106,8 @@ namespace NSWindow {
 
 		bool mouseButtonDown(int button) const { return impl->mouseButtonDown(button); }
 		void getMousePosition(int& x, int& y) const { impl->getMousePosition(x, y); }
+		// Wheel notches since the last call, positive away from the user
+		int getMouseWheel() { return impl->getMouseWheel(); }
 
 		void showCursor(bool show) { impl->showCursor(show); }
 		void setCursorPos(int x, int y) { impl->setCursorPos(x, y); }
@@ -127,6 +145,7 @@ namespace NSWindow {
 #ifdef NSWINDOW_IMPL_OPENGL
 			typedef BOOL(WINAPI* PFNWGLSWAPINTERVALEXTPROC)(int);
 			PFNWGLSWAPINTERVALEXTPROC wglSwapIntervalEXT = nullptr;
+			typedef HGLRC(WINAPI* PFNWGLCREATECONTEXTATTRIBSARBPROC)(HDC, HGLRC, const int*);
 #endif
 
 			static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
@@ -277,6 +296,14 @@ namespace NSWindow {
 				}
 			}
 
+			bool waitEvents(double timeoutSeconds) {
+				DWORD ms = timeoutSeconds < 0 ? INFINITE : (DWORD)(timeoutSeconds * 1000.0 + 0.5);
+				// MWMO_INPUTAVAILABLE also wakes for messages already queued but not yet removed
+				DWORD r = MsgWaitForMultipleObjectsEx(0, nullptr, ms, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+				pollEvents();
+				return r != WAIT_TIMEOUT;
+			}
+
 			bool pollEvent(Event& e) {
 				if (eventQueue.empty()) return false;
 				e = eventQueue.front();
@@ -319,6 +346,12 @@ namespace NSWindow {
 			void showCursor(bool show) { ShowCursor(show); }
 			void setCursorPos(int x, int y) { POINT pt = { x, y }; ClientToScreen(hwnd, &pt); SetCursorPos(pt.x, pt.y); }
 
+			int getMouseWheel() {
+				int w = mouseWheel;
+				mouseWheel = 0;
+				return w;
+			}
+
 			void getMousePosition(int& x, int& y) const {
 				x = mouseX;
 				y = mouseY;
@@ -345,7 +378,7 @@ namespace NSWindow {
 				}
 			}
 
-			void createGLContext() {
+			void createGLContext(const WindowDesc& desc) {
 				hdc = GetDC(hwnd);
 
 				PIXELFORMATDESCRIPTOR pfd = {};
@@ -364,6 +397,27 @@ namespace NSWindow {
 				hglrc = wglCreateContext(hdc);
 				wglMakeCurrent(hdc, hglrc);
 
+				// wglCreateContextAttribsARB can only be fetched with a context current, so the
+				// legacy one above is swapped for the requested version
+				if (desc.glMajor > 0) {
+					auto createContextAttribs = (PFNWGLCREATECONTEXTATTRIBSARBPROC)wglGetProcAddress("wglCreateContextAttribsARB");
+					const int attribs[] = {
+						0x2091, desc.glMajor,	// WGL_CONTEXT_MAJOR_VERSION_ARB
+						0x2092, desc.glMinor,	// WGL_CONTEXT_MINOR_VERSION_ARB
+						0x9126, desc.glCoreProfile ? 0x1 : 0x2,	// WGL_CONTEXT_PROFILE_MASK_ARB: core / compatibility
+						0
+					};
+					HGLRC modern = createContextAttribs ? createContextAttribs(hdc, nullptr, attribs) : nullptr;
+					if (!modern) {
+						destroyGLContext();
+						throw std::runtime_error("[NSWindow] Failed to create the requested OpenGL context");
+					}
+					wglMakeCurrent(nullptr, nullptr);
+					wglDeleteContext(hglrc);
+					hglrc = modern;
+					wglMakeCurrent(hdc, hglrc);
+				}
+
 				wglSwapIntervalEXT = nullptr;
 			}
 